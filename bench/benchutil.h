@@ -0,0 +1,44 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "geometry.h"
+
+// NOTE: What the benchmarks that measure loaded meshes without GL have in common: keeping the
+//       loader's report out of their tables, and the command line of one or more OBJ files
+
+// The loader reports every load on cout, which would drown out the results
+class SilenceCout
+{
+public:
+    SilenceCout() : saved(std::cout.rdbuf(discard.rdbuf())) {}
+    ~SilenceCout() { std::cout.rdbuf(saved); }
+
+private:
+    std::ostringstream discard;
+    std::streambuf* saved;
+};
+
+// Loads the mesh without the loader's report, returning false if there is nothing to measure
+// (the file couldn't be loaded or has no triangles)
+inline bool loadQuietly(const std::string& path, GeometryData& geometry)
+{
+    SilenceCout silence;
+    return geometry.loadFromOBJFile(path) && (geometry.indexCount() > 0);
+}
+
+// Prints the usage and returns false if no meshes were given
+inline bool checkMeshArguments(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cout << "usage: " << argv[0] << " file.obj [file.obj ...]" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include <math.h>
+#include <stdio.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace std;
+
+#include "geometry.h"
+#include "benchutil.h"
+#include "meshoptimize.h"
+#include "meshlets.h"
+#include "meshcull.h"
+
+// NOTE: Culls the meshlets of every mesh given on the command line from a ring of cameras around it,
+//       some far enough out to see all of it and some close enough in that parts are off screen, and
+//       reports the time per cull and per meshlet, and the fraction of triangles rejected by the
+//       frustum alone and by the frustum and normal cones together. The results are checked against a
+//       plain one meshlet at a time loop, which is also timed for comparison. Build with
+//       SIMDFLAGS=-mavx for the AVX path
+
+static const int cameraCount = 64;
+
+int main(int argc, char** argv)
+{
+    if(!checkMeshArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    printf("Culling with %s\n", meshletCullPath());
+    printf("%-28s %9s %9s %10s %10s %10s %9s %9s\n", "mesh", "meshlets", "cull us", "ns/meshlet",
+           "ref us", "mismatches", "frustum", "+cones");
+    for(int i=1; i<argc; i++)
+    {
+        GeometryData geometry;
+        if(!loadQuietly(argv[i], geometry))
+        {
+            continue;
+        }
+        size_t indexCount = geometry.indexCount();
+
+        vector<unsigned int> indices((unsigned int*)geometry.indexData(), (unsigned int*)geometry.indexData() + indexCount);
+        optimizeVertexCache(&indices[0], indexCount, geometry.vertexCount());
+        vector<uint32_t> tableData;
+        size_t meshletCount = buildMeshlets(&indices[0], indexCount, (const float*)geometry.vertexData(),
+                                            geometry.vertexCount(), tableData);
+        MeshletTable table = meshletTable(&tableData[0], meshletCount);
+
+        const MeshBounds& bounds = geometry.bounds();
+        glm::vec3 centre(bounds.centre[0], bounds.centre[1], bounds.centre[2]);
+        float radius = max(bounds.radius, 1e-6f);
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, radius * 0.01f, radius * 10.0f);
+
+        vector<uint32_t> visible(meshletCount), reference(meshletCount);
+        double seconds = 0.0, referenceSeconds = 0.0;
+        size_t mismatches = 0;
+        double trianglesTested = 0.0, frustumRejected = 0.0, bothRejected = 0.0;
+        for(int camera=0; camera<cameraCount; camera++)
+        {
+            // every other camera is close in, where much of the mesh falls outside the view
+            float angle = 2.0f * M_PI * camera / cameraCount;
+            float distance = radius * ((camera % 2 == 0) ? 3.0f : 0.8f);
+            glm::vec3 eye = centre + distance * glm::vec3(cosf(angle), 0.3f, sinf(angle));
+            glm::mat4 mvp = projection * glm::lookAt(eye, centre, glm::vec3(0.0f, 1.0f, 0.0f));
+            FrustumPlanes frustum = extractFrustumPlanes(&mvp[0][0]);
+            float cameraPosition[3] = {eye.x, eye.y, eye.z};
+
+            size_t frustumCount = cullMeshlets(table, frustum, 0, &visible[0]);
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            size_t visibleCount = cullMeshlets(table, frustum, cameraPosition, &visible[0]);
+            seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            start = chrono::steady_clock::now();
+            size_t referenceCount = cullMeshletsReference(table, frustum, cameraPosition, &reference[0]);
+            referenceSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if((visibleCount != referenceCount) || !equal(visible.begin(), visible.begin() + visibleCount, reference.begin()))
+            {
+                mismatches++;
+            }
+
+            // triangles rather than meshlets, since they aren't all the same size
+            size_t frustumTriangles = 0, visibleTriangles = 0;
+            cullMeshlets(table, frustum, 0, &reference[0]);
+            for(size_t meshlet=0; meshlet<frustumCount; meshlet++)
+            {
+                frustumTriangles += table.indexCount[reference[meshlet]] / 3;
+            }
+            for(size_t meshlet=0; meshlet<visibleCount; meshlet++)
+            {
+                visibleTriangles += table.indexCount[visible[meshlet]] / 3;
+            }
+            trianglesTested += indexCount / 3;
+            frustumRejected += indexCount / 3 - frustumTriangles;
+            bothRejected += indexCount / 3 - visibleTriangles;
+        }
+
+        printf("%-28s %9zu %9.2f %10.2f %10.2f %10zu %8.1f%% %8.1f%%\n", argv[i], meshletCount,
+               seconds / cameraCount * 1e6, seconds / cameraCount / meshletCount * 1e9,
+               referenceSeconds / cameraCount * 1e6, mismatches, frustumRejected / trianglesTested * 100.0,
+               bothRejected / trianglesTested * 100.0);
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <iostream>
+
+#include <stdlib.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+using namespace std;
+
+#include "headlessgl.h"
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+static GLuint framebuffer;
+static GLuint renderbuffers[2];
+
+bool createHeadlessContext(int width, int height)
+{
+    // Mesa picks the platform from the environment, surfaceless needs neither X nor a DRM device
+    setenv("EGL_PLATFORM", "surfaceless", 0);
+
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if((display == EGL_NO_DISPLAY) || !eglInitialize(display, 0, 0))
+    {
+        cout << "Unable to initialise EGL" << endl;
+        return false;
+    }
+
+    const EGLint configAttributes[] =
+    {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if(!eglBindAPI(EGL_OPENGL_API) ||
+       !eglChooseConfig(display, configAttributes, &config, 1, &configCount) || (configCount == 0))
+    {
+        cout << "No EGL config with desktop OpenGL support" << endl;
+        return false;
+    }
+
+    const EGLint contextAttributes[] =
+    {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if((context == EGL_NO_CONTEXT) || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        cout << "Unable to create a surfaceless OpenGL 3.3 context" << endl;
+        return false;
+    }
+
+    // No default framebuffer without a surface, so render into our own
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        cout << "Offscreen framebuffer is incomplete" << endl;
+        return false;
+    }
+    glViewport(0, 0, width, height);
+
+    cout << "Headless renderer: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << endl;
+    return true;
+}
+
+void destroyHeadlessContext()
+{
+    if(context != EGL_NO_CONTEXT)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(2, renderbuffers);
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        context = EGL_NO_CONTEXT;
+    }
+    if(display != EGL_NO_DISPLAY)
+    {
+        eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+    }
+}
+
+static GLuint compileShader(const char* source, GLenum shaderType)
+{
+    GLuint shader = glCreateShader(shaderType);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint compileStatus;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+    if(compileStatus != GL_TRUE)
+    {
+        GLchar message[1024];
+        glGetShaderInfoLog(shader, 1024, NULL, message);
+        cout << "Shader compile error: " << message << endl;
+    }
+    return shader;
+}
+
+GLuint compileProgram(const char* vertexSource, const char* fragmentSource)
+{
+    GLuint vertShader = compileShader(vertexSource, GL_VERTEX_SHADER);
+    GLuint fragShader = compileShader(fragmentSource, GL_FRAGMENT_SHADER);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertShader);
+    glAttachShader(program, fragShader);
+    glLinkProgram(program);
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+
+    GLint linkStatus;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    if(linkStatus != GL_TRUE)
+    {
+        GLchar message[1024];
+        glGetProgramInfoLog(program, 1024, NULL, message);
+        cout << "Shader load error: " << message << endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
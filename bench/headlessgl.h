@@ -0,0 +1,15 @@
+#ifndef HEADLESS_GL_H
+#define HEADLESS_GL_H
+
+#include "glheaders.h"
+
+// NOTE: A windowless GL 3.3 core context for the benchmarks, made with EGL on Mesa's surfaceless
+//       platform, rendering into an offscreen framebuffer of the given size (which stays bound).
+//       Works on machines without a display or a GPU, where Mesa falls back to llvmpipe
+bool createHeadlessContext(int width, int height);
+void destroyHeadlessContext();
+
+// Compiles and links a program from source, printing the log and returning 0 if that fails
+GLuint compileProgram(const char* vertexSource, const char* fragmentSource);
+
+#endif
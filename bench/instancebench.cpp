@@ -0,0 +1,219 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace std;
+
+#include "headlessgl.h"
+#include "geometry.h"
+#include "glvertexformat.h"
+#include "scene.h"
+
+// NOTE: Draws one mesh (suzanne by default) thousands of times over, in a square grid, through the
+//       app's own shaders: once as a draw per copy, pointing the instance attributes at each copy's
+//       record in turn the way the window draws copies it culls one at a time, and once as a single
+//       instanced draw. It times filling the instance buffer, issuing the draws and the whole frame
+//       (until the GPU is done), and checks the two ways give the same picture. The framebuffer is
+//       small, so the time goes on the draws and the vertices rather than on filling pixels
+
+static const int framebufferSize = 256;
+static const int frameCount = 3;
+
+// Same packing as the app
+static const VertexPacking benchVertexPacking =
+{
+    VERTEX_ENCODING_UNORM16_BOUNDS, VERTEX_ENCODING_HALF, VERTEX_ENCODING_SNORM_10_10_10_2
+};
+
+static string readShader(const char* filename)
+{
+    ifstream file(filename);
+    stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+struct FrameTimes
+{
+    double submitSeconds;
+    double frameSeconds;
+};
+
+// Draws every copy, instanced or one draw each, and returns how long that took to issue and to finish
+static FrameTimes drawFrame(const InstanceAttributeLocations& instanceLocations, GLuint instanceBuffer,
+                            int indexCount, size_t copies, bool instanced)
+{
+    FrameTimes times;
+    glFinish();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    if(instanced)
+    {
+        applyInstanceFormat(instanceLocations);
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, copies);
+    }
+    else
+    {
+        for(size_t copy=0; copy<copies; copy++)
+        {
+            applyInstanceFormat(instanceLocations, copy * instanceRecordFloats * sizeof(float));
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        }
+    }
+    times.submitSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    glFinish();
+    times.frameSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return times;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* filename = (argc > 1) ? argv[1] : "objects/suzanne.obj";
+    size_t copies = (argc > 2) ? strtoul(argv[2], 0, 10) : 10000;
+    if(copies == 0)
+    {
+        cout << "usage: " << argv[0] << " [file.obj [copies]]" << endl;
+        return 1;
+    }
+
+    if(!createHeadlessContext(framebufferSize, framebufferSize))
+    {
+        return 1;
+    }
+
+    string vertexSource = readShader("build/simple.vert");
+    string fragmentSource = readShader("build/simple.frag");
+    GLuint program = compileProgram(vertexSource.c_str(), fragmentSource.c_str());
+    if(!program)
+    {
+        return 1;
+    }
+    glUseProgram(program);
+    GLint locations[VERTEX_ATTRIBUTE_COUNT];
+    getVertexAttributeLocations(program, locations);
+    InstanceAttributeLocations instanceLocations = getInstanceAttributeLocations(program);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    GeometryData geometry;
+    geometry.loadFromOBJFile(filename);
+    if(geometry.indexCount() == 0)
+    {
+        cout << "Nothing to draw in " << filename << endl;
+        return 1;
+    }
+    geometry.optimize(MESH_OPTIMIZE_VERTEX_CACHE | MESH_OPTIMIZE_VERTEX_FETCH);
+
+    // The mesh, packed and uploaded the way the window does it
+    unsigned int attributes = geometry.vertexAttributes() & usedVertexAttributes(locations);
+    VertexFormat format = packedVertexFormat(attributes, benchVertexPacking, geometry.bounds());
+    GLuint vertexArray, buffers[3];
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+    glGenBuffers(3, buffers);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    vector<char> vertices(geometry.vertexCount() * format.stride);
+    geometry.writeInterleavedVertices(format, &vertices[0]);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size(), &vertices[0], GL_STATIC_DRAW);
+    applyVertexFormat(format, locations);
+    applyPositionDequantization(program, format);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, geometry.indexCount() * sizeof(unsigned int), geometry.indexData(),
+                 GL_STATIC_DRAW);
+
+    // A square grid of copies, each with a color of its own, all of it in view
+    const MeshBounds& bounds = geometry.bounds();
+    float spacing = 2.5f * max(bounds.radius, 1e-6f);
+    size_t side = (size_t)ceil(sqrt((double)copies));
+    Scene scene;
+    vector<uint32_t> order(copies);
+    for(size_t copy=0; copy<copies; copy++)
+    {
+        glm::vec3 offset((copy % side) * spacing, (copy / side) * spacing, 0.0f);
+        glm::vec3 centre(bounds.centre[0], bounds.centre[1], bounds.centre[2]);
+        glm::vec3 color((copy % 7) / 6.0f, (copy % 5) / 4.0f, (copy % 3) / 2.0f);
+        scene.add(MeshHandle(), glm::translate(glm::mat4(1.0f), offset - centre), color);
+        order[copy] = copy;
+    }
+    float extent = 0.5f * side * spacing;
+    glm::mat4 viewProjection = glm::ortho(-extent, extent, -extent, extent, -4.0f * extent, 4.0f * extent) *
+                               glm::translate(glm::mat4(1.0f), glm::vec3(-extent + 0.5f * spacing,
+                                                                         -extent + 0.5f * spacing, 0.0f));
+    glUniformMatrix4fv(glGetUniformLocation(program, "ViewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+
+    // Filling the instance buffer, once a frame in the app
+    size_t instanceBytes = copies * instanceRecordFloats * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[2]);
+    glBufferData(GL_ARRAY_BUFFER, instanceBytes, 0, GL_STREAM_DRAW);
+    double uploadSeconds = 1e30;
+    for(int frame=0; frame<frameCount; frame++)
+    {
+        glFinish();
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        void* instanceData = glMapBufferRange(GL_ARRAY_BUFFER, 0, instanceBytes,
+                                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        scene.writeObjectData(&order[0], copies, (float*)instanceData);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glFinish();
+        uploadSeconds = min(uploadSeconds, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+
+    // Best of a few frames each way, after one to warm up, keeping the last picture of each
+    const char* names[2] = {"draw per copy", "instanced"};
+    FrameTimes best[2];
+    vector<unsigned char> pixels[2];
+    for(int instanced=0; instanced<2; instanced++)
+    {
+        drawFrame(instanceLocations, buffers[2], geometry.indexCount(), copies, instanced);
+        best[instanced].submitSeconds = best[instanced].frameSeconds = 1e30;
+        for(int frame=0; frame<frameCount; frame++)
+        {
+            FrameTimes times = drawFrame(instanceLocations, buffers[2], geometry.indexCount(), copies, instanced);
+            best[instanced].submitSeconds = min(best[instanced].submitSeconds, times.submitSeconds);
+            best[instanced].frameSeconds = min(best[instanced].frameSeconds, times.frameSeconds);
+        }
+        pixels[instanced].resize(framebufferSize * framebufferSize * 4);
+        glReadPixels(0, 0, framebufferSize, framebufferSize, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[instanced][0]);
+    }
+
+    size_t differentPixels = 0, coveredPixels = 0;
+    for(size_t pixel=0; pixel<pixels[0].size(); pixel+=4)
+    {
+        differentPixels += !equal(&pixels[0][pixel], &pixels[0][pixel] + 4, &pixels[1][pixel]);
+        coveredPixels += (pixels[1][pixel] | pixels[1][pixel + 1] | pixels[1][pixel + 2]) != 0;
+    }
+
+    double triangles = (double)copies * (geometry.indexCount() / 3);
+    printf("%zu copies of %s, %.0f triangles a frame, best of %d frames\n", copies, filename, triangles, frameCount);
+    printf("instance buffer fill     %8.3f ms (%zu bytes)\n", uploadSeconds * 1000.0, instanceBytes);
+    for(int instanced=0; instanced<2; instanced++)
+    {
+        printf("%-16s submit %8.3f ms  frame %9.3f ms  %7.1f M triangles/s\n", names[instanced],
+               best[instanced].submitSeconds * 1000.0, best[instanced].frameSeconds * 1000.0,
+               triangles / best[instanced].frameSeconds / 1e6);
+    }
+    printf("frames differ in %zu of %d pixels (%zu covered)\n", differentPixels, framebufferSize * framebufferSize,
+           coveredPixels);
+
+    if(glGetError() != GL_NO_ERROR)
+    {
+        cout << "OpenGL error while benchmarking " << filename << endl;
+    }
+    glDeleteBuffers(3, buffers);
+    glDeleteVertexArrays(1, &vertexArray);
+    glDeleteProgram(program);
+    destroyHeadlessContext();
+    return 0;
+}
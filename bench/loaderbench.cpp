@@ -0,0 +1,470 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <new>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+#include "geometry.h"
+#include "benchutil.h"
+#include "processstats.h"
+
+// NOTE: Benchmarks GeometryData::loadFromOBJFile on every mesh given on the command line, with no GL
+//       involved. Each file is loaded once to warm the page cache and then timed runs times, and the
+//       median and 95th percentile of each loader stage (parsing, expanding the faces into indexed
+//       vertices, generating missing normals and building tangents) are reported, along with the parse rate, every heap
+//       allocation made during a load and the peak resident size.
+//
+//       --json writes the results out, and --baseline compares them against an earlier --json file,
+//       exiting with 1 if any file got slower by more than the tolerance (and by at least --min-ms)
+//       or allocates more often than it did, or if none of the files are in the baseline at all
+
+// Every operator new in the process is counted, including the worker pool's, so these are atomics
+static atomic<size_t> heapAllocationCount(0);
+static atomic<size_t> heapAllocatedBytes(0);
+
+// NOTE: Once free() is inlined into a caller that got its memory from operator new, GCC warns that
+//       the two don't match (-Wmismatched-new-delete), so the replacement deletes stay out of line
+#if defined(__GNUC__)
+#define COUNTED_DELETE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define COUNTED_DELETE __declspec(noinline)
+#else
+#define COUNTED_DELETE
+#endif
+
+void* operator new(size_t size)
+{
+    heapAllocationCount++;
+    heapAllocatedBytes += size;
+    void* memory = malloc(size ? size : 1);
+    if(!memory)
+    {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+COUNTED_DELETE void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+COUNTED_DELETE void operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+COUNTED_DELETE void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+COUNTED_DELETE void operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+// NOTE: Over-aligned types go through their own overloads from C++17 on, and the default ones
+//       would hand out memory that the counters never saw
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, align_val_t alignment)
+{
+    heapAllocationCount++;
+    heapAllocatedBytes += size;
+#ifdef _WIN32
+    void* memory = _aligned_malloc(size ? size : 1, (size_t)alignment);
+#else
+    void* memory = 0;
+    if(posix_memalign(&memory, std::max((size_t)alignment, sizeof(void*)), size ? size : 1) != 0)
+    {
+        memory = 0;
+    }
+#endif
+    if(!memory)
+    {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size, align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+COUNTED_DELETE void operator delete(void* memory, align_val_t) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+COUNTED_DELETE void operator delete[](void* memory, align_val_t alignment) noexcept
+{
+    operator delete(memory, alignment);
+}
+
+COUNTED_DELETE void operator delete(void* memory, size_t, align_val_t alignment) noexcept
+{
+    operator delete(memory, alignment);
+}
+
+COUNTED_DELETE void operator delete[](void* memory, size_t, align_val_t alignment) noexcept
+{
+    operator delete(memory, alignment);
+}
+#endif
+
+struct Percentiles
+{
+    double median;
+    double p95;
+};
+
+struct FileResult
+{
+    string filename;
+    size_t fileBytes;
+    int vertexCount;
+    int indexCount;
+
+    Percentiles parseMs;
+    Percentiles indexMs;
+    Percentiles normalMs;
+    Percentiles tangentMs;
+    Percentiles totalMs;
+    double parseMegabytesPerSecond;
+
+    size_t allocations;
+    size_t allocatedBytes;
+    size_t loaderAllocations;
+    size_t peakResidentBytes;
+};
+
+// Median and nearest rank 95th percentile, in milliseconds
+static Percentiles percentiles(vector<double> seconds)
+{
+    sort(seconds.begin(), seconds.end());
+    Percentiles result;
+    size_t count = seconds.size();
+    result.median = ((count % 2) ? seconds[count/2] : 0.5 * (seconds[count/2 - 1] + seconds[count/2])) * 1000.0;
+    size_t rank = (size_t)ceil(0.95 * count);
+    result.p95 = seconds[std::max<size_t>(rank, 1) - 1] * 1000.0;
+    return result;
+}
+
+static FileResult benchmarkFile(const string& filename, OBJLoadMode mode, int runs)
+{
+    FileResult result = FileResult();
+    result.filename = filename;
+
+    {
+        SilenceCout silence;
+        GeometryData warmup;
+        warmup.loadFromOBJFile(filename, mode);
+        result.vertexCount = warmup.vertexCount();
+        result.indexCount = warmup.indexCount();
+    }
+
+    vector<double> parseSeconds, indexSeconds, normalSeconds, tangentSeconds, totalSeconds;
+    size_t residentBefore = currentResidentBytes();
+    resetPeakResidentBytes();
+    for(int run=0; run<runs; run++)
+    {
+        // NOTE: The geometry is kept alive until after the allocation counters are read, so only
+        //       what the load allocates is counted and not anything the silencer or destructor does
+        SilenceCout silence;
+        size_t allocationsBefore = heapAllocationCount;
+        size_t bytesBefore = heapAllocatedBytes;
+
+        GeometryData geometry;
+        geometry.loadFromOBJFile(filename, mode);
+
+        result.allocations = heapAllocationCount - allocationsBefore;
+        result.allocatedBytes = heapAllocatedBytes - bytesBefore;
+
+        const OBJLoadStats& stats = geometry.loadStats();
+        result.fileBytes = stats.fileBytes;
+        result.loaderAllocations = stats.allocationCount;
+        parseSeconds.push_back(stats.parseSeconds);
+        indexSeconds.push_back(stats.indexSeconds);
+        normalSeconds.push_back(stats.normalSeconds);
+        tangentSeconds.push_back(stats.tangentSeconds);
+        totalSeconds.push_back(stats.parseSeconds + stats.indexSeconds + stats.normalSeconds + stats.tangentSeconds);
+    }
+    size_t peak = peakResidentBytes();
+    result.peakResidentBytes = (peak > residentBefore) ? peak - residentBefore : 0;
+
+    result.parseMs = percentiles(parseSeconds);
+    result.indexMs = percentiles(indexSeconds);
+    result.normalMs = percentiles(normalSeconds);
+    result.tangentMs = percentiles(tangentSeconds);
+    result.totalMs = percentiles(totalSeconds);
+    result.parseMegabytesPerSecond = (result.parseMs.median > 0.0) ?
+        (result.fileBytes / (1024.0 * 1024.0)) / (result.parseMs.median / 1000.0) : 0.0;
+    return result;
+}
+
+static string jsonPercentiles(const Percentiles& value)
+{
+    char text[128];
+    snprintf(text, sizeof(text), "{\"median\": %.4f, \"p95\": %.4f}", value.median, value.p95);
+    return text;
+}
+
+// NOTE: One file per line, which is what readBaseline relies on
+static bool writeJSON(const string& path, const string& modeName, int runs, const vector<FileResult>& results)
+{
+    ofstream out(path.c_str());
+    if(!out)
+    {
+        cout << "Unable to write " << path << endl;
+        return false;
+    }
+
+    out << "{" << endl;
+    out << "  \"mode\": \"" << modeName << "\"," << endl;
+    out << "  \"runs\": " << runs << "," << endl;
+    out << "  \"files\": [" << endl;
+    for(size_t i=0; i<results.size(); i++)
+    {
+        const FileResult& result = results[i];
+        char numbers[256];
+        snprintf(numbers, sizeof(numbers),
+                 "\"bytes\": %zu, \"vertices\": %d, \"indices\": %d, \"parse_mb_per_s\": %.2f, "
+                 "\"allocations\": %zu, \"allocated_bytes\": %zu, \"peak_rss_bytes\": %zu",
+                 result.fileBytes, result.vertexCount, result.indexCount, result.parseMegabytesPerSecond,
+                 result.allocations, result.allocatedBytes, result.peakResidentBytes);
+        out << "    {\"file\": \"" << result.filename << "\", " << numbers
+            << ", \"parse_ms\": " << jsonPercentiles(result.parseMs)
+            << ", \"index_ms\": " << jsonPercentiles(result.indexMs)
+            << ", \"normal_ms\": " << jsonPercentiles(result.normalMs)
+            << ", \"tangent_ms\": " << jsonPercentiles(result.tangentMs)
+            << ", \"total_ms\": " << jsonPercentiles(result.totalMs) << "}"
+            << ((i + 1 < results.size()) ? "," : "") << endl;
+    }
+    out << "  ]" << endl;
+    out << "}" << endl;
+    return true;
+}
+
+struct BaselineEntry
+{
+    string filename;
+    double totalMedianMs;
+    size_t allocations;
+};
+
+// Finds "key": in line and reads the number after it (or after "median": inside it, for the timings)
+static bool readNumber(const string& line, const string& key, double* value)
+{
+    size_t position = line.find("\"" + key + "\":");
+    if(position == string::npos)
+    {
+        return false;
+    }
+    position = line.find_first_not_of(' ', position + key.size() + 3);
+    if(position == string::npos)
+    {
+        return false;
+    }
+    if(line[position] == '{')
+    {
+        position = line.find("\"median\":", position);
+        if(position == string::npos)
+        {
+            return false;
+        }
+        position += 9;
+    }
+    *value = strtod(line.c_str() + position, 0);
+    return true;
+}
+
+// NOTE: Only reads back what writeJSON writes (one file object per line), not JSON in general
+static bool readBaseline(const string& path, vector<BaselineEntry>& entries)
+{
+    ifstream in(path.c_str());
+    if(!in)
+    {
+        cout << "Unable to read the baseline " << path << endl;
+        return false;
+    }
+
+    string line;
+    while(getline(in, line))
+    {
+        size_t fileKey = line.find("\"file\": \"");
+        if(fileKey == string::npos)
+        {
+            continue;
+        }
+        size_t nameStart = fileKey + 9;
+        BaselineEntry entry;
+        entry.filename = line.substr(nameStart, line.find('"', nameStart) - nameStart);
+        double allocations = 0.0;
+        if(readNumber(line, "total_ms", &entry.totalMedianMs) && readNumber(line, "allocations", &allocations))
+        {
+            entry.allocations = (size_t)allocations;
+            entries.push_back(entry);
+        }
+    }
+    return true;
+}
+
+// Slowdowns of less than minimumMs are too noisy to call a regression, whatever the percentage. A run
+// where no file matches the baseline (say, the paths were given differently) fails rather than pass
+// without comparing anything
+static bool compareWithBaseline(const vector<FileResult>& results, const vector<BaselineEntry>& baseline,
+                                double tolerance, double minimumMs)
+{
+    bool regressed = false;
+    size_t comparedCount = 0;
+    cout << endl << "Against the baseline (tolerance " << tolerance * 100.0 << "%):" << endl;
+    for(size_t i=0; i<results.size(); i++)
+    {
+        const FileResult& result = results[i];
+        const BaselineEntry* entry = 0;
+        for(size_t j=0; j<baseline.size(); j++)
+        {
+            if(baseline[j].filename == result.filename)
+            {
+                entry = &baseline[j];
+            }
+        }
+        if(!entry)
+        {
+            printf("  %-28s not in the baseline\n", result.filename.c_str());
+            continue;
+        }
+        comparedCount++;
+
+        double change = (entry->totalMedianMs > 0.0) ? result.totalMs.median / entry->totalMedianMs - 1.0 : 0.0;
+        bool slower = (change > tolerance) && (result.totalMs.median - entry->totalMedianMs > minimumMs);
+        bool moreAllocations = result.allocations > entry->allocations;
+        printf("  %-28s %9.3f ms -> %9.3f ms (%+6.1f%%), %zu -> %zu allocations%s\n",
+               result.filename.c_str(), entry->totalMedianMs, result.totalMs.median, change * 100.0,
+               entry->allocations, result.allocations,
+               (slower || moreAllocations) ? "  REGRESSION" : "");
+        regressed = regressed || slower || moreAllocations;
+    }
+
+    if(comparedCount == 0)
+    {
+        cout << "None of the files are in the baseline, so nothing was compared" << endl;
+        return false;
+    }
+    if(regressed)
+    {
+        cout << "Loader performance regressed" << endl;
+    }
+    return !regressed;
+}
+
+int main(int argc, char** argv)
+{
+    int runs = 15;
+    OBJLoadMode mode = OBJ_LOAD_MAPPED;
+    string modeName = "mapped";
+    string jsonPath, baselinePath;
+    double tolerance = 0.25;
+    double minimumMs = 0.5;
+    vector<string> filenames;
+    for(int i=1; i<argc; i++)
+    {
+        string argument = argv[i];
+        if((argument == "--runs") && (i + 1 < argc))
+        {
+            runs = std::max(1, atoi(argv[++i]));
+        }
+        else if((argument == "--mode") && (i + 1 < argc))
+        {
+            modeName = argv[++i];
+            mode = (modeName == "stream") ? OBJ_LOAD_STREAM :
+                   (modeName == "parallel") ? OBJ_LOAD_PARALLEL : OBJ_LOAD_MAPPED;
+        }
+        else if((argument == "--json") && (i + 1 < argc))
+        {
+            jsonPath = argv[++i];
+        }
+        else if((argument == "--baseline") && (i + 1 < argc))
+        {
+            baselinePath = argv[++i];
+        }
+        else if((argument == "--tolerance") && (i + 1 < argc))
+        {
+            tolerance = atof(argv[++i]);
+        }
+        else if((argument == "--min-ms") && (i + 1 < argc))
+        {
+            minimumMs = atof(argv[++i]);
+        }
+        else
+        {
+            filenames.push_back(argument);
+        }
+    }
+    if(filenames.empty())
+    {
+        cout << "Usage: loaderbench [--runs n] [--mode stream|mapped|parallel] [--json results.json]" << endl;
+        cout << "                   [--baseline baseline.json] [--tolerance 0.25] [--min-ms 0.5] file.obj..." << endl;
+        return 1;
+    }
+
+    vector<FileResult> results;
+    for(size_t i=0; i<filenames.size(); i++)
+    {
+        results.push_back(benchmarkFile(filenames[i], mode, runs));
+    }
+
+    cout << runs << " runs per file, " << modeName << " loader, median/p95 in ms" << endl;
+    cout << "mesh                          vertices          parse          index         normal        tangent          total"
+            "     MB/s  allocs  peak MB" << endl;
+    for(size_t i=0; i<results.size(); i++)
+    {
+        const FileResult& result = results[i];
+        printf("%-28s %9d %6.2f/%6.2f %6.2f/%6.2f %6.2f/%6.2f %6.2f/%6.2f %6.2f/%6.2f %8.1f %7zu %8.1f\n",
+               result.filename.c_str(), result.vertexCount, result.parseMs.median, result.parseMs.p95,
+               result.indexMs.median, result.indexMs.p95, result.normalMs.median, result.normalMs.p95,
+               result.tangentMs.median, result.tangentMs.p95, result.totalMs.median, result.totalMs.p95,
+               result.parseMegabytesPerSecond, result.allocations, result.peakResidentBytes / (1024.0 * 1024.0));
+    }
+
+    if(!jsonPath.empty() && !writeJSON(jsonPath, modeName, runs, results))
+    {
+        return 1;
+    }
+
+    if(!baselinePath.empty())
+    {
+        vector<BaselineEntry> baseline;
+        if(!readBaseline(baselinePath, baseline))
+        {
+            return 1;
+        }
+        if(!compareWithBaseline(results, baseline, tolerance, minimumMs))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include <stdio.h>
+
+using namespace std;
+
+#include "geometry.h"
+#include "benchutil.h"
+#include "meshoptimize.h"
+#include "meshlets.h"
+
+// NOTE: Splits every mesh given on the command line into meshlets, after putting its triangles in
+//       vertex cache order the way the app does, and reports how long building them takes (best of a
+//       few runs), how many there are and how full they are on average against the 64 vertex and 124
+//       triangle limits, how many have a normal cone narrow enough to cull with, and how big their
+//       bounding spheres are against the whole mesh's
+
+int main(int argc, char** argv)
+{
+    if(!checkMeshArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    int runs = 5;
+    printf("%-28s %9s %9s %9s %9s %9s %9s %9s %11s\n", "mesh", "triangles", "build ms", "M tri/s",
+           "meshlets", "vert fill", "tri fill", "cullable", "mean radius");
+    for(int i=1; i<argc; i++)
+    {
+        GeometryData geometry;
+        if(!loadQuietly(argv[i], geometry))
+        {
+            continue;
+        }
+        size_t vertexCount = geometry.vertexCount();
+        size_t indexCount = geometry.indexCount();
+
+        vector<unsigned int> sorted((unsigned int*)geometry.indexData(), (unsigned int*)geometry.indexData() + indexCount);
+        optimizeVertexCache(&sorted[0], indexCount, vertexCount);
+
+        vector<unsigned int> indices;
+        vector<uint32_t> tableData;
+        size_t meshletCount = 0;
+        double best = 1e30;
+        for(int run=0; run<runs; run++)
+        {
+            indices = sorted;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            meshletCount = buildMeshlets(&indices[0], indexCount, (const float*)geometry.vertexData(), vertexCount, tableData);
+            best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+
+        MeshletTable table = meshletTable(&tableData[0], meshletCount);
+        MeshletStats stats = analyzeMeshlets(table);
+        double radiusSum = 0.0;
+        for(size_t meshlet=0; meshlet<meshletCount; meshlet++)
+        {
+            radiusSum += table.radius[meshlet];
+        }
+        float meanRadius = radiusSum / meshletCount / max(geometry.bounds().radius, 1e-6f);
+
+        printf("%-28s %9zu %9.2f %9.2f %9zu %8.1f%% %8.1f%% %8.1f%% %10.3f\n", argv[i], indexCount / 3, best * 1000.0,
+               indexCount / 3 / best / 1e6, meshletCount, stats.vertexFill * 100.0f, stats.triangleFill * 100.0f,
+               stats.coneCullable * 100.0f, meanRadius);
+    }
+    return 0;
+}
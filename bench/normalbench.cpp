@@ -0,0 +1,267 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <random>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace std;
+
+#include "meshnormals.h"
+#include "workerpool.h"
+
+// NOTE: Times smooth normal and tangent frame generation on a generated multi-million triangle mesh:
+//       a sphere made of a latitude/longitude grid whose vertices are shuffled, so that neighbouring
+//       faces don't also sit next to each other in memory, as in scanned meshes like the dragon. Its
+//       poles are rows of coincident vertices and its texture wraps around the seam, so there are
+//       plenty of degenerate faces too.
+//
+//       The normals are compared against a plain serial scatter (add each face's normal into its
+//       three vertices), and the tangents against the loader's old per face loop, which is also
+//       where the NaN counts come from
+
+struct Mesh
+{
+    vector<float> positions;
+    vector<float> textureCoords;
+    vector<unsigned int> indices;
+};
+
+static Mesh generateSphere(int rings, int segments)
+{
+    Mesh mesh;
+    int vertexCount = (rings + 1) * segments;
+    vector<unsigned int> order(vertexCount);
+    for(int vertex=0; vertex<vertexCount; vertex++)
+    {
+        order[vertex] = vertex;
+    }
+    shuffle(order.begin(), order.end(), mt19937(1234));
+
+    mesh.positions.resize(vertexCount * 3);
+    mesh.textureCoords.resize(vertexCount * 2);
+    for(int ring=0; ring<=rings; ring++)
+    {
+        float latitude = M_PI * ring / rings;
+        for(int segment=0; segment<segments; segment++)
+        {
+            float longitude = 2.0f * M_PI * segment / segments;
+            float* position = &mesh.positions[3 * order[ring * segments + segment]];
+            position[0] = sinf(latitude) * cosf(longitude);
+            position[1] = cosf(latitude);
+            position[2] = sinf(latitude) * sinf(longitude);
+            float* textureCoord = &mesh.textureCoords[2 * order[ring * segments + segment]];
+            textureCoord[0] = (float)segment / segments;
+            textureCoord[1] = (float)ring / rings;
+        }
+    }
+
+    for(int ring=0; ring<rings; ring++)
+    {
+        for(int segment=0; segment<segments; segment++)
+        {
+            unsigned int corner00 = order[ring * segments + segment];
+            unsigned int corner01 = order[ring * segments + (segment + 1) % segments];
+            unsigned int corner10 = order[(ring + 1) * segments + segment];
+            unsigned int corner11 = order[(ring + 1) * segments + (segment + 1) % segments];
+            unsigned int quad[6] = {corner00, corner10, corner11, corner00, corner11, corner01};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+static void scatterNormals(const Mesh& mesh, float* normals)
+{
+    size_t vertexCount = mesh.positions.size() / 3;
+    fill(normals, normals + vertexCount * 3, 0.0f);
+    for(size_t face=0; face<mesh.indices.size()/3; face++)
+    {
+        const unsigned int* corners = &mesh.indices[3*face];
+        const float* position0 = &mesh.positions[3*corners[0]];
+        const float* position1 = &mesh.positions[3*corners[1]];
+        const float* position2 = &mesh.positions[3*corners[2]];
+        float edge1[3], edge2[3];
+        for(int i=0; i<3; i++)
+        {
+            edge1[i] = position1[i] - position0[i];
+            edge2[i] = position2[i] - position0[i];
+        }
+        float normal[3] = {edge1[1]*edge2[2] - edge1[2]*edge2[1],
+                           edge1[2]*edge2[0] - edge1[0]*edge2[2],
+                           edge1[0]*edge2[1] - edge1[1]*edge2[0]};
+        for(int corner=0; corner<3; corner++)
+        {
+            for(int i=0; i<3; i++)
+            {
+                normals[3*corners[corner] + i] += normal[i];
+            }
+        }
+    }
+    for(size_t vertex=0; vertex<vertexCount; vertex++)
+    {
+        float* normal = &normals[3*vertex];
+        float length = sqrtf(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+        float scale = (length > 0.0f) ? 1.0f / length : 0.0f;
+        for(int i=0; i<3; i++)
+        {
+            normal[i] *= scale;
+        }
+    }
+}
+
+// The tangent loop the loader used to have: every face's (bi)tangent divided by its length and by
+// the UV determinant, with nothing to catch either of them being zero
+static void oldTangents(const Mesh& mesh, float* tangents, float* bitangents)
+{
+    size_t vertexCount = mesh.positions.size() / 3;
+    fill(tangents, tangents + vertexCount * 3, 0.0f);
+    fill(bitangents, bitangents + vertexCount * 3, 0.0f);
+    for(size_t face=0; face<mesh.indices.size()/3; face++)
+    {
+        const unsigned int* corners = &mesh.indices[3*face];
+        const float* position0 = &mesh.positions[3*corners[0]];
+        const float* position1 = &mesh.positions[3*corners[1]];
+        const float* position2 = &mesh.positions[3*corners[2]];
+        const float* uv0 = &mesh.textureCoords[2*corners[0]];
+        const float* uv1 = &mesh.textureCoords[2*corners[1]];
+        const float* uv2 = &mesh.textureCoords[2*corners[2]];
+        float deltaU1 = uv1[0] - uv0[0], deltaV1 = uv1[1] - uv0[1];
+        float deltaU2 = uv2[0] - uv0[0], deltaV2 = uv2[1] - uv0[1];
+        float inverseDet = 1.0f / (deltaU1*deltaV2 - deltaU2*deltaV1);
+        float tangent[3], bitangent[3];
+        for(int i=0; i<3; i++)
+        {
+            float edge1 = position1[i] - position0[i];
+            float edge2 = position2[i] - position0[i];
+            tangent[i] = inverseDet * (deltaV2*edge1 - deltaV1*edge2);
+            bitangent[i] = inverseDet * (deltaU1*edge2 - deltaU2*edge1);
+        }
+        float tangentLength = sqrtf(tangent[0]*tangent[0] + tangent[1]*tangent[1] + tangent[2]*tangent[2]);
+        float bitangentLength = sqrtf(bitangent[0]*bitangent[0] + bitangent[1]*bitangent[1] + bitangent[2]*bitangent[2]);
+        for(int corner=0; corner<3; corner++)
+        {
+            for(int i=0; i<3; i++)
+            {
+                tangents[3*corners[corner] + i] += tangent[i] / tangentLength;
+                bitangents[3*corners[corner] + i] += bitangent[i] / bitangentLength;
+            }
+        }
+    }
+    for(size_t vertex=0; vertex<vertexCount; vertex++)
+    {
+        float* tangent = &tangents[3*vertex];
+        float* bitangent = &bitangents[3*vertex];
+        float tangentLength = sqrtf(tangent[0]*tangent[0] + tangent[1]*tangent[1] + tangent[2]*tangent[2]);
+        float bitangentLength = sqrtf(bitangent[0]*bitangent[0] + bitangent[1]*bitangent[1] + bitangent[2]*bitangent[2]);
+        for(int i=0; i<3; i++)
+        {
+            tangent[i] /= tangentLength;
+            bitangent[i] /= bitangentLength;
+        }
+    }
+}
+
+static size_t countNaNVertices(const vector<float>& values)
+{
+    size_t count = 0;
+    for(size_t vertex=0; vertex<values.size()/3; vertex++)
+    {
+        if(!isfinite(values[3*vertex]) || !isfinite(values[3*vertex + 1]) || !isfinite(values[3*vertex + 2]))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+template <typename Function>
+static double bestSeconds(int runs, const Function& function)
+{
+    double best = 1e30;
+    for(int run=0; run<runs; run++)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        function();
+        best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    int rings = (argc > 1) ? atoi(argv[1]) : 1000;
+    int segments = 2 * rings;
+    int runs = 5;
+
+    Mesh mesh = generateSphere(rings, segments);
+    size_t vertexCount = mesh.positions.size() / 3;
+    size_t faceCount = mesh.indices.size() / 3;
+    cout << "Sphere with " << vertexCount << " vertices and " << faceCount << " triangles, "
+         << WorkerPool::shared().threadCount() << " threads, best of " << runs << " runs" << endl;
+
+    vector<float> reference(vertexCount * 3), normals(vertexCount * 3);
+    double scatter = bestSeconds(runs, [&]{ scatterNormals(mesh, &reference[0]); });
+    double angle = bestSeconds(runs, [&]{
+        computeSmoothNormals(&mesh.positions[0], vertexCount, &mesh.indices[0], mesh.indices.size(),
+                             NORMAL_WEIGHT_ANGLE, &normals[0]);
+    });
+    double area = bestSeconds(runs, [&]{
+        computeSmoothNormals(&mesh.positions[0], vertexCount, &mesh.indices[0], mesh.indices.size(),
+                             NORMAL_WEIGHT_AREA, &normals[0]);
+    });
+
+    // The sums are taken in a different order, so allow for rounding
+    double maxDegrees = 0.0;
+    for(size_t vertex=0; vertex<vertexCount; vertex++)
+    {
+        const float* a = &reference[3*vertex];
+        const float* b = &normals[3*vertex];
+        double cosine = min(1.0, (double)a[0]*b[0] + (double)a[1]*b[1] + (double)a[2]*b[2]);
+        maxDegrees = max(maxDegrees, acos(cosine) * 180.0 / M_PI);
+    }
+
+    printf("serial scatter          %8.2f ms  %7.1f M triangles/s\n", scatter * 1000.0, faceCount / scatter / 1e6);
+    printf("threaded, area          %8.2f ms  %7.1f M triangles/s\n", area * 1000.0, faceCount / area / 1e6);
+    printf("threaded, angle         %8.2f ms  %7.1f M triangles/s\n", angle * 1000.0, faceCount / angle / 1e6);
+    printf("area normals differ from the scatter by at most %.4f degrees\n", maxDegrees);
+
+    vector<float> tangents(vertexCount * 3), bitangents(vertexCount * 3);
+    double oldTangentSeconds = bestSeconds(runs, [&]{ oldTangents(mesh, &tangents[0], &bitangents[0]); });
+    size_t oldNaNs = countNaNVertices(tangents) + countNaNVertices(bitangents);
+    double tangentSeconds = bestSeconds(runs, [&]{
+        computeTangentFrames(&mesh.positions[0], &mesh.textureCoords[0], &normals[0], vertexCount,
+                             &mesh.indices[0], mesh.indices.size(), &tangents[0], &bitangents[0]);
+    });
+    size_t newNaNs = countNaNVertices(tangents) + countNaNVertices(bitangents);
+
+    // How far the frames are from orthonormal
+    double worstError = 0.0;
+    for(size_t vertex=0; vertex<vertexCount; vertex++)
+    {
+        const float* normal = &normals[3*vertex];
+        const float* tangent = &tangents[3*vertex];
+        const float* bitangent = &bitangents[3*vertex];
+        double errors[4] =
+        {
+            fabs(normal[0]*tangent[0] + normal[1]*tangent[1] + normal[2]*tangent[2]),
+            fabs(tangent[0]*bitangent[0] + tangent[1]*bitangent[1] + tangent[2]*bitangent[2]),
+            fabs(sqrt(tangent[0]*tangent[0] + tangent[1]*tangent[1] + tangent[2]*tangent[2]) - 1.0),
+            fabs(sqrt(bitangent[0]*bitangent[0] + bitangent[1]*bitangent[1] + bitangent[2]*bitangent[2]) - 1.0)
+        };
+        for(int i=0; i<4; i++)
+        {
+            worstError = max(worstError, errors[i]);
+        }
+    }
+
+    printf("old tangent loop        %8.2f ms  %7.1f M triangles/s, %zu NaN vectors\n", oldTangentSeconds * 1000.0,
+           faceCount / oldTangentSeconds / 1e6, oldNaNs);
+    printf("tangent frames, %-6s  %8.2f ms  %7.1f M triangles/s, %zu NaN vectors\n", meshTangentPath(),
+           tangentSeconds * 1000.0, faceCount / tangentSeconds / 1e6, newNaNs);
+    printf("tangent frames are orthonormal to within %.2g\n", worstError);
+    return 0;
+}
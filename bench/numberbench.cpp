@@ -0,0 +1,245 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+#include "objnumber.h"
+
+// NOTE: Benchmarks the OBJ number scanners on the numbers pulled out of real meshes. The float
+//       tokens from v/vt/vn records and the index tokens from f records are each packed into one
+//       space separated buffer, which every parser then walks exactly the way the OBJ loaders do.
+//       Before timing anything, every token (plus a batch of random decimals aimed at the awkward
+//       cases) is checked to come out bit-identical to strtof/strtol
+
+struct TokenBuffer
+{
+    string text;
+    size_t tokenCount;
+};
+
+static void addToken(TokenBuffer& buffer, const string& token)
+{
+    buffer.text += token;
+    buffer.text += ' ';
+    buffer.tokenCount++;
+}
+
+static void collectTokens(const string& filename, TokenBuffer& floats, TokenBuffer& ints)
+{
+    ifstream inFile(filename.c_str());
+    string line;
+    while(getline(inFile, line))
+    {
+        istringstream lineStream(line);
+        string type;
+        lineStream >> type;
+        string token;
+        if((type == "v") || (type == "vt") || (type == "vn"))
+        {
+            while(lineStream >> token)
+            {
+                addToken(floats, token);
+            }
+        }
+        else if(type == "f")
+        {
+            while(lineStream >> token)
+            {
+                // Split v/vt/vn into its indices, skipping the empty one in v//vn
+                size_t start = 0;
+                while(start <= token.size())
+                {
+                    size_t slash = token.find('/', start);
+                    if(slash == string::npos)
+                    {
+                        slash = token.size();
+                    }
+                    if(slash > start)
+                    {
+                        addToken(ints, token.substr(start, slash - start));
+                    }
+                    start = slash + 1;
+                }
+            }
+        }
+    }
+}
+
+// Random decimals in the shapes that stress the rounding: long mantissas, big and small exponents,
+// and leading/trailing zeros
+static void addRandomTokens(TokenBuffer& floats, size_t count)
+{
+    mt19937_64 random(12345);
+    char token[96];
+    for(size_t i=0; i<count; i++)
+    {
+        int integerDigits = random() % 12;
+        int fractionDigits = random() % 24;
+        int length = 0;
+        if(random() % 2)
+        {
+            token[length++] = '-';
+        }
+        for(int d=0; d<integerDigits; d++)
+        {
+            token[length++] = '0' + (random() % 10);
+        }
+        if((integerDigits == 0) || (fractionDigits > 0))
+        {
+            token[length++] = '.';
+            for(int d=0; d<fractionDigits || (integerDigits == 0 && d == 0); d++)
+            {
+                token[length++] = '0' + (random() % 10);
+            }
+        }
+        if(random() % 4 == 0)
+        {
+            length += snprintf(token + length, sizeof(token) - length, "e%d", (int)(random() % 90) - 45);
+        }
+        token[length] = '\0';
+        addToken(floats, token);
+    }
+
+    // NOTE: Exact float midpoints and their neighbours, which the double shortcut can't round alone
+    for(size_t i=0; i<count/8; i++)
+    {
+        float value = (float)(random() % 1000000) / (1 << (random() % 20));
+        double midpoint = ((double)value + (double)nextafterf(value, 1e30f)) / 2.0;
+        snprintf(token, sizeof(token), "%.17g", midpoint);
+        addToken(floats, token);
+        snprintf(token, sizeof(token), "%.25g", midpoint);
+        addToken(floats, token);
+    }
+}
+
+typedef const char* (*FloatParser)(const char*, const char*, float*);
+typedef const char* (*IntParser)(const char*, const char*, int*);
+
+// Walks the whole buffer into values, returning how many numbers were read
+template <typename Value, typename Parser>
+static size_t parseAll(const TokenBuffer& buffer, Parser parser, vector<Value>& values)
+{
+    const char* cursor = buffer.text.data();
+    const char* end = cursor + buffer.text.size();
+    size_t count = 0;
+    while(cursor < end)
+    {
+        const char* next = parser(cursor, end, &values[count]);
+        if(next == cursor)
+        {
+            break;
+        }
+        count++;
+        cursor = next + 1;
+    }
+    return count;
+}
+
+static const char* parseFloatStream(const char* cursor, const char* end, float* result)
+{
+    // What the original istream based loader did for every number
+    const char* tokenEnd = (const char*)memchr(cursor, ' ', end - cursor);
+    istringstream tokenStream(string(cursor, tokenEnd ? tokenEnd : end));
+    tokenStream >> *result;
+    return tokenEnd ? tokenEnd : end;
+}
+
+template <typename Value, typename Parser>
+static void timeParser(const char* name, const TokenBuffer& buffer, Parser parser, int repeats)
+{
+    vector<Value> values(buffer.tokenCount);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t parsed = 0;
+    for(int repeat=0; repeat<repeats; repeat++)
+    {
+        parsed += parseAll<Value>(buffer, parser, values);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double megabytes = (double)buffer.text.size() * repeats / (1024.0 * 1024.0);
+    printf("  %-12s %8.2f ns/number %9.1f MB/s   (%zu numbers)\n", name,
+           seconds * 1e9 / (double)parsed, megabytes / seconds, parsed / repeats);
+}
+
+template <typename Value, typename Parser>
+static size_t countMismatches(const TokenBuffer& buffer, Parser parser, Parser referenceParser)
+{
+    vector<Value> values(buffer.tokenCount);
+    vector<Value> referenceValues(buffer.tokenCount);
+    size_t parsed = parseAll<Value>(buffer, parser, values);
+    size_t referenceParsed = parseAll<Value>(buffer, referenceParser, referenceValues);
+    if(parsed != referenceParsed)
+    {
+        return buffer.tokenCount;
+    }
+
+    size_t mismatches = 0;
+    const char* token = buffer.text.c_str();
+    for(size_t i=0; i<parsed; i++)
+    {
+        const char* tokenEnd = strchr(token, ' ');
+        if(memcmp(&values[i], &referenceValues[i], sizeof(Value)) != 0)
+        {
+            if(mismatches < 10)
+            {
+                cout << "  mismatch on " << string(token, tokenEnd) << ": "
+                     << values[i] << " vs " << referenceValues[i] << endl;
+            }
+            mismatches++;
+        }
+        token = tokenEnd + 1;
+    }
+    return mismatches;
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        cout << "usage: " << argv[0] << " file.obj [file.obj ...]" << endl;
+        return 1;
+    }
+
+    TokenBuffer floats = {string(), 0};
+    TokenBuffer ints = {string(), 0};
+    for(int i=1; i<argc; i++)
+    {
+        collectTokens(argv[i], floats, ints);
+    }
+
+    TokenBuffer randomFloats = {string(), 0};
+    addRandomTokens(randomFloats, 200000);
+
+    cout << "Fast path: " << objNumberParserPath() << endl;
+
+    size_t floatMismatches = countMismatches<float, FloatParser>(floats, parseOBJFloat, parseOBJFloatReference);
+    size_t randomMismatches = countMismatches<float, FloatParser>(randomFloats, parseOBJFloat, parseOBJFloatReference);
+    size_t intMismatches = countMismatches<int, IntParser>(ints, parseOBJInt, parseOBJIntReference);
+    cout << "Checked " << floats.tokenCount << " mesh floats (" << floatMismatches << " mismatches), "
+         << randomFloats.tokenCount << " random floats (" << randomMismatches << " mismatches), "
+         << ints.tokenCount << " indices (" << intMismatches << " mismatches)" << endl;
+
+    // Aim for roughly the same amount of text per measurement whatever meshes were given
+    int floatRepeats = (int)(64*1024*1024 / (floats.text.size() + 1)) + 1;
+    int intRepeats = (int)(64*1024*1024 / (ints.text.size() + 1)) + 1;
+
+    cout << "Floats:" << endl;
+    timeParser<float, FloatParser>("parseOBJFloat", floats, parseOBJFloat, floatRepeats);
+    timeParser<float, FloatParser>("strtof", floats, parseOBJFloatReference, floatRepeats);
+    timeParser<float, FloatParser>("istream", floats, parseFloatStream, (floatRepeats + 9) / 10);
+    cout << "Indices:" << endl;
+    timeParser<int, IntParser>("parseOBJInt", ints, parseOBJInt, intRepeats);
+    timeParser<int, IntParser>("strtol", ints, parseOBJIntReference, intRepeats);
+
+    return (floatMismatches + randomMismatches + intMismatches == 0) ? 0 : 1;
+}
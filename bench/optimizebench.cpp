@@ -0,0 +1,84 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include <stdio.h>
+
+using namespace std;
+
+#include "geometry.h"
+#include "benchutil.h"
+#include "meshoptimize.h"
+#include "vertexformat.h"
+
+// NOTE: Runs the mesh optimization passes on every mesh given on the command line and reports what
+//       each one does to the mesh's indices: the vertex cache pass as ACMR and ATVR for a 16 entry FIFO
+//       (roughly what current GPUs behave like) before and after, plus 32 entries for comparison, and
+//       the overdraw pass as the overdraw the CPU rasterizer measures as loaded, after the cache pass
+//       and after both, with the ACMR it leaves, and the vertex fetch remap as the overfetch of the
+//       float interleaved vertex buffer as loaded, after the triangle passes and after the remap too
+
+int main(int argc, char** argv)
+{
+    if(!checkMeshArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    printf("%-28s %9s %9s   %-21s %-21s %-21s %9s   %s\n", "mesh", "triangles", "cache ms",
+           "ACMR (16) before/after", "ATVR (16) before/after", "ACMR (32) before/after", "fetch ms",
+           "overfetch loaded/sorted/remapped");
+    printf("%-28s %9s %9s   %-21s %-21s\n", "", "clusters", "sort ms", "overdraw loaded/cache/sorted",
+           "ACMR (16) after sort");
+    for(int i=1; i<argc; i++)
+    {
+        GeometryData geometry;
+        if(!loadQuietly(argv[i], geometry))
+        {
+            continue;
+        }
+        size_t vertexCount = geometry.vertexCount();
+        size_t indexCount = geometry.indexCount();
+
+        vector<unsigned int> indices((unsigned int*)geometry.indexData(), (unsigned int*)geometry.indexData() + indexCount);
+        VertexCacheStats before16 = analyzeVertexCache(&indices[0], indexCount, vertexCount, 16);
+        VertexCacheStats before32 = analyzeVertexCache(&indices[0], indexCount, vertexCount, 32);
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        optimizeVertexCache(&indices[0], indexCount, vertexCount);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        VertexCacheStats after16 = analyzeVertexCache(&indices[0], indexCount, vertexCount, 16);
+        VertexCacheStats after32 = analyzeVertexCache(&indices[0], indexCount, vertexCount, 32);
+
+        const float* positions = (const float*)geometry.vertexData();
+        OverdrawStats overdrawLoaded = analyzeOverdraw((unsigned int*)geometry.indexData(), indexCount, positions, vertexCount);
+        OverdrawStats overdrawCache = analyzeOverdraw(&indices[0], indexCount, positions, vertexCount);
+        start = chrono::steady_clock::now();
+        size_t clusterCount = optimizeOverdraw(&indices[0], indexCount, positions, vertexCount);
+        double sortSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        OverdrawStats overdrawSorted = analyzeOverdraw(&indices[0], indexCount, positions, vertexCount);
+        VertexCacheStats sorted16 = analyzeVertexCache(&indices[0], indexCount, vertexCount, 16);
+
+        size_t vertexSize = interleavedVertexFormat(geometry.vertexAttributes()).stride;
+        VertexFetchStats fetchLoaded = analyzeVertexFetch((unsigned int*)geometry.indexData(), indexCount, vertexCount, vertexSize);
+        VertexFetchStats fetchSorted = analyzeVertexFetch(&indices[0], indexCount, vertexCount, vertexSize);
+
+        // Only the indices are needed to measure the remap, the vertex arrays would follow them
+        start = chrono::steady_clock::now();
+        vector<unsigned int> remap(vertexCount);
+        size_t usedVertexCount = buildVertexFetchRemap(&indices[0], indexCount, vertexCount, &remap[0]);
+        remapIndices(&indices[0], indexCount, &remap[0]);
+        double fetchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        VertexFetchStats fetchRemapped = analyzeVertexFetch(&indices[0], indexCount, usedVertexCount, vertexSize);
+
+        printf("%-28s %9zu %9.2f   %8.3f / %-10.3f %8.3f / %-10.3f %8.3f / %-10.3f %9.2f   %.3f / %.3f / %.3f\n",
+               argv[i], indexCount / 3, seconds * 1000.0, before16.acmr, after16.acmr, before16.atvr, after16.atvr,
+               before32.acmr, after32.acmr, fetchSeconds * 1000.0, fetchLoaded.overfetch, fetchSorted.overfetch,
+               fetchRemapped.overfetch);
+        printf("%-28s %9zu %9.2f   %8.3f / %.3f / %-8.3f %8.3f\n", "", clusterCount, sortSeconds * 1000.0,
+               overdrawLoaded.overdraw, overdrawCache.overdraw, overdrawSorted.overdraw, sorted16.acmr);
+    }
+    return 0;
+}
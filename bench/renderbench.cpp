@@ -0,0 +1,291 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include <stdio.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace std;
+
+#include "headlessgl.h"
+#include "geometry.h"
+#include "glvertexformat.h"
+
+// NOTE: Draws every mesh given on the command line with its vertex attributes in separate buffers
+//       (struct of arrays, one VBO per attribute like the loaders keep them), interleaved into one
+//       buffer (array of structs) and interleaved and packed the way the app packs them, and times the
+//       upload and the draws. The shader reads every attribute the mesh has so that none of them can
+//       be optimised away, and the framebuffer is kept small so the time goes on fetching and shading
+//       vertices rather than filling pixels. The packing error of each packing option is reported too
+
+static const int framebufferSize = 128;
+
+static const char* vertexShaderSource =
+    "#version 330 core\n"
+    "in vec3 position;\n"
+    "in vec2 texCoord;\n"
+    "in vec3 normal;\n"
+    "in vec3 tangent;\n"
+    "in vec3 bitangent;\n"
+    "uniform mat4 MVP;\n"
+    "uniform vec3 positionScale;\n"
+    "uniform vec3 positionOffset;\n"
+    "out vec3 shade;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = MVP * vec4(position * positionScale + positionOffset, 1);\n"
+    "    shade = (normal * 0.5 + 0.5) + 0.1 * (tangent + bitangent + vec3(texCoord, 0));\n"
+    "}\n";
+
+static const char* fragmentShaderSource =
+    "#version 330 core\n"
+    "in vec3 shade;\n"
+    "out vec4 outColor;\n"
+    "void main()\n"
+    "{\n"
+    "    outColor = vec4(shade, 1);\n"
+    "}\n";
+
+// Same packing as the app, except for the octahedral row of the error report
+static const VertexPacking benchVertexPacking =
+{
+    VERTEX_ENCODING_UNORM16_BOUNDS, VERTEX_ENCODING_HALF, VERTEX_ENCODING_SNORM_10_10_10_2
+};
+
+struct MeshBuffers
+{
+    GLuint vao;
+    vector<GLuint> vertexBuffers;
+    GLuint indexBuffer;
+    VertexFormat format;
+};
+
+static void uploadIndices(GeometryData& geometry, MeshBuffers& mesh)
+{
+    glGenBuffers(1, &mesh.indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, geometry.indexCount() * sizeof(unsigned int),
+                 geometry.indexData(), GL_STATIC_DRAW);
+}
+
+static MeshBuffers uploadSeparate(GeometryData& geometry, unsigned int attributes,
+                                  const GLint locations[VERTEX_ATTRIBUTE_COUNT])
+{
+    MeshBuffers mesh;
+    mesh.format = interleavedVertexFormat(attributes);
+    glGenVertexArrays(1, &mesh.vao);
+    glBindVertexArray(mesh.vao);
+
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        if(!(attributes & vertexAttributeBit((VertexAttribute)attribute)))
+        {
+            continue;
+        }
+
+        // A one attribute format per buffer, applied to just that attribute's location
+        VertexFormat format = interleavedVertexFormat(vertexAttributeBit((VertexAttribute)attribute));
+        GLint singleLocation[VERTEX_ATTRIBUTE_COUNT] = {-1, -1, -1, -1, -1};
+        singleLocation[attribute] = locations[attribute];
+
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, geometry.vertexCount() * format.stride,
+                     geometry.attributeData((VertexAttribute)attribute), GL_STATIC_DRAW);
+        applyVertexFormat(format, singleLocation);
+        mesh.vertexBuffers.push_back(buffer);
+    }
+
+    uploadIndices(geometry, mesh);
+    return mesh;
+}
+
+static MeshBuffers uploadInterleaved(GeometryData& geometry, const VertexFormat& format,
+                                     const GLint locations[VERTEX_ATTRIBUTE_COUNT])
+{
+    MeshBuffers mesh;
+    mesh.format = format;
+    glGenVertexArrays(1, &mesh.vao);
+    glBindVertexArray(mesh.vao);
+
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, geometry.vertexCount() * format.stride, 0, GL_STATIC_DRAW);
+    void* bufferData = glMapBufferRange(GL_ARRAY_BUFFER, 0, geometry.vertexCount() * format.stride,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    geometry.writeInterleavedVertices(format, bufferData);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    applyVertexFormat(format, locations);
+    mesh.vertexBuffers.push_back(buffer);
+
+    uploadIndices(geometry, mesh);
+    return mesh;
+}
+
+static void deleteMesh(MeshBuffers& mesh)
+{
+    glDeleteBuffers(mesh.vertexBuffers.size(), &mesh.vertexBuffers[0]);
+    glDeleteBuffers(1, &mesh.indexBuffer);
+    glDeleteVertexArrays(1, &mesh.vao);
+}
+
+// Draws the mesh drawCount times and returns the seconds it took, once the GPU has finished
+static double timeDraws(GLuint program, const MeshBuffers& mesh, int indexCount, int drawCount)
+{
+    glBindVertexArray(mesh.vao);
+    applyPositionDequantization(program, mesh.format);
+    glFinish();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    for(int draw=0; draw<drawCount; draw++)
+    {
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    }
+    glFinish();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Scales the mesh to fill the view, whatever units it was modelled in
+static glm::mat4 fitMeshTransform(GeometryData& geometry)
+{
+    const MeshBounds& bounds = geometry.bounds();
+    glm::vec3 centre(bounds.centre[0], bounds.centre[1], bounds.centre[2]);
+    float radius = std::max(bounds.radius, 1e-6f);
+    return glm::ortho(-radius, radius, -radius, radius, -radius, radius) * glm::translate(glm::mat4(1.0f), -centre);
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        cout << "usage: " << argv[0] << " file.obj [file.obj ...]" << endl;
+        return 1;
+    }
+
+    if(!createHeadlessContext(framebufferSize, framebufferSize))
+    {
+        return 1;
+    }
+
+    GLuint program = compileProgram(vertexShaderSource, fragmentShaderSource);
+    if(!program)
+    {
+        return 1;
+    }
+    glUseProgram(program);
+    GLint locations[VERTEX_ATTRIBUTE_COUNT];
+    getVertexAttributeLocations(program, locations);
+    GLint mvpLocation = glGetUniformLocation(program, "MVP");
+    glEnable(GL_DEPTH_TEST);
+
+    vector<string> rows;
+    vector<string> packingRows;
+    for(int i=1; i<argc; i++)
+    {
+        GeometryData geometry;
+        geometry.loadFromOBJFile(argv[i]);
+        if(geometry.indexCount() == 0)
+        {
+            continue;
+        }
+
+        glm::mat4 mvp = fitMeshTransform(geometry);
+        glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, &mvp[0][0]);
+
+        unsigned int attributes = geometry.vertexAttributes() & usedVertexAttributes(locations);
+        VertexFormat floatFormat = interleavedVertexFormat(attributes);
+        VertexFormat packedFormat = packedVertexFormat(attributes, benchVertexPacking, geometry.bounds());
+
+        // Roughly the same number of vertices per measurement whatever the mesh size, although the
+        // per draw overhead still dominates for the tiny meshes
+        int drawCount = std::min(std::max(3, 2000000 / geometry.indexCount()), 500);
+
+        MeshBuffers meshes[3];
+        double uploadSeconds[3];
+        double drawSeconds[3] = {0.0, 0.0, 0.0};
+        for(int layout=0; layout<3; layout++)
+        {
+            chrono::steady_clock::time_point uploadStart = chrono::steady_clock::now();
+            meshes[layout] = (layout == 0) ? uploadSeparate(geometry, attributes, locations) :
+                             uploadInterleaved(geometry, (layout == 1) ? floatFormat : packedFormat, locations);
+            glFinish();
+            uploadSeconds[layout] = chrono::duration<double>(chrono::steady_clock::now() - uploadStart).count();
+            timeDraws(program, meshes[layout], geometry.indexCount(), 1);
+        }
+
+        // Alternate between the layouts so that none of them gets an unfair share of any slow patch
+        for(int round=0; round<3; round++)
+        {
+            for(int layout=0; layout<3; layout++)
+            {
+                drawSeconds[layout] += timeDraws(program, meshes[layout], geometry.indexCount(), drawCount);
+            }
+        }
+        double drawnIndices = 3.0 * drawCount * geometry.indexCount();
+
+        char row[512];
+        snprintf(row, sizeof(row),
+                 "%-28s %8d %4zu %3zu B %3zu B %7.2f %7.2f %7.2f %9.2f %9.2f %9.2f",
+                 argv[i], geometry.vertexCount(), meshes[0].vertexBuffers.size(), floatFormat.stride,
+                 packedFormat.stride, uploadSeconds[0] * 1000.0, uploadSeconds[1] * 1000.0,
+                 uploadSeconds[2] * 1000.0, drawSeconds[0] * 1e9 / drawnIndices,
+                 drawSeconds[1] * 1e9 / drawnIndices, drawSeconds[2] * 1e9 / drawnIndices);
+        rows.push_back(row);
+
+        // Packing error for each of the position and direction encodings
+        const void* sources[VERTEX_ATTRIBUTE_COUNT];
+        for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+        {
+            sources[attribute] = geometry.attributeData((VertexAttribute)attribute);
+        }
+        const VertexPacking packings[2] =
+        {
+            benchVertexPacking,
+            {VERTEX_ENCODING_HALF_BOUNDS, VERTEX_ENCODING_HALF, VERTEX_ENCODING_OCTAHEDRAL_SNORM16}
+        };
+        const char* packingNames[2] = {"unorm16/half/10_10_10_2", "halfbox/half/octahedral"};
+        for(int packing=0; packing<2; packing++)
+        {
+            unsigned int everything = geometry.vertexAttributes();
+            VertexFormat format = packedVertexFormat(everything, packings[packing], geometry.bounds());
+            VertexPackingError error = measurePackingError(format, sources, geometry.vertexCount());
+            snprintf(row, sizeof(row), "%-28s %-24s %3zu B %3zu B %10.3g %10.3g %10.3g %9.4f %9.4f",
+                     argv[i], packingNames[packing], interleavedVertexFormat(everything).stride, format.stride,
+                     error.maxPositionError, error.rmsPositionError, error.maxTexCoordError,
+                     error.maxDirectionDegrees, error.meanDirectionDegrees);
+            packingRows.push_back(row);
+        }
+
+        for(int layout=0; layout<3; layout++)
+        {
+            deleteMesh(meshes[layout]);
+        }
+        if(glGetError() != GL_NO_ERROR)
+        {
+            cout << "OpenGL error while benchmarking " << argv[i] << endl;
+        }
+    }
+
+    cout << endl;
+    cout << "mesh                         vertices vbos float packed  SoA up  AoS up  pkd up SoA ns/idx AoS ns/idx pkd ns/idx" << endl;
+    for(size_t row=0; row<rows.size(); row++)
+    {
+        cout << rows[row] << endl;
+    }
+    cout << endl;
+    cout << "mesh                         packing                  float packed  max pos    rms pos     max uv   max deg  mean deg" << endl;
+    for(size_t row=0; row<packingRows.size(); row++)
+    {
+        cout << packingRows[row] << endl;
+    }
+
+    glDeleteProgram(program);
+    destroyHeadlessContext();
+    return 0;
+}
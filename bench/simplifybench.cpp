@@ -0,0 +1,54 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <stdio.h>
+
+using namespace std;
+
+#include "geometry.h"
+#include "benchutil.h"
+#include "meshsimplify.h"
+
+// NOTE: Builds the default LOD chain for every mesh given on the command line and reports, for each
+//       level, the triangles it ended up with against the ones asked for, how long the chain had taken
+//       when the level was done, and its geometric error, in model units and as a fraction of the
+//       mesh's bounding sphere radius so that meshes modelled at different scales can be compared
+
+int main(int argc, char** argv)
+{
+    if(!checkMeshArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    printf("%-28s %5s %9s %9s %9s %12s %9s\n", "mesh", "level", "triangles", "asked for", "total ms",
+           "error", "% radius");
+    for(int i=1; i<argc; i++)
+    {
+        GeometryData geometry;
+        if(!loadQuietly(argv[i], geometry))
+        {
+            continue;
+        }
+        size_t indexCount = geometry.indexCount();
+
+        vector<unsigned int> lodIndices;
+        MeshLOD levels[defaultLODLevelCount];
+        double levelSeconds[defaultLODLevelCount];
+        simplifyMeshLODs((const unsigned int*)geometry.indexData(), indexCount, (const float*)geometry.vertexData(),
+                         geometry.vertexCount(), defaultLODRatios, defaultLODLevelCount, lodIndices, levels,
+                         levelSeconds);
+
+        float radius = max(geometry.bounds().radius, 1e-6f);
+        printf("%-28s %5d %9zu %9s %9s %12s %9s\n", argv[i], 0, indexCount / 3, "", "", "", "");
+        for(int level=0; level<defaultLODLevelCount; level++)
+        {
+            printf("%-28s %5d %9u %9zu %9.2f %12.4g %9.3f\n", "", level + 1, levels[level].indexCount / 3,
+                   (size_t)(indexCount / 3 * defaultLODRatios[level]), levelSeconds[level] * 1000.0,
+                   levels[level].error, levels[level].error / radius * 100.0f);
+        }
+    }
+    return 0;
+}
@@ -1,6 +1,6 @@
 #version 330 core
 
-uniform vec3 objectColor;
+flat in vec3 objectColor;
 
 out vec4 outColor;
 
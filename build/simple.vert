@@ -2,10 +2,21 @@
 
 layout(location = 0) in vec3 position;
 
-// Values that stay constant for the whole mesh.
-uniform mat4 MVP;
+// Values that stay constant for the whole instance: where the object is and its color.
+in mat4 instanceTransform;
+in vec4 instanceColor;
+
+// Values that stay constant for the whole frame.
+uniform mat4 ViewProjection;
+
+// Positions may be stored quantized inside the mesh bounds, this maps them back to model space
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
+flat out vec3 objectColor;
 
 void main()
 {
-    gl_Position = MVP * vec4(position,1);
+    gl_Position = ViewProjection * instanceTransform * vec4(position * positionScale + positionOffset, 1);
+    objectColor = instanceColor.rgb;
 }
@@ -1,12 +1,30 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
 
 #include <math.h>
+#include <stdio.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define OBJ_PRESCAN_SSE2
+#endif
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 
 using namespace std;
 
 #include "geometry.h"
+#include "mappedfile.h"
+#include "workerpool.h"
+#include "processstats.h"
+#include "objnumber.h"
+#include "meshnormals.h"
 
 // NOTE: The WaveFront OBJ format spec, states that meshes are allowed to be defined by faces
 //       consisting of 3 or more vertices. For the purposes of this loader (and since this is the
@@ -21,6 +39,131 @@ using namespace std;
 // NOTE: There is currently no support for mtl material references or anything like that,
 //       just load whatever texture you want to use manually
 
+// NOTE: Identifies one unique v/vt/vn combination while we're building the indexed vertex arrays
+struct VertexKey
+{
+    int vertexIndex;
+    int texCoordIndex;
+    int normalIndex;
+
+    bool operator==(const VertexKey& other) const
+    {
+        return (vertexIndex == other.vertexIndex) &&
+               (texCoordIndex == other.texCoordIndex) &&
+               (normalIndex == other.normalIndex);
+    }
+};
+
+struct VertexKeyHash
+{
+    size_t operator()(const VertexKey& key) const
+    {
+        uint64_t hash = (uint32_t)key.vertexIndex;
+        hash = (hash * 0x9E3779B97F4A7C15ull) ^ (uint32_t)key.texCoordIndex;
+        hash = (hash * 0x9E3779B97F4A7C15ull) ^ (uint32_t)key.normalIndex;
+        return (size_t)(hash ^ (hash >> 29));
+    }
+};
+
+// NOTE: Maps v/vt/vn triples to output vertex indices. This is a single flat array with linear
+//       probing rather than an unordered_map, so that deduplicating costs one allocation up front
+//       instead of one per unique vertex. Slots with index == emptySlot are unused
+class VertexKeyTable
+{
+public:
+    struct Slot
+    {
+        VertexKey key;
+        unsigned int index;
+    };
+
+    static const unsigned int emptySlot = 0xFFFFFFFF;
+
+    VertexKeyTable(size_t expectedCount, OBJLoadStats* stats)
+        : usedCount(0), stats(stats)
+    {
+        resize(expectedCount);
+    }
+
+    // Returns the index that was already assigned to key, or assigns it newIndex
+    unsigned int findOrInsert(const VertexKey& key, unsigned int newIndex, bool* inserted)
+    {
+        size_t slotIndex = VertexKeyHash()(key) & slotMask;
+        for(;;)
+        {
+            Slot& slot = slots[slotIndex];
+            if(slot.index == emptySlot)
+            {
+                break;
+            }
+            if(slot.key == key)
+            {
+                *inserted = false;
+                return slot.index;
+            }
+            slotIndex = (slotIndex + 1) & slotMask;
+        }
+
+        slots[slotIndex].key = key;
+        slots[slotIndex].index = newIndex;
+        *inserted = true;
+
+        // Keep the table at most half full so that probe sequences stay short
+        usedCount++;
+        if(usedCount*2 > slots.size())
+        {
+            resize(usedCount*2);
+        }
+        return newIndex;
+    }
+
+    size_t slotCount()
+    {
+        return slots.size();
+    }
+
+    const Slot& slot(size_t slotIndex)
+    {
+        return slots[slotIndex];
+    }
+
+private:
+    void resize(size_t expectedCount)
+    {
+        size_t slotCount = 16;
+        while(slotCount < expectedCount*2)
+        {
+            slotCount *= 2;
+        }
+
+        vector<Slot> oldSlots;
+        oldSlots.swap(slots);
+        Slot empty = {{0, 0, 0}, emptySlot};
+        slots.assign(slotCount, empty);
+        slotMask = slotCount - 1;
+        stats->allocationCount++;
+        stats->bytesCopied += usedCount * sizeof(Slot);
+
+        for(size_t oldIndex=0; oldIndex<oldSlots.size(); oldIndex++)
+        {
+            if(oldSlots[oldIndex].index != emptySlot)
+            {
+                size_t slotIndex = VertexKeyHash()(oldSlots[oldIndex].key) & slotMask;
+                while(slots[slotIndex].index != emptySlot)
+                {
+                    slotIndex = (slotIndex + 1) & slotMask;
+                }
+                slots[slotIndex] = oldSlots[oldIndex];
+            }
+        }
+    }
+
+    vector<Slot> slots;
+    size_t slotMask;
+    size_t usedCount;
+    OBJLoadStats* stats;
+};
+
 enum OBJDataType
 {
     NONE,
@@ -31,18 +174,51 @@ enum OBJDataType
     COMMENT
 };
 
-void GeometryData::loadFromOBJFile(string filename)
+// NOTE: OBJ indices are 1-based, and negative ones count back from the most recent record, so -1
+//       is the last record read before the face. recordCount is how many there were at that point.
+//       An index of 0 comes out as -1, the same as a missing texture coord or normal, and a relative
+//       index that reaches back past the first record comes out as invalidOBJIndex, which no range
+//       check accepts
+static const int invalidOBJIndex = INT_MIN;
+
+static inline int resolveOBJIndex(int index, size_t recordCount)
 {
-    GeometryData tempGeom;
+    if(index >= 0)
+    {
+        return index - 1;
+    }
+    long long resolved = (long long)recordCount + index;
+    return (resolved >= 0) ? (int)resolved : invalidOBJIndex;
+}
 
-    ifstream inStream;
-    inStream.open(filename, ifstream::in);
-    if(inStream.fail())
+// Positions are required, texture coords and normals can be left out (-1)
+static inline bool faceIndicesInRange(const FaceData& face, size_t vertexCount, size_t texCoordCount,
+                                      size_t normalCount)
+{
+    for(int index=0; index<3; index++)
     {
-        cout << "Unable to open obj file: " << filename << endl;
-        return;
+        if((face.vertexIndex[index] < 0) || ((size_t)face.vertexIndex[index] >= vertexCount) ||
+           (face.texCoordIndex[index] < -1) || (face.texCoordIndex[index] >= (long long)texCoordCount) ||
+           (face.normalIndex[index] < -1) || (face.normalIndex[index] >= (long long)normalCount))
+        {
+            return false;
+        }
     }
+    return true;
+}
 
+// NOTE: A number that doesn't fit in an int leaves the stream failed, which would stall every later
+//       read, so the fail flag is cleared here and the saturated value is left for the range check
+static int readOBJIndex(istream& inStream)
+{
+    int index = 0;
+    inStream >> index;
+    inStream.clear(inStream.rdstate() & ~ios::failbit);
+    return index;
+}
+
+void GeometryData::parseOBJStream(istream& inStream)
+{
     OBJDataType currentDataType = NONE;
     while(!inStream.eof())
     {
@@ -104,9 +280,9 @@ void GeometryData::loadFromOBJFile(string filename)
             float y;
             float z;
             inStream >> x >> y >> z;
-            tempGeom.vertices.push_back(x);
-            tempGeom.vertices.push_back(y);
-            tempGeom.vertices.push_back(z);
+            vertices.push_back(x);
+            vertices.push_back(y);
+            vertices.push_back(z);
             currentDataType = COMMENT;
         } break;
 
@@ -115,8 +291,8 @@ void GeometryData::loadFromOBJFile(string filename)
             float u;
             float v;
             inStream >> u >> v;
-            tempGeom.textureCoords.push_back(u);
-            tempGeom.textureCoords.push_back(v);
+            textureCoords.push_back(u);
+            textureCoords.push_back(v);
             currentDataType = COMMENT;
         } break;
 
@@ -126,9 +302,9 @@ void GeometryData::loadFromOBJFile(string filename)
             float y;
             float z;
             inStream >> x >> y >> z;
-            tempGeom.normals.push_back(x);
-            tempGeom.normals.push_back(y);
-            tempGeom.normals.push_back(z);
+            normals.push_back(x);
+            normals.push_back(y);
+            normals.push_back(z);
             currentDataType = COMMENT;
         } break;
 
@@ -142,7 +318,7 @@ void GeometryData::loadFromOBJFile(string filename)
             FaceData face = {};
             for(int index=0; index<3; index++)
             {
-                inStream >> vertIndex;
+                vertIndex = readOBJIndex(inStream);
                 char postVertexCheckChar = inStream.get();
                 if(postVertexCheckChar == '/')
                 {
@@ -150,26 +326,29 @@ void GeometryData::loadFromOBJFile(string filename)
                     inStream.unget();
                     if(texCoordExistCheckChar != '/')
                     {
-                        inStream >> texCoordIndex;
+                        texCoordIndex = readOBJIndex(inStream);
                     }
 
                     char postTexCoordCheckChar = inStream.get();
                     if(postTexCoordCheckChar == '/')
                     {
-                        inStream >> normalIndex;
+                        normalIndex = readOBJIndex(inStream);
                     }
                     else
                     {
                         inStream.unget(); // This is just to prevent us from consuming a newline
                     }
                 }
-                
-                // NOTE: We subtract 1 here because the OBJ format uses 1-based indices
-                face.vertexIndex[index] = vertIndex - 1;
-                face.texCoordIndex[index] = texCoordIndex - 1;
-                face.normalIndex[index] = normalIndex - 1;
+                else if(!inStream.eof())
+                {
+                    inStream.unget(); // Same for a face with positions only
+                }
+
+                face.vertexIndex[index] = resolveOBJIndex(vertIndex, vertices.size()/3);
+                face.texCoordIndex[index] = resolveOBJIndex(texCoordIndex, textureCoords.size()/2);
+                face.normalIndex[index] = resolveOBJIndex(normalIndex, normals.size()/3);
             }
-            tempGeom.faces.push_back(face);
+            faces.push_back(face);
             currentDataType = COMMENT;
         } break;
 
@@ -186,103 +365,864 @@ void GeometryData::loadFromOBJFile(string filename)
         {}
         }
     }
+}
+
+// NOTE: The scanners below work on a (cursor, end) pointer range into the mapped file rather than
+//       on a stream. The buffer is not null-terminated, so every read has to be checked against end.
+//       Each scanner returns the position just after whatever it consumed, and leaves the cursor
+//       where it was if there was nothing it could parse. The number scanners live in objnumber.cpp
+
+static inline const char* skipSpaces(const char* cursor, const char* end)
+{
+    while((cursor < end) && ((*cursor == ' ') || (*cursor == '\t') || (*cursor == '\r')))
+    {
+        cursor++;
+    }
+    return cursor;
+}
+
+static inline const char* skipLine(const char* cursor, const char* end)
+{
+    const char* newline = (const char*)memchr(cursor, '\n', end - cursor);
+    return newline ? newline+1 : end;
+}
+
+struct OBJRecordCounts
+{
+    size_t vertices;
+    size_t textureCoords;
+    size_t normals;
+    size_t faces;
+};
+
+// Classifies the single line starting at cursor the same way parseOBJBuffer would
+static inline void countOBJLine(const char* cursor, const char* end, OBJRecordCounts* counts)
+{
+    cursor = skipSpaces(cursor, end);
+    if((cursor < end) && (*cursor == 'f'))
+    {
+        counts->faces++;
+    }
+    else if((cursor+1 < end) && (cursor[0] == 'v'))
+    {
+        if((cursor[1] == ' ') || (cursor[1] == '\t'))
+        {
+            counts->vertices++;
+        }
+        else if(cursor[1] == 't')
+        {
+            counts->textureCoords++;
+        }
+        else if(cursor[1] == 'n')
+        {
+            counts->normals++;
+        }
+    }
+}
+
+static inline int countBits(unsigned int bits)
+{
+    bits = bits - ((bits >> 1) & 0x55555555);
+    bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+    return (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+// NOTE: Counts the v/vt/vn/f records in a range that starts at the beginning of a line, so that
+//       every array can be allocated at its final size before parsing. With SSE2 this looks at 16
+//       bytes at a time, and for every newline checks the (up to) two characters after it with
+//       byte-wise compares, so the common case never branches per line. Only lines that start with
+//       whitespace drop back to the scalar check
+static void countOBJRecords(const char* begin, const char* end, OBJRecordCounts* counts)
+{
+    if(begin >= end)
+    {
+        return;
+    }
+    countOBJLine(begin, end, counts);
+
+    const char* cursor = begin;
+#ifdef OBJ_PRESCAN_SSE2
+    const __m128i newlineChar = _mm_set1_epi8('\n');
+    const __m128i vChar = _mm_set1_epi8('v');
+    const __m128i fChar = _mm_set1_epi8('f');
+    const __m128i tChar = _mm_set1_epi8('t');
+    const __m128i nChar = _mm_set1_epi8('n');
+    const __m128i spaceChar = _mm_set1_epi8(' ');
+    const __m128i tabChar = _mm_set1_epi8('\t');
+    const __m128i returnChar = _mm_set1_epi8('\r');
+    for(; cursor+18 <= end; cursor += 16)
+    {
+        __m128i bytes0 = _mm_loadu_si128((const __m128i*)cursor);
+        __m128i newlines = _mm_cmpeq_epi8(bytes0, newlineChar);
+        if(_mm_movemask_epi8(newlines) == 0)
+        {
+            continue;
+        }
+
+        // bytes1/bytes2 line up the first and second character of each line with its newline
+        __m128i bytes1 = _mm_loadu_si128((const __m128i*)(cursor+1));
+        __m128i bytes2 = _mm_loadu_si128((const __m128i*)(cursor+2));
+        __m128i vLines = _mm_and_si128(newlines, _mm_cmpeq_epi8(bytes1, vChar));
+        __m128i secondIsBlank = _mm_or_si128(_mm_cmpeq_epi8(bytes2, spaceChar), _mm_cmpeq_epi8(bytes2, tabChar));
+        __m128i firstIsBlank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes1, spaceChar),
+                                                         _mm_cmpeq_epi8(bytes1, tabChar)),
+                                            _mm_cmpeq_epi8(bytes1, returnChar));
+
+        counts->vertices += countBits(_mm_movemask_epi8(_mm_and_si128(vLines, secondIsBlank)));
+        counts->textureCoords += countBits(_mm_movemask_epi8(_mm_and_si128(vLines, _mm_cmpeq_epi8(bytes2, tChar))));
+        counts->normals += countBits(_mm_movemask_epi8(_mm_and_si128(vLines, _mm_cmpeq_epi8(bytes2, nChar))));
+        counts->faces += countBits(_mm_movemask_epi8(_mm_and_si128(newlines, _mm_cmpeq_epi8(bytes1, fChar))));
+
+        unsigned int indentedLines = _mm_movemask_epi8(_mm_and_si128(newlines, firstIsBlank));
+        while(indentedLines)
+        {
+            int offset = 0;
+            while(!(indentedLines & (1u << offset)))
+            {
+                offset++;
+            }
+            countOBJLine(cursor + offset + 1, end, counts);
+            indentedLines &= indentedLines - 1;
+        }
+    }
+#endif
+
+    for(; cursor < end; cursor++)
+    {
+        if(*cursor == '\n')
+        {
+            countOBJLine(cursor+1, end, counts);
+        }
+    }
+}
+
+// NOTE: Every growth of one of the loader's arrays goes through these, so that we can report how
+//       often we allocated and how many bytes reallocation had to copy
+template<typename T>
+static inline void reserveTracked(vector<T>& values, size_t count, OBJLoadStats* stats)
+{
+    if(count > values.capacity())
+    {
+        stats->allocationCount++;
+        stats->bytesCopied += values.size() * sizeof(T);
+        values.reserve(count);
+    }
+}
+
+template<typename T>
+static inline void appendTracked(vector<T>& values, const T* first, size_t count, OBJLoadStats* stats)
+{
+    if(values.size() + count > values.capacity())
+    {
+        stats->allocationCount++;
+        stats->bytesCopied += values.size() * sizeof(T);
+    }
+    values.insert(values.end(), first, first+count);
+}
+
+// NOTE: recordsBefore is how many v/vt/vn records came before cursor, for resolving relative
+//       indices, which get counted from the end of this buffer's records plus those. Returns true if
+//       there were any. With firstForwardFace given, each face is also checked against the records
+//       read before it, and that gets the index in faces of the first one that refers past them (or
+//       faces.size() if none did)
+bool GeometryData::parseOBJBuffer(const char* cursor, const char* end, ostream& log,
+                                  const OBJRecordCounts& recordsBefore, size_t* firstForwardFace)
+{
+    bool usedRelativeIndices = false;
+    bool foundForwardFace = false;
+    while(cursor < end)
+    {
+        // Skip leading whitespace, including any blank lines
+        while((cursor < end) && ((*cursor == ' ') || (*cursor == '\t') ||
+                                 (*cursor == '\r') || (*cursor == '\n')))
+        {
+            cursor++;
+        }
+        if(cursor >= end)
+        {
+            break;
+        }
+
+        char typeChar1 = cursor[0];
+        char typeChar2 = (cursor+1 < end) ? cursor[1] : '\n';
+        if(typeChar1 == '#')
+        {
+        }
+        else if(typeChar1 == 'f')
+        {
+            // NOTE: Here is where we assume that exactly 3 vertices are used to specify a face
+            FaceData face = {};
+            cursor++;
+            for(int index=0; index<3; index++)
+            {
+                int vertIndex = 0;
+                int texCoordIndex = 0;
+                int normalIndex = 0;
+
+                cursor = parseOBJInt(skipSpaces(cursor, end), end, &vertIndex);
+                if((cursor < end) && (*cursor == '/'))
+                {
+                    // NOTE: parseOBJInt leaves the cursor alone for the v//vn case
+                    cursor = parseOBJInt(cursor+1, end, &texCoordIndex);
+                    if((cursor < end) && (*cursor == '/'))
+                    {
+                        cursor = parseOBJInt(cursor+1, end, &normalIndex);
+                    }
+                }
+
+                face.vertexIndex[index] = resolveOBJIndex(vertIndex, recordsBefore.vertices + vertices.size()/3);
+                face.texCoordIndex[index] = resolveOBJIndex(texCoordIndex,
+                                                            recordsBefore.textureCoords + textureCoords.size()/2);
+                face.normalIndex[index] = resolveOBJIndex(normalIndex, recordsBefore.normals + normals.size()/3);
+                usedRelativeIndices |= ((vertIndex < 0) || (texCoordIndex < 0) || (normalIndex < 0));
+            }
+            if(firstForwardFace && !foundForwardFace &&
+               !faceIndicesInRange(face, recordsBefore.vertices + vertices.size()/3,
+                                   recordsBefore.textureCoords + textureCoords.size()/2,
+                                   recordsBefore.normals + normals.size()/3))
+            {
+                *firstForwardFace = faces.size();
+                foundForwardFace = true;
+            }
+            appendTracked(faces, &face, 1, &stats);
+        }
+        else if(typeChar1 != 'v')
+        {
+            log << "OBJ parse error: Expected 'v', 'f' or '#' at the start of the line" << endl;
+            log << "Found: " << typeChar1 << typeChar2 << endl;
+        }
+        else if((typeChar2 == ' ') || (typeChar2 == '\t'))
+        {
+            float position[3] = {};
+            cursor += 2;
+            for(int i=0; i<3; i++)
+            {
+                cursor = parseOBJFloat(skipSpaces(cursor, end), end, &position[i]);
+            }
+            appendTracked(vertices, position, 3, &stats);
+        }
+        else if(typeChar2 == 't')
+        {
+            float uv[2] = {};
+            cursor += 2;
+            for(int i=0; i<2; i++)
+            {
+                cursor = parseOBJFloat(skipSpaces(cursor, end), end, &uv[i]);
+            }
+            appendTracked(textureCoords, uv, 2, &stats);
+        }
+        else if(typeChar2 == 'n')
+        {
+            float normal[3] = {};
+            cursor += 2;
+            for(int i=0; i<3; i++)
+            {
+                cursor = parseOBJFloat(skipSpaces(cursor, end), end, &normal[i]);
+            }
+            appendTracked(normals, normal, 3, &stats);
+        }
+        else if(typeChar2 == 'p')
+        {
+            log << "OBJ parse error: Free-form geometry is not supported, ignoring" << endl;
+        }
+        else
+        {
+            log << "Unsupported data entry v" << (char)typeChar2 << ", ignoring" << endl;
+        }
+
+        // Whatever is left on the line (w-coordinates, extra face vertices, comments) is ignored
+        cursor = skipLine(cursor, end);
+    }
+    if(firstForwardFace && !foundForwardFace)
+    {
+        *firstForwardFace = faces.size();
+    }
+    return usedRelativeIndices;
+}
+
+void GeometryData::reserveRecords(size_t vertexCount, size_t texCoordCount, size_t normalCount, size_t faceCount)
+{
+    reserveTracked(vertices, vertexCount*3, &stats);
+    reserveTracked(textureCoords, texCoordCount*2, &stats);
+    reserveTracked(normals, normalCount*3, &stats);
+    reserveTracked(faces, faceCount, &stats);
+}
+
+// NOTE: Below this many bytes per chunk, waking the workers and merging costs more than it saves
+static const size_t minimumChunkSize = 256*1024;
+
+void GeometryData::parseOBJBufferParallel(const char* begin, const char* end, bool prescan)
+{
+    WorkerPool& pool = WorkerPool::shared();
+
+    size_t totalSize = end - begin;
+    size_t chunkCount = pool.threadCount() * 4;
+    if(totalSize / minimumChunkSize < chunkCount)
+    {
+        chunkCount = (totalSize / minimumChunkSize > 0) ? (totalSize / minimumChunkSize) : 1;
+    }
+
+    // Split the file into roughly equal chunks, then push each split point forward to the start of
+    // the next line so that every record lands entirely inside one chunk
+    vector<const char*> chunkStarts(chunkCount+1);
+    chunkStarts[0] = begin;
+    chunkStarts[chunkCount] = end;
+    for(size_t chunkIndex=1; chunkIndex<chunkCount; chunkIndex++)
+    {
+        const char* split = begin + (totalSize * chunkIndex) / chunkCount;
+        if(split < chunkStarts[chunkIndex-1])
+        {
+            split = chunkStarts[chunkIndex-1];
+        }
+        if((split > begin) && (split[-1] != '\n'))
+        {
+            split = skipLine(split, end);
+        }
+        chunkStarts[chunkIndex] = split;
+    }
+
+    vector<GeometryData> chunks(chunkCount);
+    vector<ostringstream> chunkLogs(chunkCount);
+    vector<char> chunkUsedRelativeIndices(chunkCount, 0);
+    OBJRecordCounts noRecords = {};
+    pool.run(chunkCount, [&](int chunkIndex)
+    {
+        GeometryData& chunk = chunks[chunkIndex];
+        if(prescan)
+        {
+            OBJRecordCounts counts = {};
+            countOBJRecords(chunkStarts[chunkIndex], chunkStarts[chunkIndex+1], &counts);
+            chunk.reserveRecords(counts.vertices, counts.textureCoords, counts.normals, counts.faces);
+        }
+        chunkUsedRelativeIndices[chunkIndex] = chunk.parseOBJBuffer(chunkStarts[chunkIndex], chunkStarts[chunkIndex+1],
+                                                                    chunkLogs[chunkIndex], noRecords);
+    });
+
+    // NOTE: Once resolved, face indices are absolute, so chunks can be merged by plain concatenation.
+    //       A prefix sum over each chunk's record counts gives the offset it gets copied to, which
+    //       keeps everything in file order and identical to what the serial parser produces
+    vector<size_t> vertexOffsets(chunkCount+1, 0);
+    vector<size_t> texCoordOffsets(chunkCount+1, 0);
+    vector<size_t> normalOffsets(chunkCount+1, 0);
+    vector<size_t> faceOffsets(chunkCount+1, 0);
+    for(size_t chunkIndex=0; chunkIndex<chunkCount; chunkIndex++)
+    {
+        vertexOffsets[chunkIndex+1] = vertexOffsets[chunkIndex] + chunks[chunkIndex].vertices.size();
+        texCoordOffsets[chunkIndex+1] = texCoordOffsets[chunkIndex] + chunks[chunkIndex].textureCoords.size();
+        normalOffsets[chunkIndex+1] = normalOffsets[chunkIndex] + chunks[chunkIndex].normals.size();
+        faceOffsets[chunkIndex+1] = faceOffsets[chunkIndex] + chunks[chunkIndex].faces.size();
+    }
+
+    // NOTE: Relative indices can't be resolved until a chunk knows how many records came before it,
+    //       so any chunk past the first that used them is parsed again now that the offsets are
+    //       known. Files almost never use them, and the record counts don't change the second time
+    vector<int> reparsedChunks;
+    for(size_t chunkIndex=1; chunkIndex<chunkCount; chunkIndex++)
+    {
+        if(chunkUsedRelativeIndices[chunkIndex])
+        {
+            reparsedChunks.push_back(chunkIndex);
+        }
+    }
+    if(!reparsedChunks.empty())
+    {
+        pool.run(reparsedChunks.size(), [&](int reparseIndex)
+        {
+            int chunkIndex = reparsedChunks[reparseIndex];
+            OBJRecordCounts recordsBefore = {vertexOffsets[chunkIndex]/3, texCoordOffsets[chunkIndex]/2,
+                                             normalOffsets[chunkIndex]/3, faceOffsets[chunkIndex]};
+            chunks[chunkIndex] = GeometryData();
+            chunkLogs[chunkIndex].str("");
+            chunks[chunkIndex].parseOBJBuffer(chunkStarts[chunkIndex], chunkStarts[chunkIndex+1],
+                                              chunkLogs[chunkIndex], recordsBefore);
+        });
+    }
+
+    for(size_t chunkIndex=0; chunkIndex<chunkCount; chunkIndex++)
+    {
+        stats.allocationCount += chunks[chunkIndex].stats.allocationCount;
+        stats.bytesCopied += chunks[chunkIndex].stats.bytesCopied;
+    }
+    reserveRecords(vertexOffsets[chunkCount]/3, texCoordOffsets[chunkCount]/2,
+                   normalOffsets[chunkCount]/3, faceOffsets[chunkCount]);
+    vertices.resize(vertexOffsets[chunkCount]);
+    textureCoords.resize(texCoordOffsets[chunkCount]);
+    normals.resize(normalOffsets[chunkCount]);
+    faces.resize(faceOffsets[chunkCount]);
+    pool.run(chunkCount, [&](int chunkIndex)
+    {
+        GeometryData& chunk = chunks[chunkIndex];
+        copy(chunk.vertices.begin(), chunk.vertices.end(), vertices.begin() + vertexOffsets[chunkIndex]);
+        copy(chunk.textureCoords.begin(), chunk.textureCoords.end(),
+             textureCoords.begin() + texCoordOffsets[chunkIndex]);
+        copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + normalOffsets[chunkIndex]);
+        copy(chunk.faces.begin(), chunk.faces.end(), faces.begin() + faceOffsets[chunkIndex]);
+    });
+
+    // The chunks' diagnostics are held back until now so that they come out in file order
+    for(size_t chunkIndex=0; chunkIndex<chunkCount; chunkIndex++)
+    {
+        cout << chunkLogs[chunkIndex].str();
+    }
+}
+
+bool GeometryData::loadFromOBJFile(string filename, OBJLoadMode mode, bool prescan)
+{
+    GeometryData tempGeom;
+
+    chrono::steady_clock::time_point parseStart = chrono::steady_clock::now();
+    size_t fileSize = 0;
+    if(mode == OBJ_LOAD_STREAM)
+    {
+        ifstream inStream;
+        inStream.open(filename, ifstream::in | ifstream::binary);
+        if(inStream.fail())
+        {
+            cout << "Unable to open obj file: " << filename << endl;
+            return false;
+        }
+        inStream.seekg(0, ifstream::end);
+        fileSize = (size_t)inStream.tellg();
+        inStream.seekg(0, ifstream::beg);
+
+        tempGeom.parseOBJStream(inStream);
+    }
+    else
+    {
+        MappedFile file;
+        if(!file.open(filename))
+        {
+            cout << "Unable to open obj file: " << filename << endl;
+            return false;
+        }
+        fileSize = file.size();
 
+        if(mode == OBJ_LOAD_PARALLEL)
+        {
+            tempGeom.parseOBJBufferParallel(file.data(), file.data() + file.size(), prescan);
+        }
+        else
+        {
+            if(prescan)
+            {
+                OBJRecordCounts counts = {};
+                countOBJRecords(file.data(), file.data() + file.size(), &counts);
+                tempGeom.reserveRecords(counts.vertices, counts.textureCoords, counts.normals, counts.faces);
+            }
+            OBJRecordCounts noRecords = {};
+            tempGeom.parseOBJBuffer(file.data(), file.data() + file.size(), cout, noRecords);
+        }
+    }
+    chrono::steady_clock::time_point parseEnd = chrono::steady_clock::now();
+
+    size_t positionRecordCount = tempGeom.vertices.size()/3;
+    size_t texCoordRecordCount = tempGeom.textureCoords.size()/2;
+    size_t normalRecordCount = tempGeom.normals.size()/3;
+    for(size_t faceIndex=0; faceIndex<tempGeom.faces.size(); faceIndex++)
+    {
+        if(!faceIndicesInRange(tempGeom.faces[faceIndex], positionRecordCount, texCoordRecordCount,
+                               normalRecordCount))
+        {
+            cout << "OBJ parse error: Face " << faceIndex+1 << " of " << filename
+                 << " refers to a record that does not exist" << endl;
+            return false;
+        }
+    }
+    stats = tempGeom.stats;
 
     // NOTE: Since our rendering pipeline supports only 1 set of indices for our data, we need to
-    //       do some post-processing here in order to lay out all the unique v/vt/vn triples
-    // TODO: We're currently just assuming all the triples are distinct, but its probably worth doing
-    //       at least a little bit of checking on that front
-    // TODO: We're deciding whether or not to add texture coords and normals on a per-face basis,
-    //       which doesn't really make sense because if there are any then there should be for all
-    //       vertices, but this way that might not be the case
-    for(int faceIndex=0; faceIndex<tempGeom.faces.size(); faceIndex++)
-    {
-        FaceData face = tempGeom.faces[faceIndex];
-        bool hasTextureCoords = (face.texCoordIndex[0] >= 0);
-        bool hasNormals = (face.normalIndex[0] >= 0);
+    //       do some post-processing here in order to lay out all the unique v/vt/vn triples. Each
+    //       triple gets one output vertex the first time it is seen, and every later reference to
+    //       the same triple just reuses its index
+    // NOTE: Whether the mesh has texture coords and normals is decided once, from the first face,
+    //       so that the attribute arrays always stay parallel to each other. Corners that are
+    //       missing an attribute the rest of the mesh has get zeros for it
+    bool hasTextureCoords = !tempGeom.faces.empty() && (tempGeom.faces[0].texCoordIndex[0] >= 0);
+    bool hasNormals = !tempGeom.faces.empty() && (tempGeom.faces[0].normalIndex[0] >= 0);
+
+    // NOTE: Meshes without vn records get smooth normals generated for them instead. With texture
+    //       coords, one position can end up in several vertices (along a UV seam), so the normals are
+    //       worked out per position record and then copied to its vertices, which keeps the seams
+    //       out of the shading. positionRecords maps each vertex back to its record for that
+    bool generateNormals = !hasNormals && !tempGeom.faces.empty();
+    vector<unsigned int> positionRecords;
+
+    // There are usually about as many unique vertices as there are records of the most common
+    // attribute, and never more than there are face corners
+    size_t cornerCount = tempGeom.faces.size()*3;
+    size_t expectedVertexCount = max(tempGeom.vertices.size()/3,
+                                     max(tempGeom.textureCoords.size()/2, tempGeom.normals.size()/3));
+    expectedVertexCount = min(cornerCount, expectedVertexCount + expectedVertexCount/4);
+
+    VertexKeyTable uniqueVertices(expectedVertexCount, &stats);
+    reserveTracked(indices, cornerCount, &stats);
+    unsigned int uniqueVertexCount = 0;
+    for(size_t faceIndex=0; faceIndex<tempGeom.faces.size(); faceIndex++)
+    {
+        const FaceData& face = tempGeom.faces[faceIndex];
         for(int vertIndex=0; vertIndex<3; vertIndex++)
+        {
+            VertexKey key = {face.vertexIndex[vertIndex],
+                             hasTextureCoords ? face.texCoordIndex[vertIndex] : -1,
+                             hasNormals ? face.normalIndex[vertIndex] : -1};
+
+            bool inserted;
+            indices.push_back(uniqueVertices.findOrInsert(key, uniqueVertexCount, &inserted));
+            if(inserted)
+            {
+                uniqueVertexCount++;
+            }
+        }
+    }
+
+    // Now that we know exactly how many vertices there are, each attribute array is allocated once
+    // and every unique triple is copied straight into its slot
+    reserveTracked(vertices, uniqueVertexCount*3, &stats);
+    vertices.resize(uniqueVertexCount*3);
+    if(hasTextureCoords)
+    {
+        reserveTracked(textureCoords, uniqueVertexCount*2, &stats);
+        textureCoords.resize(uniqueVertexCount*2);
+    }
+    if(hasNormals)
+    {
+        reserveTracked(normals, uniqueVertexCount*3, &stats);
+        normals.resize(uniqueVertexCount*3);
+    }
+    if(generateNormals && hasTextureCoords)
+    {
+        positionRecords.resize(uniqueVertexCount);
+    }
+    for(size_t slotIndex=0; slotIndex<uniqueVertices.slotCount(); slotIndex++)
+    {
+        const VertexKeyTable::Slot& slot = uniqueVertices.slot(slotIndex);
+        if(slot.index == VertexKeyTable::emptySlot)
+        {
+            continue;
+        }
+
+        const VertexKey& key = slot.key;
+        for(int i=0; i<3; i++)
+        {
+            vertices[(3*slot.index)+i] = tempGeom.vertices[(3*key.vertexIndex)+i];
+        }
+        if(!positionRecords.empty())
+        {
+            positionRecords[slot.index] = key.vertexIndex;
+        }
+        if(hasTextureCoords)
+        {
+            for(int i=0; i<2; i++)
+            {
+                textureCoords[(2*slot.index)+i] = (key.texCoordIndex >= 0) ?
+                        tempGeom.textureCoords[(2*key.texCoordIndex)+i] : 0.0f;
+            }
+        }
+        if(hasNormals)
         {
             for(int i=0; i<3; i++)
             {
-                vertices.push_back(tempGeom.vertices[(3*face.vertexIndex[vertIndex])+i]);
+                normals[(3*slot.index)+i] = (key.normalIndex >= 0) ?
+                        tempGeom.normals[(3*key.normalIndex)+i] : 0.0f;
             }
+        }
+    }
+    chrono::steady_clock::time_point indexEnd = chrono::steady_clock::now();
 
-            if(hasTextureCoords)
+    if(generateNormals)
+    {
+        reserveTracked(normals, uniqueVertexCount*3, &stats);
+        normals.resize(uniqueVertexCount*3);
+        if(positionRecords.empty())
+        {
+            // Without texture coords every vertex is a distinct position already
+            computeSmoothNormals(&vertices[0], uniqueVertexCount, &indices[0], indices.size(),
+                                 NORMAL_WEIGHT_AREA, &normals[0]);
+        }
+        else
+        {
+            size_t positionCount = tempGeom.vertices.size()/3;
+            vector<unsigned int> positionIndices(indices.size());
+            for(size_t corner=0; corner<indices.size(); corner++)
             {
-                for(int i=0; i<2; i++)
-                {
-                    textureCoords.push_back(
-                            tempGeom.textureCoords[(2*face.texCoordIndex[vertIndex])+i]);
-                }
+                positionIndices[corner] = positionRecords[indices[corner]];
             }
-            if(hasNormals)
+            vector<float> positionNormals(positionCount*3);
+            computeSmoothNormals(&tempGeom.vertices[0], positionCount, &positionIndices[0], positionIndices.size(),
+                                 NORMAL_WEIGHT_AREA, &positionNormals[0]);
+            for(size_t vertex=0; vertex<uniqueVertexCount; vertex++)
             {
                 for(int i=0; i<3; i++)
                 {
-                    normals.push_back(tempGeom.normals[(3*face.normalIndex[vertIndex])+i]);
+                    normals[(3*vertex)+i] = positionNormals[(3*positionRecords[vertex])+i];
                 }
             }
         }
+        hasNormals = true;
+    }
+    chrono::steady_clock::time_point normalEnd = chrono::steady_clock::now();
+
+    // NOTE: Every face's tangent and bitangent is accumulated into the vertices it shares with its
+    //       neighbours, and then each vertex's frame is made orthonormal around its normal (see
+    //       computeTangentFrames). Faces with degenerate texture coords don't take part
+    if(hasTextureCoords && hasNormals)
+    {
+        reserveTracked(tangents, vertices.size(), &stats);
+        reserveTracked(bitangents, vertices.size(), &stats);
+        tangents.resize(vertices.size());
+        bitangents.resize(vertices.size());
+        computeTangentFrames(&vertices[0], &textureCoords[0], &normals[0], uniqueVertexCount,
+                             &indices[0], indices.size(), &tangents[0], &bitangents[0]);
+    }
+
+    chrono::steady_clock::time_point tangentEnd = chrono::steady_clock::now();
+
+    meshBounds = computeMeshBounds(vertices.data(), uniqueVertexCount);
+
+    stats.fileBytes = fileSize;
+    stats.parseSeconds = chrono::duration<double>(parseEnd - parseStart).count();
+    stats.indexSeconds = chrono::duration<double>(indexEnd - parseEnd).count();
+    stats.normalSeconds = chrono::duration<double>(normalEnd - indexEnd).count();
+    stats.tangentSeconds = chrono::duration<double>(tangentEnd - normalEnd).count();
+
+    double megabyte = 1024.0 * 1024.0;
+    double fileMegabytes = fileSize / megabyte;
+    cout << "Successfully loaded an OBJ with " << uniqueVertexCount << " vertices and "
+         << cornerCount/3 << " triangles" << endl;
+    cout << "Deduplicated " << cornerCount << " face corners into " << uniqueVertexCount
+         << " vertices (" << ((uniqueVertexCount > 0) ? (double)cornerCount/uniqueVertexCount : 0.0)
+         << ":1)" << endl;
+    cout << "Parsed " << fileMegabytes << " MB in " << stats.parseSeconds*1000.0 << " ms ("
+         << ((stats.parseSeconds > 0.0) ? fileMegabytes/stats.parseSeconds : 0.0) << " MB/s)" << endl;
+    if(generateNormals)
+    {
+        cout << "Generated smooth normals in " << stats.normalSeconds*1000.0 << " ms" << endl;
+    }
+    cout << "Loader arrays were allocated " << stats.allocationCount << " times, with "
+         << stats.bytesCopied/megabyte << " MB copied by reallocation" << endl;
+    return true;
+}
+
+// NOTE: Reads a file in fixed-size pieces and hands them out as spans that always end on a line
+//       boundary, carrying a partial last line over to the front of the next piece. The buffer only
+//       grows if a single line is longer than the whole thing
+class LineChunkReader
+{
+public:
+    LineChunkReader(FILE* file, size_t bufferSize)
+        : file(file), buffer(bufferSize), filledSize(0), consumedSize(0)
+    {
+    }
 
-        // Compute the (bi)tangent for the face, and add it for each vertex
-        if(hasTextureCoords && hasNormals)
+    bool nextChunk(const char** chunkStart, const char** chunkEnd)
+    {
+        size_t leftoverSize = filledSize - consumedSize;
+        memmove(&buffer[0], &buffer[consumedSize], leftoverSize);
+        filledSize = leftoverSize;
+        consumedSize = 0;
+
+        for(;;)
         {
-            int vertexStartIndex = vertices.size() - 9;
-            int uvStartIndex = textureCoords.size() - 6;
-            float* vertices = &this->vertices[vertexStartIndex];
-            float* texCoords = &textureCoords[uvStartIndex];
+            filledSize += fread(&buffer[filledSize], 1, buffer.size() - filledSize, file);
+            bool reachedEnd = (filledSize < buffer.size());
+            if(filledSize == 0)
+            {
+                return false;
+            }
 
-            float deltaX1 = vertices[3] - vertices[0];
-            float deltaY1 = vertices[4] - vertices[1];
-            float deltaZ1 = vertices[5] - vertices[2];
-            float deltaX2 = vertices[6] - vertices[0];
-            float deltaY2 = vertices[7] - vertices[1];
-            float deltaZ2 = vertices[8] - vertices[2];
+            // The last line of the file is allowed to end without a newline
+            size_t lineEnd = filledSize;
+            if(!reachedEnd)
+            {
+                while((lineEnd > 0) && (buffer[lineEnd-1] != '\n'))
+                {
+                    lineEnd--;
+                }
+            }
 
-            float deltaU1 = texCoords[2] - texCoords[0];
-            float deltaV1 = texCoords[3] - texCoords[1];
-            float deltaU2 = texCoords[4] - texCoords[0];
-            float deltaV2 = texCoords[5] - texCoords[1];
+            if(lineEnd > 0)
+            {
+                *chunkStart = &buffer[0];
+                *chunkEnd = &buffer[0] + lineEnd;
+                consumedSize = lineEnd;
+                return true;
+            }
+            buffer.resize(buffer.size() * 2);
+        }
+    }
 
-            float inverseDet = 1.0f / (deltaU1*deltaV2 - deltaU2*deltaV1);
+    size_t bufferBytes()
+    {
+        return buffer.capacity();
+    }
 
-            float tangentX = inverseDet * (deltaV2*deltaX1 - deltaV1*deltaX2);
-            float tangentY = inverseDet * (deltaV2*deltaY1 - deltaV1*deltaY2);
-            float tangentZ = inverseDet * (deltaV2*deltaZ1 - deltaV1*deltaZ2);
+private:
+    FILE* file;
+    vector<char> buffer;
+    size_t filledSize;
+    size_t consumedSize;
+};
+
+template<typename T>
+static size_t vectorBytes(const vector<T>& values)
+{
+    return values.capacity() * sizeof(T);
+}
+
+bool GeometryData::streamFromOBJFile(string filename, VertexBlockSink& sink, size_t blockSize,
+                                     OBJStreamStats* stats)
+{
+    FILE* file = fopen(filename.c_str(), "rb");
+    if(!file)
+    {
+        cout << "Unable to open obj file: " << filename << endl;
+        return false;
+    }
+    bool peakWasReset = resetPeakResidentBytes();
+
+    // First pass: count every kind of record, so that the attribute pools can be allocated exactly
+    // once and the sink knows up front how many vertices are coming
+    OBJRecordCounts counts = {};
+    const char* chunkStart;
+    const char* chunkEnd;
+    {
+        LineChunkReader reader(file, blockSize);
+        while(reader.nextChunk(&chunkStart, &chunkEnd))
+        {
+            countOBJRecords(chunkStart, chunkEnd, &counts);
+        }
+    }
+    rewind(file);
 
-            float bitangentX = inverseDet * (deltaU1*deltaX2 - deltaU2*deltaX1);
-            float bitangentY = inverseDet * (deltaU1*deltaY2 - deltaU2*deltaY1);
-            float bitangentZ = inverseDet * (deltaU1*deltaZ2 - deltaU2*deltaZ1);
+    // NOTE: Output vertices are interleaved as position, then texture coord, then normal, leaving out
+    //       whichever of the last two the file has no records for at all
+    bool hasTextureCoords = (counts.textureCoords > 0);
+    bool hasNormals = (counts.normals > 0);
+    int floatsPerVertex = 3 + (hasTextureCoords ? 2 : 0) + (hasNormals ? 3 : 0);
 
-            float tangentLength = sqrt(tangentX*tangentX +
-                                       tangentY*tangentY +
-                                       tangentZ*tangentZ);
-            float bitangentLength = sqrt(bitangentX*bitangentX +
-                                         bitangentY*bitangentY +
-                                         bitangentZ*bitangentZ);
+    // Blocks always hold whole triangles
+    size_t blockVertexCount = (blockSize / (floatsPerVertex * sizeof(float))) / 3 * 3;
+    if(blockVertexCount < 3)
+    {
+        blockVertexCount = 3;
+    }
+
+    // NOTE: Faces can refer back to any earlier v/vt/vn record, so those have to be kept for the
+    //       whole load, but everything that grows with the face count only ever lives in one block
+    GeometryData pools;
+    pools.vertices.reserve(counts.vertices * 3);
+    pools.textureCoords.reserve(counts.textureCoords * 2);
+    pools.normals.reserve(counts.normals * 3);
+
+    vector<float> block;
+    block.reserve(blockVertexCount * floatsPerVertex);
 
-            tangentX /= tangentLength;
-            tangentY /= tangentLength;
-            tangentZ /= tangentLength;
-            bitangentX /= bitangentLength;
-            bitangentY /= bitangentLength;
-            bitangentZ /= bitangentLength;
+    sink.beginVertices(counts.faces * 3, floatsPerVertex);
+
+    GeometryData chunkData;
+    LineChunkReader reader(file, blockSize);
+    size_t streamedVertexCount = 0;
+    size_t readFaceCount = 0;
+    int blockCount = 0;
+    size_t peakLoaderBytes = 0;
+    while(reader.nextChunk(&chunkStart, &chunkEnd))
+    {
+        // NOTE: Faces are checked as they are parsed, against just the records before them, so
+        //       whether a file loads doesn't depend on where the chunks happen to be split
+        OBJRecordCounts recordsBefore = {pools.vertices.size()/3, pools.textureCoords.size()/2,
+                                         pools.normals.size()/3, readFaceCount};
+        size_t firstForwardFace = 0;
+        chunkData.parseOBJBuffer(chunkStart, chunkEnd, cout, recordsBefore, &firstForwardFace);
+        if(firstForwardFace < chunkData.faces.size())
+        {
+            cout << "OBJ parse error: Face " << readFaceCount + firstForwardFace + 1 << " of " << filename
+                 << " refers to a record that does not come before it" << endl;
+            fclose(file);
+            return false;
+        }
+        readFaceCount += chunkData.faces.size();
+        pools.vertices.insert(pools.vertices.end(), chunkData.vertices.begin(), chunkData.vertices.end());
+        pools.textureCoords.insert(pools.textureCoords.end(),
+                                   chunkData.textureCoords.begin(), chunkData.textureCoords.end());
+        pools.normals.insert(pools.normals.end(), chunkData.normals.begin(), chunkData.normals.end());
 
-            // NOTE: Each vertex in the face gets the same (bi)tangent pair
+        for(size_t faceIndex=0; faceIndex<chunkData.faces.size(); faceIndex++)
+        {
+            const FaceData& face = chunkData.faces[faceIndex];
             for(int vertIndex=0; vertIndex<3; vertIndex++)
             {
-                tangents.push_back(tangentX);
-                tangents.push_back(tangentY);
-                tangents.push_back(tangentZ);
+                for(int i=0; i<3; i++)
+                {
+                    block.push_back(pools.vertices[(3*face.vertexIndex[vertIndex])+i]);
+                }
+                if(hasTextureCoords)
+                {
+                    int texCoordIndex = face.texCoordIndex[vertIndex];
+                    for(int i=0; i<2; i++)
+                    {
+                        block.push_back((texCoordIndex >= 0) ? pools.textureCoords[(2*texCoordIndex)+i] : 0.0f);
+                    }
+                }
+                if(hasNormals)
+                {
+                    int normalIndex = face.normalIndex[vertIndex];
+                    for(int i=0; i<3; i++)
+                    {
+                        block.push_back((normalIndex >= 0) ? pools.normals[(3*normalIndex)+i] : 0.0f);
+                    }
+                }
+            }
 
-                bitangents.push_back(bitangentX);
-                bitangents.push_back(bitangentY);
-                bitangents.push_back(bitangentZ);
+            if(block.size() == blockVertexCount * floatsPerVertex)
+            {
+                sink.consumeVertices(&block[0], streamedVertexCount, blockVertexCount);
+                streamedVertexCount += blockVertexCount;
+                blockCount++;
+                block.clear();
             }
         }
+
+        size_t loaderBytes = vectorBytes(pools.vertices) + vectorBytes(pools.textureCoords) +
+                             vectorBytes(pools.normals) + vectorBytes(block) +
+                             vectorBytes(chunkData.vertices) + vectorBytes(chunkData.textureCoords) +
+                             vectorBytes(chunkData.normals) + vectorBytes(chunkData.faces) +
+                             reader.bufferBytes();
+        peakLoaderBytes = max(peakLoaderBytes, loaderBytes);
+
+        chunkData.vertices.clear();
+        chunkData.textureCoords.clear();
+        chunkData.normals.clear();
+        chunkData.faces.clear();
     }
+    fclose(file);
 
-    cout << "Successfully loaded an OBJ with " << vertices.size()/3 << " vertices " << endl;
+    if(!block.empty())
+    {
+        size_t remainingVertexCount = block.size() / floatsPerVertex;
+        sink.consumeVertices(&block[0], streamedVertexCount, remainingVertexCount);
+        streamedVertexCount += remainingVertexCount;
+        blockCount++;
+    }
+
+    size_t poolBytes = vectorBytes(pools.vertices) + vectorBytes(pools.textureCoords) + vectorBytes(pools.normals);
+    size_t peakResident = peakResidentBytes();
+    double megabyte = 1024.0 * 1024.0;
+    cout << "Streamed an OBJ with " << streamedVertexCount << " vertices in " << blockCount
+         << " blocks of up to " << blockVertexCount << " vertices" << endl;
+    cout << "Peak loader memory: " << peakLoaderBytes/megabyte << " MB (attribute pools "
+         << poolBytes/megabyte << " MB, block size " << blockSize/megabyte << " MB), peak RSS "
+         << (peakWasReset ? "during load: " : "for the process: ") << peakResident/megabyte << " MB" << endl;
+
+    if(stats)
+    {
+        stats->vertexCount = streamedVertexCount;
+        stats->blockCount = blockCount;
+        stats->peakLoaderBytes = peakLoaderBytes;
+        stats->attributePoolBytes = poolBytes;
+        stats->peakResidentBytes = peakResident;
+        stats->peakCoversLoadOnly = peakWasReset;
+    }
+    return true;
 }
 
 int GeometryData::vertexCount()
@@ -290,6 +1230,196 @@ int GeometryData::vertexCount()
     return vertices.size()/3;
 }
 
+int GeometryData::indexCount()
+{
+    return indices.size();
+}
+
+void* GeometryData::indexData()
+{
+    return (void*)&indices[0];
+}
+
+const OBJLoadStats& GeometryData::loadStats()
+{
+    return stats;
+}
+
+const MeshBounds& GeometryData::bounds()
+{
+    return meshBounds;
+}
+
+int GeometryData::lodLevelCount()
+{
+    return lods.size();
+}
+
+const MeshLOD* GeometryData::lodLevels()
+{
+    return lods.empty() ? 0 : &lods[0];
+}
+
+int GeometryData::lodIndexCount()
+{
+    return lodIndices.size();
+}
+
+void* GeometryData::lodIndexData()
+{
+    return lodIndices.empty() ? 0 : (void*)&lodIndices[0];
+}
+
+MeshletTable GeometryData::meshlets()
+{
+    return meshletTable(meshletData.empty() ? 0 : &meshletData[0], meshletCount);
+}
+
+void GeometryData::optimize(unsigned int optimizations, const float* lodRatios, int lodLevelCount)
+{
+    if(indices.empty())
+    {
+        return;
+    }
+
+    size_t uniqueVertexCount = vertices.size() / 3;
+    size_t vertexSize = interleavedVertexFormat(vertexAttributes()).stride;
+    VertexFetchStats fetchBefore = analyzeVertexFetch(&indices[0], indices.size(), uniqueVertexCount, vertexSize);
+
+    // NOTE: The LODs are simplified from the mesh as loaded, since triangle order makes no difference
+    //       to them, and then go through the same passes as the full mesh, one level at a time
+    lodIndices.clear();
+    lods.clear();
+    if((optimizations & MESH_OPTIMIZE_LOD_CHAIN) && (lodLevelCount > 0))
+    {
+        lodLevelCount = min(lodLevelCount, maxLODLevels);
+        lods.resize(lodLevelCount);
+        double levelSeconds[maxLODLevels];
+        simplifyMeshLODs(&indices[0], indices.size(), &vertices[0], uniqueVertexCount, lodRatios, lodLevelCount,
+                         lodIndices, &lods[0], levelSeconds);
+        for(int level=0; level<lodLevelCount; level++)
+        {
+            cout << "LOD " << level + 1 << ": " << lods[level].indexCount/3 << " of " << indices.size()/3
+                 << " triangles (asked for " << lodRatios[level]*100.0f << "%), error " << lods[level].error
+                 << " (" << lods[level].error / max(meshBounds.radius, 1e-6f) * 100.0f << "% of the radius) after "
+                 << levelSeconds[level]*1000.0 << " ms" << endl;
+        }
+    }
+
+    // NOTE: Triangle order goes first, then the clusters are sorted for overdraw (which keeps the order
+    //       within each one), and the vertex order follows whatever order the triangles end up in
+    if(optimizations & MESH_OPTIMIZE_VERTEX_CACHE)
+    {
+        VertexCacheStats before = analyzeVertexCache(&indices[0], indices.size(), uniqueVertexCount);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        optimizeVertexCache(&indices[0], indices.size(), uniqueVertexCount);
+        for(size_t level=0; level<lods.size(); level++)
+        {
+            optimizeVertexCache(&lodIndices[lods[level].firstIndex], lods[level].indexCount, uniqueVertexCount);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        VertexCacheStats after = analyzeVertexCache(&indices[0], indices.size(), uniqueVertexCount);
+        cout << "Reordered triangles for the vertex cache in " << seconds*1000.0 << " ms, ACMR "
+             << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << endl;
+    }
+
+    if(optimizations & MESH_OPTIMIZE_OVERDRAW)
+    {
+        OverdrawStats before = analyzeOverdraw(&indices[0], indices.size(), &vertices[0], uniqueVertexCount);
+        VertexCacheStats cacheBefore = analyzeVertexCache(&indices[0], indices.size(), uniqueVertexCount);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        size_t clusterCount = optimizeOverdraw(&indices[0], indices.size(), &vertices[0], uniqueVertexCount);
+        for(size_t level=0; level<lods.size(); level++)
+        {
+            optimizeOverdraw(&lodIndices[lods[level].firstIndex], lods[level].indexCount, &vertices[0], uniqueVertexCount);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        OverdrawStats after = analyzeOverdraw(&indices[0], indices.size(), &vertices[0], uniqueVertexCount);
+        VertexCacheStats cacheAfter = analyzeVertexCache(&indices[0], indices.size(), uniqueVertexCount);
+        cout << "Sorted " << clusterCount << " triangle clusters for overdraw in " << seconds*1000.0
+             << " ms, overdraw " << before.overdraw << " -> " << after.overdraw << ", ACMR " << cacheBefore.acmr
+             << " -> " << cacheAfter.acmr << endl;
+    }
+
+    // NOTE: Meshlets grow from seeds taken in index order, so they come out in much the order the
+    //       passes above left the triangles in, with each one's triangles in the order they were taken
+    meshletData.clear();
+    meshletCount = 0;
+    if(optimizations & MESH_OPTIMIZE_MESHLETS)
+    {
+        VertexCacheStats cacheBefore = analyzeVertexCache(&indices[0], indices.size(), uniqueVertexCount);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        meshletCount = buildMeshlets(&indices[0], indices.size(), &vertices[0], uniqueVertexCount, meshletData);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        VertexCacheStats cacheAfter = analyzeVertexCache(&indices[0], indices.size(), uniqueVertexCount);
+        MeshletStats meshletStats = analyzeMeshlets(meshlets());
+        cout << "Split the mesh into " << meshletCount << " meshlets in " << seconds*1000.0 << " ms, "
+             << meshletStats.vertexFill*100.0f << "% vertex fill, " << meshletStats.triangleFill*100.0f
+             << "% triangle fill, " << meshletStats.coneCullable*100.0f << "% with a cullable normal cone, ACMR "
+             << cacheBefore.acmr << " -> " << cacheAfter.acmr << endl;
+    }
+
+    if(optimizations & MESH_OPTIMIZE_VERTEX_FETCH)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        vector<unsigned int> remap(uniqueVertexCount);
+        size_t usedVertexCount = buildVertexFetchRemap(&indices[0], indices.size(), uniqueVertexCount, &remap[0]);
+        remapIndices(&indices[0], indices.size(), &remap[0]);
+
+        // the LODs only use vertices the full mesh does, so none of theirs get dropped
+        if(!lodIndices.empty())
+        {
+            remapIndices(&lodIndices[0], lodIndices.size(), &remap[0]);
+        }
+
+        vector<float>* streams[] = {&vertices, &textureCoords, &normals, &tangents, &bitangents};
+        for(size_t stream=0; stream<sizeof(streams)/sizeof(streams[0]); stream++)
+        {
+            vector<float>& source = *streams[stream];
+            if(source.empty())
+            {
+                continue;
+            }
+            int components = source.size() / uniqueVertexCount;
+            vector<float> remapped(usedVertexCount * components);
+            remapVertexStream(&remapped[0], &source[0], uniqueVertexCount, components, &remap[0]);
+            source.swap(remapped);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        // dropping unreferenced vertices can shrink the bounds
+        if(usedVertexCount < uniqueVertexCount)
+        {
+            meshBounds = computeMeshBounds(vertices.data(), usedVertexCount);
+        }
+
+        VertexFetchStats fetchAfter = analyzeVertexFetch(&indices[0], indices.size(), usedVertexCount, vertexSize);
+        cout << "Reordered vertices by first use in " << seconds*1000.0 << " ms, " << (uniqueVertexCount - usedVertexCount)
+             << " unused vertices dropped, overfetch " << fetchBefore.overfetch << " -> " << fetchAfter.overfetch
+             << " at " << vertexSize << " bytes per vertex" << endl;
+    }
+    else
+    {
+        VertexFetchStats fetch = analyzeVertexFetch(&indices[0], indices.size(), uniqueVertexCount, vertexSize);
+        cout << "Vertex fetch overfetch " << fetch.overfetch << " at " << vertexSize << " bytes per vertex" << endl;
+    }
+}
+
+bool GeometryData::hasTextureCoords()
+{
+    return !textureCoords.empty();
+}
+
+bool GeometryData::hasNormals()
+{
+    return !normals.empty();
+}
+
+bool GeometryData::hasTangents()
+{
+    return !tangents.empty();
+}
+
 void* GeometryData::vertexData()
 {
     return (void*)&vertices[0];
@@ -314,3 +1444,48 @@ void* GeometryData::bitangentData()
 {
     return (void*)&bitangents[0];
 }
+
+unsigned int GeometryData::vertexAttributes()
+{
+    unsigned int attributes = vertexAttributeBit(VERTEX_POSITION);
+    if(hasTextureCoords())
+    {
+        attributes |= vertexAttributeBit(VERTEX_TEXTURE_COORD);
+    }
+    if(hasNormals())
+    {
+        attributes |= vertexAttributeBit(VERTEX_NORMAL);
+    }
+    if(hasTangents())
+    {
+        attributes |= vertexAttributeBit(VERTEX_TANGENT) | vertexAttributeBit(VERTEX_BITANGENT);
+    }
+    return attributes;
+}
+
+const void* GeometryData::attributeData(VertexAttribute attribute)
+{
+    switch(attribute)
+    {
+    case VERTEX_POSITION:
+        return vertices.data();
+    case VERTEX_TEXTURE_COORD:
+        return textureCoords.data();
+    case VERTEX_NORMAL:
+        return normals.data();
+    case VERTEX_TANGENT:
+        return tangents.data();
+    default:
+        return bitangents.data();
+    }
+}
+
+void GeometryData::writeInterleavedVertices(const VertexFormat& format, void* destination)
+{
+    const void* sources[VERTEX_ATTRIBUTE_COUNT];
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        sources[attribute] = attributeData((VertexAttribute)attribute);
+    }
+    interleaveVertices(format, sources, vertexCount(), destination);
+}
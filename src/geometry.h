@@ -3,6 +3,15 @@
 
 #include <vector>
 #include <string>
+#include <istream>
+#include <ostream>
+#include <stddef.h>
+
+#include "vertexformat.h"
+#include "meshbounds.h"
+#include "meshoptimize.h"
+#include "meshsimplify.h"
+#include "meshlets.h"
 
 struct FaceData
 {
@@ -11,27 +20,142 @@ struct FaceData
     int normalIndex[3];
 };
 
+// NOTE: OBJ_LOAD_STREAM is the original ifstream based parser, and is kept around mostly so that
+//       the others can be compared against it, OBJ_LOAD_MAPPED maps the file into memory and parses
+//       it in place, and OBJ_LOAD_PARALLEL does the same but splits the file into chunks at line
+//       boundaries and parses them on the worker pool
+enum OBJLoadMode
+{
+    OBJ_LOAD_STREAM,
+    OBJ_LOAD_MAPPED,
+    OBJ_LOAD_PARALLEL
+};
+
+// NOTE: Receives the output of GeometryData::streamFromOBJFile one block at a time. Vertices arrive
+//       already expanded (three per triangle, no index buffer) and interleaved, with floatsPerVertex
+//       floats each: the position, then the texture coord and normal if the file has any
+class VertexBlockSink
+{
+public:
+    virtual ~VertexBlockSink() {}
+
+    virtual void beginVertices(size_t totalVertexCount, int floatsPerVertex) = 0;
+    virtual void consumeVertices(const float* vertexData, size_t firstVertex, size_t vertexCount) = 0;
+};
+
+struct OBJStreamStats
+{
+    size_t vertexCount;
+    int blockCount;
+
+    // What the loader itself had allocated at its high point, of which the attribute pools (every v,
+    // vt and vn record, which faces may refer back to at any time) are the part that the block size
+    // can't bound
+    size_t peakLoaderBytes;
+    size_t attributePoolBytes;
+
+    size_t peakResidentBytes;
+    bool peakCoversLoadOnly;
+};
+
+// NOTE: Filled in by loadFromOBJFile. The allocation numbers count every time one of the loader's
+//       arrays had to allocate storage, and how many bytes were copied over from the old storage when
+//       it did (which is what growing a vector one push_back at a time costs)
+struct OBJLoadStats
+{
+    size_t fileBytes;
+    double parseSeconds;
+    double indexSeconds;
+    double normalSeconds;
+    double tangentSeconds;
+
+    size_t allocationCount;
+    size_t bytesCopied;
+};
+
+struct OBJRecordCounts;
+
 class GeometryData
 {
 public:
-    void loadFromOBJFile(std::string filename);
+    // NOTE: With prescan set, the mapped loaders first count the records in the file so that every
+    //       array can be allocated once at its final size. Returns false, leaving the mesh as it was,
+    //       if the file can't be opened or a face refers to a record that doesn't exist
+    bool loadFromOBJFile(std::string filename, OBJLoadMode mode=OBJ_LOAD_MAPPED, bool prescan=true);
+
+    // Bounded-memory alternative to loadFromOBJFile: reads the file blockSize bytes at a time and
+    // hands expanded vertices to the sink in blocks of at most blockSize bytes as faces are read.
+    // Besides the v/vt/vn records, the loader's memory stays within a small multiple of blockSize.
+    // Faces can only refer to records that come before them, and the load stops with false at the
+    // first one that doesn't
+    static bool streamFromOBJFile(std::string filename, VertexBlockSink& sink,
+                                  size_t blockSize=1024*1024, OBJStreamStats* stats=0);
 
     int vertexCount();
+    int indexCount();
+
+    bool hasTextureCoords();
+    bool hasNormals();
+    bool hasTangents();
 
     void* vertexData();
     void* textureCoordData();
     void* normalData();
     void* tangentData();
     void* bitangentData();
+    void* indexData();
+
+    // NOTE: Interleaved output: vertexAttributes is the mask of attributes this mesh has, and
+    //       writeInterleavedVertices packs vertexCount() vertices laid out (and encoded) as format
+    //       describes, which may only use attributes from that mask, into destination
+    unsigned int vertexAttributes();
+    const void* attributeData(VertexAttribute attribute);
+    void writeInterleavedVertices(const VertexFormat& format, void* destination);
+
+    const OBJLoadStats& loadStats();
+
+    // Computed once the mesh is loaded, so culling and placement don't have to rescan the vertices
+    const MeshBounds& bounds();
+
+    // Runs the passes in optimizations (a mask of MeshOptimization) on the loaded mesh. A LOD chain
+    // gets one level per ratio in lodRatios (a fraction of the triangle count, decreasing)
+    void optimize(unsigned int optimizations, const float* lodRatios=defaultLODRatios,
+                  int lodLevelCount=defaultLODLevelCount);
+
+    // NOTE: The LOD chain, empty unless optimize built one. Each level is a range of lodIndexData,
+    //       indexing the same vertices as indexData, and the passes that reorder the full mesh's
+    //       triangles reorder every level's the same way
+    int lodLevelCount();
+    const MeshLOD* lodLevels();
+    int lodIndexCount();
+    void* lodIndexData();
+
+    // The meshlet table, empty unless optimize built one, in which case the full mesh's triangles are
+    // laid out meshlet by meshlet
+    MeshletTable meshlets();
 
 private:
+    void parseOBJStream(std::istream& inStream);
+    bool parseOBJBuffer(const char* cursor, const char* end, std::ostream& log,
+                        const OBJRecordCounts& recordsBefore, size_t* firstForwardFace=0);
+    void parseOBJBufferParallel(const char* begin, const char* end, bool prescan);
+    void reserveRecords(size_t vertexCount, size_t texCoordCount, size_t normalCount, size_t faceCount);
+
     std::vector<float> vertices;
     std::vector<float> textureCoords;
     std::vector<float> normals;
     std::vector<float> tangents;
     std::vector<float> bitangents;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> lodIndices;
+    std::vector<MeshLOD> lods;
+    std::vector<uint32_t> meshletData;
+    size_t meshletCount = 0;
 
     std::vector<FaceData> faces;
+
+    OBJLoadStats stats = OBJLoadStats();
+    MeshBounds meshBounds = MeshBounds();
 };
 
 #endif
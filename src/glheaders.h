@@ -0,0 +1,15 @@
+#ifndef GL_HEADERS_H
+#define GL_HEADERS_H
+
+// NOTE: The app gets its GL entry points through glew. The headless benchmarks build with
+//       HEADLESS_GL defined and link straight against the system libGL instead, which exports every
+//       core function we use, so they don't need glew (or a window to initialise it with)
+#ifdef HEADLESS_GL
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#else
+#include <GL/glew.h>
+#endif
+
+#endif
@@ -0,0 +1,113 @@
+#include "glvertexformat.h"
+
+static const char* vertexAttributeNames[VERTEX_ATTRIBUTE_COUNT] =
+{
+    "position", "texCoord", "normal", "tangent", "bitangent"
+};
+
+static GLenum glComponentType(VertexComponentType componentType)
+{
+    switch(componentType)
+    {
+    case VERTEX_COMPONENT_HALF_FLOAT:
+        return GL_HALF_FLOAT;
+    case VERTEX_COMPONENT_SHORT:
+        return GL_SHORT;
+    case VERTEX_COMPONENT_UNSIGNED_SHORT:
+        return GL_UNSIGNED_SHORT;
+    case VERTEX_COMPONENT_INT_2_10_10_10_REV:
+        return GL_INT_2_10_10_10_REV;
+    case VERTEX_COMPONENT_FLOAT:
+    default:
+        return GL_FLOAT;
+    }
+}
+
+void getVertexAttributeLocations(GLuint program, GLint locations[VERTEX_ATTRIBUTE_COUNT])
+{
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        locations[attribute] = glGetAttribLocation(program, vertexAttributeNames[attribute]);
+    }
+}
+
+unsigned int usedVertexAttributes(const GLint locations[VERTEX_ATTRIBUTE_COUNT])
+{
+    unsigned int attributes = 0;
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        if(locations[attribute] >= 0)
+        {
+            attributes |= vertexAttributeBit((VertexAttribute)attribute);
+        }
+    }
+    return attributes;
+}
+
+void applyVertexFormat(const VertexFormat& format, const GLint locations[VERTEX_ATTRIBUTE_COUNT],
+                       size_t baseOffset)
+{
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        const VertexAttributeFormat& attributeFormat = format.attributes[attribute];
+        if(locations[attribute] < 0)
+        {
+            continue;
+        }
+        if(!attributeFormat.present)
+        {
+            glDisableVertexAttribArray(locations[attribute]);
+            continue;
+        }
+
+        glVertexAttribPointer(locations[attribute], attributeFormat.componentCount,
+                              glComponentType(attributeFormat.componentType),
+                              attributeFormat.normalized, format.stride,
+                              (const void*)(baseOffset + attributeFormat.offset));
+        glEnableVertexAttribArray(locations[attribute]);
+    }
+}
+
+void applyPositionDequantization(GLuint program, const VertexFormat& format)
+{
+    GLint scaleLocation = glGetUniformLocation(program, "positionScale");
+    GLint offsetLocation = glGetUniformLocation(program, "positionOffset");
+    if(scaleLocation >= 0)
+    {
+        glUniform3fv(scaleLocation, 1, format.positionScale);
+    }
+    if(offsetLocation >= 0)
+    {
+        glUniform3fv(offsetLocation, 1, format.positionOffset);
+    }
+}
+
+InstanceAttributeLocations getInstanceAttributeLocations(GLuint program)
+{
+    InstanceAttributeLocations locations;
+    locations.transform = glGetAttribLocation(program, "instanceTransform");
+    locations.color = glGetAttribLocation(program, "instanceColor");
+    return locations;
+}
+
+void applyInstanceFormat(const InstanceAttributeLocations& locations, size_t baseOffset)
+{
+    const GLsizei stride = instanceRecordFloats * sizeof(float);
+    if(locations.transform >= 0)
+    {
+        for(int column=0; column<4; column++)
+        {
+            glVertexAttribPointer(locations.transform + column, 4, GL_FLOAT, GL_FALSE, stride,
+                                  (const void*)(baseOffset + column * 4 * sizeof(float)));
+            glVertexAttribDivisor(locations.transform + column, 1);
+            glEnableVertexAttribArray(locations.transform + column);
+        }
+    }
+    if(locations.color >= 0)
+    {
+        glVertexAttribPointer(locations.color, 4, GL_FLOAT, GL_FALSE, stride,
+                              (const void*)(baseOffset + 16 * sizeof(float)));
+        glVertexAttribDivisor(locations.color, 1);
+        glEnableVertexAttribArray(locations.color);
+    }
+}
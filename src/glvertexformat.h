@@ -0,0 +1,44 @@
+#ifndef GL_VERTEX_FORMAT_H
+#define GL_VERTEX_FORMAT_H
+
+#include "glheaders.h"
+#include "vertexformat.h"
+
+// Looks up the shader inputs for each VertexAttribute ("position", "texCoord", "normal", "tangent"
+// and "bitangent"), -1 for the ones the program doesn't use
+void getVertexAttributeLocations(GLuint program, GLint locations[VERTEX_ATTRIBUTE_COUNT]);
+
+// Mask of the attributes that have a location, i.e. the ones worth putting in a vertex buffer
+unsigned int usedVertexAttributes(const GLint locations[VERTEX_ATTRIBUTE_COUNT]);
+
+// NOTE: Points every attribute in format at the buffer currently bound to GL_ARRAY_BUFFER (starting
+//       baseOffset bytes in) and enables it, and disables the attributes the format doesn't have so
+//       they read the constant default instead. This is all VAO state, so it only needs doing once
+//       per buffer layout
+void applyVertexFormat(const VertexFormat& format, const GLint locations[VERTEX_ATTRIBUTE_COUNT],
+                       size_t baseOffset=0);
+
+// Sets the "positionScale" and "positionOffset" uniforms (on the program in use) that take packed
+// positions back to model space. They have to be set for float positions too, to the identity
+void applyPositionDequantization(GLuint program, const VertexFormat& format);
+
+// NOTE: Per-instance data is one record of instanceRecordFloats floats per instance: the model
+//       matrix's four columns and then an RGBA color. The shader reads them as "instanceTransform",
+//       a mat4 taking four locations in a row, and "instanceColor"
+const size_t instanceRecordFloats = 20;
+
+struct InstanceAttributeLocations
+{
+    GLint transform;
+    GLint color;
+};
+
+InstanceAttributeLocations getInstanceAttributeLocations(GLuint program);
+
+// NOTE: Points the instance attributes at the records in the buffer bound to GL_ARRAY_BUFFER, the
+//       first instance's baseOffset bytes in, stepping one record per instance (a draw that isn't
+//       instanced reads just the first). Vertex array state like applyVertexFormat, but it has to be
+//       applied again for each draw whose instances start somewhere else in the buffer
+void applyInstanceFormat(const InstanceAttributeLocations& locations, size_t baseOffset=0);
+
+#endif
@@ -1,12 +1,30 @@
 #include <iostream>
 #include <string>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
 #include <stdio.h>
+#include <math.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "SDL.h"
 #include <GL/glew.h>
 
 #include "glwindow.h"
 #include "geometry.h"
+#include "meshcache.h"
+#include "meshcull.h"
+#include "scene.h"
+#include "glvertexformat.h"
 
 // Include GLM
 #include <glm/glm.hpp>
@@ -99,7 +117,246 @@ GLuint loadShaderProgram(const char* vertShaderFilename, const char* fragShaderF
     return program;
 }
 
+// NOTE: Models bigger than this are streamed into the vertex buffer a block at a time, as triangle
+//       soup, instead of being loaded (and cached) whole
+static const long long streamingLoadThreshold = 512LL * 1024 * 1024;
+static const size_t streamingBlockSize = 4 * 1024 * 1024;
+
+// NOTE: Most that gets copied into a spawned model's buffers per frame, which keeps each frame's
+//       upload to a millisecond or so rather than stalling on hundreds of megabytes at once
+static const size_t uploadBytesPerFrame = 4 * 1024 * 1024;
+
+// NOTE: How the vertex buffer is packed: positions as 16-bit fractions of the mesh bounds, texture
+//       coords as half floats and normals/tangents as 10_10_10_2, which is 24 bytes for a vertex with
+//       everything instead of 56. Attributes the shader doesn't read aren't stored at all
+static const VertexPacking windowVertexPacking =
+{
+    VERTEX_ENCODING_UNORM16_BOUNDS, VERTEX_ENCODING_HALF, VERTEX_ENCODING_SNORM_10_10_10_2
+};
+
+// NOTE: Passes run on every model before it goes into the mesh cache, so they only cost anything the
+//       first time a model is loaded
+static const unsigned int windowMeshOptimizations = MESH_OPTIMIZE_VERTEX_CACHE | MESH_OPTIMIZE_VERTEX_FETCH |
+                                                    MESH_OPTIMIZE_LOD_CHAIN | MESH_OPTIMIZE_MESHLETS;
+
+// NOTE: Each object draws the coarsest LOD whose error stays under a pixel on screen, with 25% either
+//       side of that before it switches, so that it doesn't flicker between two levels
+static const float lodPixelThreshold = 1.0f;
+static const float lodHysteresis = 1.25f;
+
+// NOTE: How often the meshlet culling numbers are printed, as averages over the frames since the last
+//       time, in milliseconds
+static const Uint32 cullReportInterval = 1000;
+
+// NOTE: Copies of a mesh at the same LOD go in one instanced draw. Up close, where culling a copy's
+//       meshlets is worth a draw of its own, fewer copies than this are drawn one at a time
+static const size_t minInstancedCopies = 4;
+
+// How many copies of the selected object 'I' adds
+static const size_t copiesPerSpawn = 1000;
+
+static const char* windowTitle = "OpenGL Prac 1";
+
+static void printPackingReport(const VertexFormat& format, const void* const sources[VERTEX_ATTRIBUTE_COUNT],
+                               size_t vertexCount)
+{
+    unsigned int attributes = 0;
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        if(format.attributes[attribute].present)
+        {
+            attributes |= vertexAttributeBit((VertexAttribute)attribute);
+        }
+    }
+
+    VertexPackingError error = measurePackingError(format, sources, vertexCount);
+    cout << "Packed " << vertexCount << " vertices at " << format.stride << " bytes each ("
+         << interleavedVertexFormat(attributes).stride << " as floats)" << endl;
+    cout << "\tPosition error: " << error.maxPositionError << " max, " << error.rmsPositionError << " rms" << endl;
+    if(format.attributes[VERTEX_TEXTURE_COORD].present)
+    {
+        cout << "\tTexture coord error: " << error.maxTexCoordError << " max" << endl;
+    }
+    if(format.attributes[VERTEX_NORMAL].present || format.attributes[VERTEX_TANGENT].present)
+    {
+        cout << "\tDirection error: " << error.maxDirectionDegrees << " degrees max, "
+             << error.meanDirectionDegrees << " mean" << endl;
+    }
+}
+
+// Uploads every block that the streaming loader produces with glBufferSubData, into a buffer that
+// is sized for the whole mesh up front, and keeps the box around the positions for placing later
+// models next to it
+class GLBufferStreamSink : public VertexBlockSink
+{
+public:
+    GLBufferStreamSink(GLuint buffer, int vertexLoc)
+        : buffer(buffer), vertexLoc(vertexLoc), vertexSize(0), floatsPerVertex(0), bounds(MeshBounds())
+    {
+        for(int axis=0; axis<3; axis++)
+        {
+            bounds.lower[axis] = 1e30f;
+            bounds.upper[axis] = -1e30f;
+        }
+    }
+
+    void beginVertices(size_t totalVertexCount, int floatsPerVertex)
+    {
+        this->floatsPerVertex = floatsPerVertex;
+        vertexSize = floatsPerVertex * sizeof(float);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, totalVertexCount * vertexSize, 0, GL_STATIC_DRAW);
+        glVertexAttribPointer(vertexLoc, 3, GL_FLOAT, false, vertexSize, 0);
+    }
+
+    void consumeVertices(const float* vertexData, size_t firstVertex, size_t vertexCount)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, firstVertex * vertexSize, vertexCount * vertexSize, vertexData);
+        for(size_t vertex=0; vertex<vertexCount; vertex++)
+        {
+            const float* position = vertexData + vertex * floatsPerVertex;
+            for(int axis=0; axis<3; axis++)
+            {
+                bounds.lower[axis] = std::min(bounds.lower[axis], position[axis]);
+                bounds.upper[axis] = std::max(bounds.upper[axis], position[axis]);
+            }
+        }
+    }
+
+    // Only the box is filled in, the sphere isn't needed for placement
+    MeshBounds streamedBounds()
+    {
+        return bounds;
+    }
+
+private:
+    GLuint buffer;
+    int vertexLoc;
+    size_t vertexSize;
+    int floatsPerVertex;
+    MeshBounds bounds;
+};
+
+// The packed layout a mesh gets on the GPU, with just the attributes the shader reads
+static VertexFormat meshVertexFormat(MeshCache& geometry, unsigned int shaderAttributes)
+{
+    return packedVertexFormat(shaderAttributes & geometry.vertexAttributes(), windowVertexPacking,
+                              geometry.bounds());
+}
+
+static void printMeshPackingReport(RegisteredMesh& mesh)
+{
+    const void* sources[VERTEX_ATTRIBUTE_COUNT];
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        sources[attribute] = mesh.geometry.attributeData((VertexAttribute)attribute);
+    }
+    printPackingReport(mesh.format, sources, mesh.geometry.vertexCount());
+}
+
+// NOTE: The index buffer holds the full mesh's indices followed by its LOD chain's, so every level is
+//       drawn from the same buffer, starting lodIndexOffset bytes in
+static size_t meshIndexBytes(MeshCache& geometry)
+{
+    return (geometry.indexCount() + geometry.lodIndexCount()) * sizeof(unsigned int);
+}
+
+static size_t lodIndexOffset(MeshCache& geometry, int level)
+{
+    if (level == 0)
+        return 0;
+    return (geometry.indexCount() + geometry.lodLevels()[level - 1].firstIndex) * sizeof(unsigned int);
+}
+
+static int lodIndexCount(MeshCache& geometry, int level)
+{
+    return (level == 0) ? geometry.indexCount() : geometry.lodLevels()[level - 1].indexCount;
+}
+
+// Creates the mesh's buffers at their full size, for the vertices (in mesh.format) and indices to be
+// copied into through GL_COPY_WRITE_BUFFER, which leaves every vertex array's bindings alone
+static void allocateMeshBuffers(RegisteredMesh& mesh)
+{
+    glGenBuffers(1, &mesh.vertexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mesh.vertexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, mesh.geometry.vertexCount() * mesh.format.stride, 0, GL_STATIC_DRAW);
+    glGenBuffers(1, &mesh.indexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mesh.indexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, meshIndexBytes(mesh.geometry), 0, GL_STATIC_DRAW);
+}
+
+// Copies bytes of the index buffer's contents, starting offset bytes in, from the full mesh's and
+// then the LOD chain's cached indices
+static void copyMeshIndices(RegisteredMesh& mesh, size_t offset, size_t bytes)
+{
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mesh.indexBuffer);
+    size_t fullBytes = mesh.geometry.indexCount() * sizeof(unsigned int);
+    if ((offset < fullBytes) && (bytes > 0)) {
+        size_t fullPart = std::min(bytes, fullBytes - offset);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, fullPart, (const char*) mesh.geometry.indexData() + offset);
+        offset += fullPart;
+        bytes -= fullPart;
+    }
+    if (bytes > 0) {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytes,
+                        (const char*) mesh.geometry.lodIndexData() + (offset - fullBytes));
+    }
+}
+
+// NOTE: How many pixels one model unit covers on screen at the point of the object's bounding sphere
+//       nearest the camera, which is what LOD errors get measured in. Scaling in the model matrix
+//       scales the errors with it. Inside the sphere everything counts as right up close
+static float projectedPixelsPerUnit(const glm::mat4& modelView, const glm::mat4& projection,
+                                    const MeshBounds& bounds, int viewportHeight)
+{
+    float scale = std::max(glm::length(glm::vec3(modelView[0])),
+                           std::max(glm::length(glm::vec3(modelView[1])), glm::length(glm::vec3(modelView[2]))));
+    glm::vec4 centre = modelView * glm::vec4(bounds.centre[0], bounds.centre[1], bounds.centre[2], 1.0f);
+    float distance = -centre.z - bounds.radius * scale;
+    if (distance <= 1e-4f)
+        return 1e30f;
+    return scale * projection[1][1] * 0.5f * viewportHeight / distance;
+}
+
+// Furthest any corner of the mesh's bounding box reaches along x once transform has placed it
+static float boundsUpperX(const glm::mat4& transform, const MeshBounds& bounds)
+{
+    float upper = -1e30f;
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec4 point(((corner & 1) ? bounds.upper : bounds.lower)[0], ((corner & 2) ? bounds.upper : bounds.lower)[1],
+                        ((corner & 4) ? bounds.upper : bounds.lower)[2], 1.0f);
+        upper = std::max(upper, (transform * point).x);
+    }
+    return upper;
+}
+
+// NOTE: Normal cones only survive the model matrix if it scales every axis by the same amount and
+//       doesn't mirror anything, otherwise they would need transforming cone by cone
+static bool preservesNormalCones(const glm::mat4& model)
+{
+    float scaleX = glm::length(glm::vec3(model[0]));
+    float scaleY = glm::length(glm::vec3(model[1]));
+    float scaleZ = glm::length(glm::vec3(model[2]));
+    float tolerance = 1e-3f * std::max(scaleX, std::max(scaleY, scaleZ));
+    return (std::abs(scaleX - scaleY) <= tolerance) && (std::abs(scaleX - scaleZ) <= tolerance) &&
+           (glm::determinant(glm::mat3(model)) > 0.0f);
+}
+
+// Once both buffers are filled in: gives the mesh a vertex array to draw from and marks it uploaded
+static void createMeshVertexArray(RegisteredMesh& mesh, const GLint attributeLocations[VERTEX_ATTRIBUTE_COUNT])
+{
+    glGenVertexArrays(1, &mesh.vertexArray);
+    glBindVertexArray(mesh.vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+    applyVertexFormat(mesh.format, attributeLocations);
+
+    // NOTE: The element buffer binding is part of the vertex array's state, so it stays bound for render()
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    mesh.uploaded = true;
+}
+
 OpenGLWindow::OpenGLWindow()
+    : meshRegistry(windowMeshOptimizations)
 {
 }
 
@@ -108,10 +365,10 @@ void OpenGLWindow::initGL()
     // We need to first specify what type of OpenGL context we need before we can create the window
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 
-    sdlWin = SDL_CreateWindow("OpenGL Prac 1",
+    sdlWin = SDL_CreateWindow(windowTitle,
                               SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                               640, 480, SDL_WINDOW_OPENGL);
     if(!sdlWin)
@@ -156,8 +413,13 @@ void OpenGLWindow::initGL()
     shader = loadShaderProgram("build/simple.vert", "build/simple.frag");
     glUseProgram(shader);
 
-    // Get a handle for our "MVP" uniform
-    MatrixID = glGetUniformLocation(shader, "MVP");
+    // Get a handle for our "ViewProjection" uniform, and for the per-instance transform and color
+    viewProjectionLoc = glGetUniformLocation(shader, "ViewProjection");
+    instanceLocations = getInstanceAttributeLocations(shader);
+
+    // NOTE: Every object's transform and color go in one buffer of instance records, refilled once a
+    //       frame in draw order, so each draw's instances are a contiguous run of it
+    glGenBuffers(1, &objectBuffer);
 
     // Projection matrix : 45° Field of View, 4:3 ratio, display range : 0.1 unit <-> 100 units
     Projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
@@ -169,121 +431,435 @@ void OpenGLWindow::initGL()
                     glm::vec3(0,1, 0)  // Head is up (set to 0,-1,0 to look upside-down)
                 );
 
-    // Model matrix : an identity matrix (model will be at the origin)
-    Model      = glm::mat4(1.0f);
-
-    // Our ModelViewProjection : multiplication of our 3 matrices
-    MVP        = Projection * View * Model;
-
-    // set object color to white
-    colorLoc = glGetUniformLocation(shader, "objectColor");
-    glUniform3f(colorLoc, 1.0f, 1.0f, 1.0f);                
+    // Each object has its own model matrix, this is the rest of the transform
+    ViewProjection = Projection * View;
 
     // Load the model that we want to use and buffer the vertex attributes
     cout << "Enter the model path to import: ";
     cin >> filename1;
     
-    GeometryData geometry;
-    geometry.loadFromOBJFile(filename1);
-    vertexCount = geometry.vertexCount();
+    getVertexAttributeLocations(shader, attributeLocations);
+    int vertexLoc = attributeLocations[VERTEX_POSITION];
+
+    struct stat fileInfo;
+    if ((stat(filename1.c_str(), &fileInfo) == 0) && (fileInfo.st_size > streamingLoadThreshold)) {
+        // too big to hold in memory twice, so stream it straight into the vertex buffer instead
+        glGenBuffers(1, &vertexBuffer);
+        GLBufferStreamSink sink(vertexBuffer, vertexLoc);
+        OBJStreamStats stats = OBJStreamStats();
+        if (GeometryData::streamFromOBJFile(filename1, sink, streamingBlockSize, &stats)) {
+            vertexCount = stats.vertexCount;
+            if (vertexCount > 0)
+                streamedBounds = sink.streamedBounds();
+            glEnableVertexAttribArray(vertexLoc);
+            scene.add(MeshHandle(), glm::mat4(1.0f));
+
+            // streamed positions are plain floats
+            applyPositionDequantization(shader, interleavedVertexFormat(vertexAttributeBit(VERTEX_POSITION)));
+        }
+        else {
+            // nothing usable was streamed, so there is nothing to draw from the buffer
+            glDeleteBuffers(1, &vertexBuffer);
+            vertexBuffer = 0;
+        }
+    }
+    else {
+        // NOTE: The mesh cache only parses the OBJ if it has no up to date entry for it, otherwise the
+        //       arrays below come straight out of the mapped cache file
+        MeshHandle mesh = meshRegistry.acquire(filename1);
+        if (mesh) {
+            MeshCache& geometry = mesh->geometry;
+            mesh->format = meshVertexFormat(geometry, usedVertexAttributes(attributeLocations));
+            allocateMeshBuffers(*mesh);
+
+            // pack straight into the buffer's storage, so the vertices are only copied once
+            size_t vertexBytes = geometry.vertexCount() * mesh->format.stride;
+            if (vertexBytes > 0) {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, mesh->vertexBuffer);
+                void* bufferData = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, vertexBytes,
+                                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+                geometry.writeInterleavedVertices(mesh->format, bufferData);
+                glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            }
+            copyMeshIndices(*mesh, 0, meshIndexBytes(geometry));
+            createMeshVertexArray(*mesh, attributeLocations);
+            printMeshPackingReport(*mesh);
 
-    int vertexLoc = glGetAttribLocation(shader, "position");
+            scene.add(mesh, glm::mat4(1.0f));
+        }
+    }
 
-    glGenBuffers(1, &vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, vertexCount * 3 * sizeof(float), geometry.vertexData(), GL_STATIC_DRAW);
-    glVertexAttribPointer(vertexLoc, 3, GL_FLOAT, false, 0, 0);
-    glEnableVertexAttribArray(vertexLoc);
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
     glPrintError("Setup complete!", true);
 }
 
-void OpenGLWindow::spawnNewObject() { // loads a second model
-    GeometryData geometry, geometry2;
-
-    cout << "Enter the model path to import: ";
-    cin >> filename2;
+// NOTE: Runs on the loader thread. A mesh that is already resident needs nothing more, otherwise its
+//       vertices are packed here, ready for the render thread to upload
+static void loadModel(MeshRegistry& registry, const string& filename, unsigned int shaderAttributes,
+                      LoadedModel& model) {
+    model.mesh = registry.acquire(filename);
+    if (!model.mesh) {
+        cout << "Unable to load " << filename << endl;
+        return;
+    }
+    model.name = filename;
+    model.loaded = true;
+    if (model.mesh->uploaded)
+        return;
+
+    MeshCache& geometry = model.mesh->geometry;
+    model.vertexCount = geometry.vertexCount();
+    model.format = meshVertexFormat(geometry, shaderAttributes);
+    model.vertices.resize(model.vertexCount * model.format.stride);
+    if (model.vertexCount > 0)
+        geometry.writeInterleavedVertices(model.format, &model.vertices[0]);
+}
 
-    // load models
-    geometry.loadFromOBJFile(filename1);
-    vertexCount = geometry.vertexCount();
+// True once a whole line has been typed on stdin, so that the render loop can carry on while the
+// filename is being typed instead of blocking in cin
+static bool inputLineReady() {
+    if (cin.rdbuf()->in_avail() > 0)
+        return true;
+
+#ifdef _WIN32
+    // NOTE: A console signals on every key and mouse event, so look through what is queued for Enter,
+    //       which is when a line can be read. A pipe just needs something in it, and a file never blocks
+    HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+    DWORD inputType = GetFileType(input);
+    if (inputType == FILE_TYPE_PIPE) {
+        DWORD available = 0;
+        return PeekNamedPipe(input, NULL, 0, NULL, &available, NULL) && (available > 0);
+    }
+    if (inputType != FILE_TYPE_CHAR)
+        return true;
+
+    INPUT_RECORD records[128];
+    DWORD recordCount = 0;
+    if (!PeekConsoleInput(input, records, 128, &recordCount))
+        return WaitForSingleObject(input, 0) == WAIT_OBJECT_0;
+    for (DWORD record = 0; record < recordCount; record++) {
+        if ((records[record].EventType == KEY_EVENT) && records[record].Event.KeyEvent.bKeyDown &&
+            (records[record].Event.KeyEvent.wVirtualKeyCode == VK_RETURN))
+            return true;
+    }
+    return false;
+#else
+    pollfd input = {STDIN_FILENO, POLLIN, 0};
+    return poll(&input, 1, 0) > 0;
+#endif
+}
 
-    geometry2.loadFromOBJFile(filename2);
-    vertexCount2 = geometry2.vertexCount();
+void OpenGLWindow::spawnNewObject() { // loads another model
+    // NOTE: The filename is picked up by updateLoading() once it has been typed, and the load itself
+    //       runs on the loader thread, so the window keeps rendering the scene meanwhile
+    cout << "Enter the model path to import: " << flush;
+    awaitingFilename = true;
+}
 
-    cout << "Total vertex count: " << geometry.vertexCount() + geometry2.vertexCount() << endl;
+void OpenGLWindow::updateLoading() {
+    meshRegistry.deleteReleasedObjects();
 
-    float * firstModel = ( (float*) geometry.vertexData() );
-    float * secondModel = ( (float*) geometry2.vertexData() );
+    if (awaitingFilename && inputLineReady()) {
+        string line;
+        if (!getline(cin, line)) {
+            cout << "No model path given" << endl;
+            awaitingFilename = false;
+        }
+        else {
+            // a blank line (what was left of the line the first path was typed on) keeps waiting
+            stringstream words(line);
+            if (words >> filename2) {
+                awaitingFilename = false;
+                string filename = filename2;
+                unsigned int shaderAttributes = usedVertexAttributes(attributeLocations);
+                MeshRegistry* registry = &meshRegistry;
+                loader.queue([registry, filename, shaderAttributes](LoadedModel& model) {
+                    loadModel(*registry, filename, shaderAttributes, model);
+                });
+            }
+        }
+    }
 
-    // calculate maximum x coordinate of first model
-    float firstBound = 0;
+    // NOTE: A finished model whose mesh still has to be uploaded goes into its new buffers
+    //       uploadBytesPerFrame at a time, and is only added to the scene once everything is there
+    if (!uploadingModel) {
+        if (!loader.takeFinished(pendingModel))
+            return;
 
-    for (int vertex = 0; vertex < vertexCount * 3; vertex += 3) {
-        if (firstModel[vertex] > firstBound) {
-            firstBound = firstModel[vertex];
+        if (!pendingModel.loaded) {
+            pendingModel = LoadedModel();
+            return;
         }
-    }  
 
-    // calculate minimum x coordinate of second model
-    float secondBound = FLT_MAX;
-
-    for (int vertex = 0; vertex < vertexCount2 * 3; vertex += 3) {
-        if (secondModel[vertex] < secondBound) {
-            secondBound = secondModel[vertex];
+        if (!pendingModel.mesh->uploaded) {
+            pendingModel.mesh->format = pendingModel.format;
+            allocateMeshBuffers(*pendingModel.mesh);
+            uploadedVertexBytes = 0;
+            uploadedIndexBytes = 0;
+            uploadingModel = true;
         }
     }
 
-    // calculate shift value
-    float shift = std::abs(secondBound - firstBound) + 0.3f;
-    cout << "Shift value: " << shift << endl;
+    RegisteredMesh& mesh = *pendingModel.mesh;
+    if (uploadingModel) {
+        size_t budget = uploadBytesPerFrame;
+        size_t vertexBytes = pendingModel.vertices.size();
+        if (uploadedVertexBytes < vertexBytes) {
+            size_t bytes = std::min(budget, vertexBytes - uploadedVertexBytes);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, mesh.vertexBuffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, uploadedVertexBytes, bytes, &pendingModel.vertices[uploadedVertexBytes]);
+            uploadedVertexBytes += bytes;
+            budget -= bytes;
+        }
 
-    // offset the second model's vertices using bounding value
-    for (int vertex = 0; vertex < vertexCount2 * 3; vertex += 3) {
-        secondModel[vertex] += shift;
-    }
+        size_t indexBytes = meshIndexBytes(mesh.geometry);
+        if ((budget > 0) && (uploadedIndexBytes < indexBytes)) {
+            size_t bytes = std::min(budget, indexBytes - uploadedIndexBytes);
+            copyMeshIndices(mesh, uploadedIndexBytes, bytes);
+            uploadedIndexBytes += bytes;
+        }
 
-    // combine vertex arrays
-    vector<float> combinedVertices;
-    for (int i = 0; i < vertexCount * 3; i++ ) {
-        combinedVertices.push_back( firstModel[i] );
+        if ((uploadedVertexBytes < vertexBytes) || (uploadedIndexBytes < indexBytes))
+            return;
+
+        // everything is on the GPU, give the mesh its vertex array
+        createMeshVertexArray(mesh, attributeLocations);
+        printMeshPackingReport(mesh);
+        uploadingModel = false;
     }
-    for (int i = 0; i < vertexCount2 * 3; i++ ) {
-        combinedVertices.push_back( secondModel[i] );
+    else {
+        cout << pendingModel.name << " shares the buffers of a mesh that is already loaded" << endl;
     }
-    cout << "combined vertices into one vector" << endl;
-
-    // buffer vertices
-    int vertexLoc = glGetAttribLocation(shader, "position");
 
-    glGenBuffers(1, &vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, (vertexCount + vertexCount2) * 3 * sizeof(float), &combinedVertices[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(vertexLoc, 3, GL_FLOAT, false, 0, 0);
-    glEnableVertexAttribArray(vertexLoc);
+    // move the new model to the right of everything already in the scene, using their bounds
+    glm::mat4 transform(1.0f);
+    if (!scene.empty()) {
+        float rightBound = -1e30f;
+        for (size_t object = 0; object < scene.size(); object++) {
+            const MeshBounds& bounds = scene.mesh(object) ? scene.mesh(object)->geometry.bounds() : streamedBounds;
+            rightBound = std::max(rightBound, boundsUpperX(scene.transform(object), bounds));
+        }
+        float shift = rightBound - mesh.geometry.bounds().lower[0] + 0.3f;
+        transform = glm::translate(transform, glm::vec3(shift, 0.0f, 0.0f));
+        cout << "Shift value: " << shift << endl;
+    }
+    selectedObject = scene.add(pendingModel.mesh, transform);
 
-    spawnedSecondObj = true;
-    glPrintError("Second model loading complete!", true);
+    pendingModel = LoadedModel();
+    cout << "Spawned object " << selectedObject << "! " << scene.size() << " objects, "
+         << meshRegistry.residentCount() << " meshes resident" << endl;
+    glPrintError("Model loading complete!", true);
 }
 
 void OpenGLWindow::render() {
+    updateLoading();
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glUseProgram(shader);
 
-    if (partyMode)
-        glUniform3f(colorLoc, (float) rand()/RAND_MAX, (float) rand()/RAND_MAX, (float) rand()/RAND_MAX);
+    if (partyMode) {
+        for (size_t object = 0; object < scene.size(); object++)
+            scene.color(object) = glm::vec3((float) rand()/RAND_MAX, (float) rand()/RAND_MAX, (float) rand()/RAND_MAX);
+    }
+    glUniformMatrix4fv(viewProjectionLoc, 1, GL_FALSE, &ViewProjection[0][0]);
+
+    int viewportWidth, viewportHeight;
+    SDL_GL_GetDrawableSize(sdlWin, &viewportWidth, &viewportHeight);
+
+    // pick the LOD each object's size on screen calls for, then bring together the objects that draw
+    // the same mesh at the same LOD
+    drawOrder.resize(scene.size());
+    for (size_t object = 0; object < scene.size(); object++) {
+        drawOrder[object] = object;
+        const MeshHandle& mesh = scene.mesh(object);
+        if (!mesh)
+            continue;
+
+        MeshCache& geometry = mesh->geometry;
+        float pixelsPerUnit = projectedPixelsPerUnit(View * scene.transform(object), Projection, geometry.bounds(),
+                                                     viewportHeight);
+        int& lodLevel = scene.lodLevel(object);
+        lodLevel = selectLODLevel(geometry.lodLevels(), geometry.lodLevelCount(), pixelsPerUnit,
+                                  lodPixelThreshold, lodHysteresis, lodLevel);
+    }
+    Scene& objects = scene;
+    std::sort(drawOrder.begin(), drawOrder.end(), [&objects](uint32_t a, uint32_t b) {
+        if (objects.mesh(a) != objects.mesh(b))
+            return objects.mesh(a).get() < objects.mesh(b).get();
+        if (objects.lodLevel(a) != objects.lodLevel(b))
+            return objects.lodLevel(a) < objects.lodLevel(b);
+        return a < b;
+    });
+    uploadObjectData();
+
+    // draw each run of copies, with its mesh's packing, its instances' records and the run's LOD
+    size_t submittedTriangles = 0;
+    size_t fullDetailTriangles = 0;
+    const size_t recordBytes = instanceRecordFloats * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, objectBuffer);
+    for (size_t first = 0, last = 0; first < drawOrder.size(); first = last) {
+        const MeshHandle& mesh = scene.mesh(drawOrder[first]);
+        int lodLevel = scene.lodLevel(drawOrder[first]);
+        for (last = first + 1; last < drawOrder.size(); last++) {
+            if ((scene.mesh(drawOrder[last]) != mesh) || (scene.lodLevel(drawOrder[last]) != lodLevel))
+                break;
+        }
+        size_t copies = last - first;
+
+        if (!mesh) {
+            // the streamed model, which has no mesh of its own
+            applyPositionDequantization(shader, interleavedVertexFormat(vertexAttributeBit(VERTEX_POSITION)));
+            glBindVertexArray(vao);
+            applyInstanceFormat(instanceLocations, first * recordBytes);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, copies);
+            submittedTriangles += copies * (vertexCount / 3);
+            fullDetailTriangles += copies * (vertexCount / 3);
+            continue;
+        }
 
-    // send transformation to shader
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
+        MeshCache& geometry = mesh->geometry;
+        applyPositionDequantization(shader, mesh->format);
+        glBindVertexArray(mesh->vertexArray);
+        fullDetailTriangles += copies * (geometry.indexCount() / 3);
+
+        // NOTE: Up close, where only the full mesh gets drawn, the meshlets outside the view or facing
+        //       away go before they reach the GPU, and whatever is left goes in one multi-draw per copy
+        MeshletTable meshlets = geometry.meshlets();
+        if ((lodLevel == 0) && (meshlets.count > 0) && (copies < minInstancedCopies)) {
+            for (size_t copy = first; copy < last; copy++) {
+                const glm::mat4& transform = scene.transform(drawOrder[copy]);
+                applyInstanceFormat(instanceLocations, copy * recordBytes);
+                submittedTriangles += drawVisibleMeshlets(meshlets, ViewProjection * transform, transform);
+            }
+            continue;
+        }
 
-    // draw objects
-    glDrawArrays(GL_TRIANGLES, 0, vertexCount + vertexCount2);
+        int indexCount = lodIndexCount(geometry, lodLevel);
+        applyInstanceFormat(instanceLocations, first * recordBytes);
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (const void*) lodIndexOffset(geometry, lodLevel),
+                                copies);
+        submittedTriangles += copies * (indexCount / 3);
+    }
+    reportCulling();
+
+    // the title bar doubles as the LOD counter, only touched when the numbers change
+    if ((submittedTriangles != lastSubmittedTriangles) || (fullDetailTriangles != lastFullDetailTriangles)) {
+        stringstream title;
+        title << windowTitle << " - " << submittedTriangles << " of " << fullDetailTriangles << " triangles";
+        SDL_SetWindowTitle(sdlWin, title.str().c_str());
+        lastSubmittedTriangles = submittedTriangles;
+        lastFullDetailTriangles = fullDetailTriangles;
+    }
 
     // Swap the front and back buffers
     SDL_GL_SwapWindow(sdlWin);
 }
 
+// Refills the object buffer with every object's instance record, in draw order, growing it if the
+// scene has grown
+void OpenGLWindow::uploadObjectData() {
+    size_t objectBytes = drawOrder.size() * instanceRecordFloats * sizeof(float);
+    if (objectBytes == 0)
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, objectBuffer);
+    if (objectBytes > objectBufferBytes) {
+        objectBufferBytes = std::max(objectBytes, 2 * objectBufferBytes);
+        glBufferData(GL_ARRAY_BUFFER, objectBufferBytes, 0, GL_STREAM_DRAW);
+    }
+    void* objectData = glMapBufferRange(GL_ARRAY_BUFFER, 0, objectBytes,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    scene.writeObjectData(&drawOrder[0], drawOrder.size(), (float*) objectData);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+// Adds count copies of the selected object in a grid behind it, all sharing its mesh
+void OpenGLWindow::spawnCopies(size_t count) {
+    if ((selectedObject >= scene.size()) || !scene.mesh(selectedObject)) {
+        cout << "Only a model loaded through the mesh cache can be copied" << endl;
+        return;
+    }
+
+    // copied out, since adding objects moves the scene's arrays
+    MeshHandle mesh = scene.mesh(selectedObject);
+    glm::mat4 transform = scene.transform(selectedObject);
+    glm::vec3 color = scene.color(selectedObject);
+    float spacing = 2.5f * std::max(mesh->geometry.bounds().radius, 1e-3f);
+    size_t side = (size_t) ceil(sqrt((double) count));
+    for (size_t copy = 0; copy < count; copy++) {
+        glm::vec3 offset(((copy % side) - 0.5f * (side - 1)) * spacing, 0.0f, (copy / side + 1) * spacing);
+        scene.add(mesh, glm::translate(transform, offset), color);
+    }
+    cout << "Added " << count << " copies of object " << selectedObject << ", " << scene.size()
+         << " objects in the scene" << endl;
+}
+
+// Applies trans to the selected object, on its model space side
+void OpenGLWindow::transformSelected(const glm::mat4& trans) {
+    if (selectedObject < scene.size())
+        scene.transform(selectedObject) *= trans;
+}
+
+// Culls the meshlets of the mesh bound for drawing and draws the rest, returning how many triangles that was
+size_t OpenGLWindow::drawVisibleMeshlets(const MeshletTable& meshlets, const glm::mat4& objectMVP,
+                                         const glm::mat4& objectModel) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    FrustumPlanes frustum = extractFrustumPlanes(&objectMVP[0][0]);
+    glm::vec4 camera = glm::inverse(View * objectModel) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    float cameraPosition[3] = {camera.x / camera.w, camera.y / camera.w, camera.z / camera.w};
+    visibleMeshlets.resize(meshlets.count);
+    size_t visibleCount = cullMeshlets(meshlets, frustum, preservesNormalCones(objectModel) ? cameraPosition : 0,
+                                       &visibleMeshlets[0]);
+
+    // neighbouring meshlets sit next to each other in the index buffer, so runs of them become one draw
+    meshletDrawCounts.clear();
+    meshletDrawOffsets.clear();
+    size_t runEnd = 0;
+    size_t triangles = 0;
+    for (size_t visible = 0; visible < visibleCount; visible++) {
+        uint32_t meshlet = visibleMeshlets[visible];
+        uint32_t firstIndex = meshlets.firstIndex[meshlet];
+        uint32_t indexCount = meshlets.indexCount[meshlet];
+        if (!meshletDrawCounts.empty() && (firstIndex == runEnd))
+            meshletDrawCounts.back() += indexCount;
+        else {
+            meshletDrawCounts.push_back(indexCount);
+            meshletDrawOffsets.push_back((const void*) (firstIndex * sizeof(unsigned int)));
+        }
+        runEnd = firstIndex + indexCount;
+        triangles += indexCount / 3;
+    }
+    cullSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    // the meshlets cover the full mesh's indices, one after another
+    size_t meshTriangles = (meshlets.firstIndex[meshlets.count - 1] + meshlets.indexCount[meshlets.count - 1]) / 3;
+    cullTestedTriangles += meshTriangles;
+    cullRejectedTriangles += meshTriangles - triangles;
+
+    if (!meshletDrawCounts.empty())
+        glMultiDrawElements(GL_TRIANGLES, &meshletDrawCounts[0], GL_UNSIGNED_INT, &meshletDrawOffsets[0],
+                            meshletDrawCounts.size());
+    return triangles;
+}
+
+// Prints what culling cost and saved, on average, over the last cullReportInterval
+void OpenGLWindow::reportCulling() {
+    cullFrames++;
+    Uint32 now = SDL_GetTicks();
+    if (now - lastCullReport < cullReportInterval)
+        return;
+
+    if (cullTestedTriangles > 0) {
+        printf("Meshlet culling (%s): %.3f ms per frame, %.1f%% of triangles rejected\n", meshletCullPath(),
+               cullSeconds * 1000.0 / cullFrames, 100.0 * cullRejectedTriangles / cullTestedTriangles);
+    }
+    lastCullReport = now;
+    cullFrames = 0;
+    cullSeconds = 0.0;
+    cullTestedTriangles = 0;
+    cullRejectedTriangles = 0;
+}
+
 void OpenGLWindow::changeAxis() { // switches between transform axis
     if (transformationAxis == X) {
         transformationAxis = Y;
@@ -373,16 +949,27 @@ bool OpenGLWindow::handleEvent(SDL_Event e) { // event handler for SDL key press
             else {
                 cout << "Party mode disabled... :(" << endl;
                 partyMode = false;
-                glUniform3f(colorLoc, 1.0f, 1.0f, 1.0f);                
+                for (size_t object = 0; object < scene.size(); object++)
+                    scene.color(object) = glm::vec3(1.0f);
             }      
         }
-        if(e.key.keysym.sym == SDLK_n) // 'N' = load second object
+        if(e.key.keysym.sym == SDLK_n) // 'N' = load another object
+        {
+            if (awaitingFilename || uploadingModel || loader.busy())
+                cout << "Still loading the last model" << endl;
+            else
+                spawnNewObject();
+        }
+        if(e.key.keysym.sym == SDLK_i) // 'I' = add copies of the selected object, drawn instanced
         {
-            if (!spawnedSecondObj) {
-                spawnNewObject();  
-                cout << "Spawning second object!" << endl;
+            spawnCopies(copiesPerSpawn);
+        }
+        if(e.key.keysym.sym == SDLK_TAB) // 'Tab' = select the next object for transformations
+        {
+            if (!scene.empty()) {
+                selectedObject = (selectedObject + 1) % scene.size();
+                cout << "Selected object " << selectedObject << " of " << scene.size() << endl;
             }
-            else cout << "Already have two models in the scene, sorry!" << endl;
         }
     }
     
@@ -396,9 +983,8 @@ bool OpenGLWindow::handleEvent(SDL_Event e) { // event handler for SDL key press
             sign = -1;
 
 
-        if (transformationMode == ROTATE) { // apply rotation
+        if (transformationMode == ROTATE) { // apply rotation, about the object's own origin
             glm::mat4 trans;
-            trans = glm::translate(trans, translation);
 
             if (transformationAxis == X) {
                 trans = glm::rotate(trans, glm::radians(sign * 5.0f), glm::vec3(1.0, 0.0, 0.0));
@@ -410,9 +996,7 @@ bool OpenGLWindow::handleEvent(SDL_Event e) { // event handler for SDL key press
                 trans = glm::rotate(trans, glm::radians(sign * 5.0f), glm::vec3(0.0, 0.0, 1.0));             
             }
 
-            trans = glm::translate(trans, -translation);
-            Model *= trans;
-            MVP = Projection * View * Model;            
+            transformSelected(trans);
             return true;
         }
 
@@ -420,27 +1004,25 @@ bool OpenGLWindow::handleEvent(SDL_Event e) { // event handler for SDL key press
             if (transformationAxis == X) {
                 glm::mat4 trans;
                 trans = glm::scale(trans, glm::vec3(1.0 + (sign * 0.1), 1.0, 1.0));
-                Model *= trans;
+                transformSelected(trans);
             }
             else if (transformationAxis == Y) {
                 glm::mat4 trans;
                 trans = glm::scale(trans, glm::vec3(1.0, 1.0 + (sign * 0.1), 1.0));
-                Model *= trans;                
+                transformSelected(trans);
             }
             else if (transformationAxis == Z) {
                 glm::mat4 trans;
                 trans = glm::scale(trans, glm::vec3(1.0, 1.0, 1.0 + (sign * 0.1)));
-                Model *= trans;                
+                transformSelected(trans);
             }
-            MVP = Projection * View * Model;            
             return true;
         } 
 
         else if (transformationMode == SCALEALL) { // apply uniform scale
             glm::mat4 trans;
             trans = glm::scale(trans, glm::vec3(1.0 + (sign * 0.1), 1.0 + (sign * 0.1), 1.0 + (sign * 0.1)));
-            Model *= trans;   
-            MVP = Projection * View * Model;            
+            transformSelected(trans);
             return true;
         } 
 
@@ -448,23 +1030,23 @@ bool OpenGLWindow::handleEvent(SDL_Event e) { // event handler for SDL key press
             if (transformationAxis == X) {
                 glm::mat4 trans;
                 trans = glm::translate(trans, glm::vec3(sign * 0.1, 0.0, 0.0));
-                translation.x += sign * 0.1;
-                Model *= trans;
+                transformSelected(trans);
             }
             else if (transformationAxis == Y) {
                 glm::mat4 trans;
                 trans = glm::translate(trans, glm::vec3(0.0, sign * 0.1, 0.0));
-                translation.y += sign * 0.1;
-                Model *= trans;                
+                transformSelected(trans);
             }
             else if (transformationAxis == Z) {
                 glm::mat4 trans;
                 trans = glm::translate(trans, glm::vec3(0.0, 0.0, sign * 0.1));
-                translation.z += sign * 0.1;
-                Model *= trans;                
+                transformSelected(trans);
+            }
+            if (selectedObject < scene.size()) {
+                glm::vec4 position = scene.transform(selectedObject)[3];
+                cout << "Object " << selectedObject << " position: (" << position.x << ", " << position.y << ", "
+                     << position.z << ")" << endl;
             }
-            cout << "Oject translation: (" << translation.x << ", " << translation.y << ", " << translation.z << ")" << endl;
-            MVP = Projection * View * Model;            
             return true;
         } 
 
@@ -477,6 +1059,13 @@ bool OpenGLWindow::handleEvent(SDL_Event e) { // event handler for SDL key press
 
 void OpenGLWindow::cleanup()
 {
+    // NOTE: Dropping the scene's handles frees every mesh nothing else refers to. A load still
+    //       running on the loader thread keeps its mesh, and that gets freed with the context
+    pendingModel = LoadedModel();
+    scene.clear();
+    meshRegistry.deleteReleasedObjects();
+
+    glDeleteBuffers(1, &objectBuffer);
     glDeleteBuffers(1, &vertexBuffer);
     glDeleteVertexArrays(1, &vao);
     SDL_DestroyWindow(sdlWin);
@@ -3,8 +3,15 @@
 
 #include <GL/glew.h>
 #include <string>
+#include <vector>
 
 #include "geometry.h"
+#include "vertexformat.h"
+#include "glvertexformat.h"
+#include "modelloader.h"
+#include "meshregistry.h"
+#include "meshlets.h"
+#include "scene.h"
 
 // Include GLM
 #include <glm/glm.hpp>
@@ -33,26 +40,75 @@ private:
 
     SDL_Window* sdlWin;
 
-    GLuint vao;
     GLuint shader;
-    GLuint vertexBuffer;
-    GLuint vertexCount;
-    GLuint vertexCount2;
-    GLuint MatrixID;
-    int colorLoc;
+    GLint viewProjectionLoc;
+    InstanceAttributeLocations instanceLocations;
+
+    // NOTE: The scene's transforms and colors as of this frame, as instance records in draw order:
+    //       sorted by mesh and LOD, so that the copies of a mesh are one instanced draw
+    GLuint objectBuffer = 0;
+    size_t objectBufferBytes = 0;
+    std::vector<uint32_t> drawOrder;
+
+    // NOTE: A first model too big to load whole is streamed into a buffer of its own, as triangle
+    //       soup, and drawn from vao instead of going through the registry: it is the scene object
+    //       without a mesh
+    GLuint vao;
+    GLuint vertexBuffer = 0;
+    GLuint vertexCount = 0;
+    MeshBounds streamedBounds = MeshBounds();
+
+    // NOTE: Vertex buffers hold one interleaved vertex per index, with just the attributes that both
+    //       the shader reads and the loaded model has
+    GLint attributeLocations[VERTEX_ATTRIBUTE_COUNT];
+
+    // NOTE: Declared ahead of everything holding a MeshHandle, which all have to go before it does
+    MeshRegistry meshRegistry;
+
+    // NOTE: Objects showing the same file share one mesh, and so one set of buffers
+    Scene scene;
+    size_t selectedObject = 0;
+
+    // NOTE: Each further model is loaded (and packed, unless its mesh is already resident) on the
+    //       loader thread, then copied into its mesh's buffers a slice per frame by updateLoading(),
+    //       so the window never stops rendering
+    ModelLoader loader;
+    LoadedModel pendingModel;
+    size_t uploadedVertexBytes = 0;
+    size_t uploadedIndexBytes = 0;
+    bool uploadingModel = false;
+    bool awaitingFilename = false;
+
+    // Triangles drawn last frame, against what drawing every object at full detail would have been
+    size_t lastSubmittedTriangles = 0;
+    size_t lastFullDetailTriangles = 0;
+
+    // NOTE: Meshlet culling's scratch space, kept between frames, and its costs and savings since the
+    //       last report
+    std::vector<uint32_t> visibleMeshlets;
+    std::vector<GLsizei> meshletDrawCounts;
+    std::vector<const void*> meshletDrawOffsets;
+    double cullSeconds = 0.0;
+    size_t cullTestedTriangles = 0;
+    size_t cullRejectedTriangles = 0;
+    int cullFrames = 0;
+    Uint32 lastCullReport = 0;
 
     bool partyMode = false;
-    bool spawnedSecondObj = false;
 
     std::string filename1, filename2;
 
-    glm::vec3 translation;
-	glm::mat4 Model;
 	glm::mat4 View;
 	glm::mat4 Projection;
-	glm::mat4 MVP;
+	glm::mat4 ViewProjection;
 
     void changeAxis();
+    void updateLoading();
+    void uploadObjectData();
+    void transformSelected(const glm::mat4& trans);
+    void spawnCopies(size_t count);
+    size_t drawVisibleMeshlets(const MeshletTable& meshlets, const glm::mat4& objectMVP, const glm::mat4& objectModel);
+    void reportCulling();
 
 };
 
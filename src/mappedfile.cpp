@@ -0,0 +1,162 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "mappedfile.h"
+
+// NOTE: Zero-length files can't be mapped, so we hand out a pointer to this instead, which keeps
+//       the (data, data+size) range valid for callers
+static const char emptyFileData[1] = {0};
+
+MappedFile::MappedFile()
+    : mappedData(0), mappedSize(0)
+#ifdef _WIN32
+    , fileHandle(INVALID_HANDLE_VALUE), mappingHandle(0)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    if(fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        mappedData = emptyFileData;
+        mappedSize = 0;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    mappedData = (const char*)view;
+    mappedSize = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(mappedData && (mappedData != emptyFileData))
+    {
+        UnmapViewOfFile(mappedData);
+        CloseHandle((HANDLE)mappingHandle);
+        CloseHandle((HANDLE)fileHandle);
+    }
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = 0;
+    mappedData = 0;
+    mappedSize = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    struct stat fileInfo;
+    if(fstat(fd, &fileInfo) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if(fileInfo.st_size == 0)
+    {
+        ::close(fd);
+        mappedData = emptyFileData;
+        mappedSize = 0;
+        return true;
+    }
+
+    void* view = mmap(0, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // NOTE: The mapping keeps its own reference to the file, so the descriptor can go right away
+    ::close(fd);
+    if(view == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // We walk the file front to back exactly once, so let the kernel read ahead aggressively
+    madvise(view, fileInfo.st_size, MADV_SEQUENTIAL);
+
+    mappedData = (const char*)view;
+    mappedSize = (size_t)fileInfo.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(mappedData && (mappedData != emptyFileData))
+    {
+        munmap((void*)mappedData, mappedSize);
+    }
+    mappedData = 0;
+    mappedSize = 0;
+}
+
+#endif
+
+bool MappedFile::isOpen()
+{
+    return mappedData != 0;
+}
+
+const char* MappedFile::data()
+{
+    return mappedData;
+}
+
+size_t MappedFile::size()
+{
+    return mappedSize;
+}
@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <stddef.h>
+
+// NOTE: A read-only view of a whole file, mapped straight into our address space so that the
+//       parsers can walk it with a plain pointer range instead of going through a stream
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen();
+    const char* data();
+    size_t size();
+
+private:
+    // NOTE: Copying would leave two objects owning the same mapping
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* mappedData;
+    size_t mappedSize;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+#endif
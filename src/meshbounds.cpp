@@ -0,0 +1,183 @@
+#include <algorithm>
+
+#include <float.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define MESH_BOUNDS_SSE2
+#endif
+
+using namespace std;
+
+#include "meshbounds.h"
+#include "workerpool.h"
+
+// Meshes smaller than this are scanned on the calling thread, the pool would only slow them down
+static const size_t minimumVerticesPerTask = 256 * 1024;
+static const size_t maximumTaskCount = 64;
+
+#ifdef MESH_BOUNDS_SSE2
+// NOTE: Four packed xyz positions are three registers, [x0 y0 z0 x1] [y1 z1 x2 y2] [z2 x3 y3 z3],
+//       which get shuffled into one register per axis so the rest of the work is plain SIMD
+static inline void loadFourPositions(const float* positions, __m128& x, __m128& y, __m128& z)
+{
+    __m128 first = _mm_loadu_ps(positions);
+    __m128 second = _mm_loadu_ps(positions + 4);
+    __m128 third = _mm_loadu_ps(positions + 8);
+
+    __m128 xTail = _mm_shuffle_ps(second, third, _MM_SHUFFLE(1, 1, 2, 2));
+    x = _mm_shuffle_ps(first, xTail, _MM_SHUFFLE(2, 0, 3, 0));
+    __m128 yHead = _mm_shuffle_ps(first, second, _MM_SHUFFLE(0, 0, 1, 1));
+    __m128 yTail = _mm_shuffle_ps(second, third, _MM_SHUFFLE(2, 2, 3, 3));
+    y = _mm_shuffle_ps(yHead, yTail, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 zHead = _mm_shuffle_ps(first, second, _MM_SHUFFLE(1, 1, 2, 2));
+    __m128 zTail = _mm_shuffle_ps(third, third, _MM_SHUFFLE(3, 3, 0, 0));
+    z = _mm_shuffle_ps(zHead, zTail, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+static inline float horizontalMin(__m128 values)
+{
+    float lanes[4];
+    _mm_storeu_ps(lanes, values);
+    return min(min(lanes[0], lanes[1]), min(lanes[2], lanes[3]));
+}
+
+static inline float horizontalMax(__m128 values)
+{
+    float lanes[4];
+    _mm_storeu_ps(lanes, values);
+    return max(max(lanes[0], lanes[1]), max(lanes[2], lanes[3]));
+}
+#endif
+
+static void boxOfRange(const float* positions, size_t firstVertex, size_t endVertex, float* lower, float* upper)
+{
+    for(int axis=0; axis<3; axis++)
+    {
+        lower[axis] = FLT_MAX;
+        upper[axis] = -FLT_MAX;
+    }
+
+    size_t vertex = firstVertex;
+#ifdef MESH_BOUNDS_SSE2
+    __m128 lowerX = _mm_set1_ps(FLT_MAX), lowerY = lowerX, lowerZ = lowerX;
+    __m128 upperX = _mm_set1_ps(-FLT_MAX), upperY = upperX, upperZ = upperX;
+    for(; vertex + 4 <= endVertex; vertex += 4)
+    {
+        __m128 x, y, z;
+        loadFourPositions(&positions[3*vertex], x, y, z);
+        lowerX = _mm_min_ps(lowerX, x);
+        lowerY = _mm_min_ps(lowerY, y);
+        lowerZ = _mm_min_ps(lowerZ, z);
+        upperX = _mm_max_ps(upperX, x);
+        upperY = _mm_max_ps(upperY, y);
+        upperZ = _mm_max_ps(upperZ, z);
+    }
+    lower[0] = horizontalMin(lowerX);
+    lower[1] = horizontalMin(lowerY);
+    lower[2] = horizontalMin(lowerZ);
+    upper[0] = horizontalMax(upperX);
+    upper[1] = horizontalMax(upperY);
+    upper[2] = horizontalMax(upperZ);
+#endif
+
+    for(; vertex<endVertex; vertex++)
+    {
+        for(int axis=0; axis<3; axis++)
+        {
+            lower[axis] = min(lower[axis], positions[3*vertex + axis]);
+            upper[axis] = max(upper[axis], positions[3*vertex + axis]);
+        }
+    }
+}
+
+// Largest squared distance from centre to a vertex in the range
+static float radiusOfRange(const float* positions, size_t firstVertex, size_t endVertex, const float* centre)
+{
+    float furthest = 0.0f;
+    size_t vertex = firstVertex;
+#ifdef MESH_BOUNDS_SSE2
+    __m128 centreX = _mm_set1_ps(centre[0]);
+    __m128 centreY = _mm_set1_ps(centre[1]);
+    __m128 centreZ = _mm_set1_ps(centre[2]);
+    __m128 furthestSquared = _mm_setzero_ps();
+    for(; vertex + 4 <= endVertex; vertex += 4)
+    {
+        __m128 x, y, z;
+        loadFourPositions(&positions[3*vertex], x, y, z);
+        x = _mm_sub_ps(x, centreX);
+        y = _mm_sub_ps(y, centreY);
+        z = _mm_sub_ps(z, centreZ);
+        __m128 squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        furthestSquared = _mm_max_ps(furthestSquared, squared);
+    }
+    furthest = horizontalMax(furthestSquared);
+#endif
+
+    for(; vertex<endVertex; vertex++)
+    {
+        float x = positions[3*vertex] - centre[0];
+        float y = positions[3*vertex + 1] - centre[1];
+        float z = positions[3*vertex + 2] - centre[2];
+        furthest = max(furthest, x*x + y*y + z*z);
+    }
+    return furthest;
+}
+
+MeshBounds computeMeshBounds(const float* positions, size_t vertexCount)
+{
+    MeshBounds bounds = MeshBounds();
+    if(vertexCount == 0)
+    {
+        return bounds;
+    }
+
+    // NOTE: Scanning is cheap next to everything else the loader does, so it shouldn't allocate
+    //       either: the per task results live on the stack, and one task runs without the pool
+    WorkerPool& pool = WorkerPool::shared();
+    size_t taskCount = min<size_t>(pool.threadCount() * 2, vertexCount / minimumVerticesPerTask);
+    taskCount = max<size_t>(min(taskCount, maximumTaskCount), 1);
+    float taskResults[maximumTaskCount * 6];
+    auto boxTask = [&](int taskIndex)
+    {
+        boxOfRange(positions, (vertexCount * taskIndex) / taskCount, (vertexCount * (taskIndex + 1)) / taskCount,
+                   &taskResults[6*taskIndex], &taskResults[6*taskIndex + 3]);
+    };
+    if(taskCount == 1)
+    {
+        boxTask(0);
+    }
+    else
+    {
+        pool.run(taskCount, boxTask);
+    }
+
+    for(int axis=0; axis<3; axis++)
+    {
+        bounds.lower[axis] = FLT_MAX;
+        bounds.upper[axis] = -FLT_MAX;
+        for(size_t task=0; task<taskCount; task++)
+        {
+            bounds.lower[axis] = min(bounds.lower[axis], taskResults[6*task + axis]);
+            bounds.upper[axis] = max(bounds.upper[axis], taskResults[6*task + 3 + axis]);
+        }
+        bounds.centre[axis] = (bounds.lower[axis] + bounds.upper[axis]) * 0.5f;
+    }
+
+    auto radiusTask = [&](int taskIndex)
+    {
+        taskResults[taskIndex] = radiusOfRange(positions, (vertexCount * taskIndex) / taskCount,
+                                               (vertexCount * (taskIndex + 1)) / taskCount, bounds.centre);
+    };
+    if(taskCount == 1)
+    {
+        radiusTask(0);
+    }
+    else
+    {
+        pool.run(taskCount, radiusTask);
+    }
+    bounds.radius = sqrtf(*max_element(taskResults, taskResults + taskCount));
+    return bounds;
+}
@@ -0,0 +1,21 @@
+#ifndef MESH_BOUNDS_H
+#define MESH_BOUNDS_H
+
+#include <stddef.h>
+
+// NOTE: Axis aligned bounding box of a mesh's positions, and a bounding sphere around the box's
+//       centre that just reaches the furthest vertex (which is tighter than the box's own sphere).
+//       An empty mesh has everything at zero
+struct MeshBounds
+{
+    float lower[3];
+    float upper[3];
+    float centre[3];
+    float radius;
+};
+
+// Scans vertexCount positions (3 floats each), four vertices at a time with SSE2 where available and
+// split across the worker pool for big meshes
+MeshBounds computeMeshBounds(const float* positions, size_t vertexCount);
+
+#endif
@@ -0,0 +1,595 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#include "meshcache.h"
+
+static const char meshCacheMagic[8] = {'M', 'E', 'S', 'H', 'C', 'A', 'C', 'H'};
+static const uint64_t sectionAlignment = 64;
+
+static string cacheDirectory;
+static bool verifyContents = false;
+static atomic<unsigned int> temporaryCount(0);
+static vector<float> lodRatios(defaultLODRatios, defaultLODRatios + defaultLODLevelCount);
+
+// NOTE: Everything we know about an OBJ file on disk, which together decide whether a cache entry
+//       built from it can still be used. The hash means reading the whole file, so it is only filled
+//       in (and hashed set) when an entry is built or contents verification is on
+struct SourceFileKey
+{
+    string path;
+    uint64_t size;
+    int64_t modifiedTime;
+    uint64_t hash;
+    bool hashed;
+};
+
+static inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t hashContents(const void* data, size_t size)
+{
+    const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+    const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+
+    // NOTE: Four independent lanes, each eating 8 bytes per step, so that the multiplies from
+    //       consecutive words don't have to wait on each other
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t lanes[4] = {prime1 + prime2, prime2, 0, 0 - prime1};
+    size_t blockCount = size / 32;
+    for(size_t blockIndex=0; blockIndex<blockCount; blockIndex++)
+    {
+        for(int lane=0; lane<4; lane++)
+        {
+            uint64_t word;
+            memcpy(&word, bytes + (blockIndex*32) + (lane*8), 8);
+            lanes[lane] = rotateLeft(lanes[lane] + (word * prime2), 31) * prime1;
+        }
+    }
+
+    uint64_t hash = (uint64_t)size * prime1;
+    for(int lane=0; lane<4; lane++)
+    {
+        hash = rotateLeft(hash ^ lanes[lane], 27) * prime1 + prime2;
+    }
+    for(size_t byteIndex=blockCount*32; byteIndex<size; byteIndex++)
+    {
+        hash = rotateLeft(hash ^ (bytes[byteIndex] * prime2), 11) * prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+static bool readSourceKey(const string& filename, SourceFileKey& key)
+{
+#ifdef _WIN32
+    char* resolvedPath = _fullpath(NULL, filename.c_str(), 0);
+#else
+    char* resolvedPath = realpath(filename.c_str(), NULL);
+#endif
+    if(!resolvedPath)
+    {
+        return false;
+    }
+    key.path = resolvedPath;
+    free(resolvedPath);
+
+    struct stat fileInfo;
+    if(stat(key.path.c_str(), &fileInfo) != 0)
+    {
+        return false;
+    }
+    key.size = (uint64_t)fileInfo.st_size;
+    key.modifiedTime = (int64_t)fileInfo.st_mtime;
+    key.hash = 0;
+    key.hashed = false;
+    return true;
+}
+
+static bool hashSource(SourceFileKey& key)
+{
+    MappedFile source;
+    if(!source.open(key.path))
+    {
+        return false;
+    }
+    key.size = source.size();
+    key.hash = hashContents(source.data(), source.size());
+    key.hashed = true;
+    return true;
+}
+
+static bool shouldVerifyContents()
+{
+    const char* setting = getenv("MESH_CACHE_VERIFY");
+    return verifyContents || (setting && (strcmp(setting, "0") != 0));
+}
+
+static string cacheFilename(const SourceFileKey& key)
+{
+    string directory = cacheDirectory;
+    if(directory.empty() && getenv("MESH_CACHE_DIR"))
+    {
+        directory = getenv("MESH_CACHE_DIR");
+    }
+    if(directory.empty())
+    {
+        return key.path + ".meshcache";
+    }
+
+    char pathHash[17];
+    snprintf(pathHash, sizeof(pathHash), "%016llx",
+             (unsigned long long)hashContents(key.path.data(), key.path.size()));
+    return directory + "/" + pathHash + ".meshcache";
+}
+
+static bool headerMatches(const MeshCacheHeader* header, size_t fileSize, const SourceFileKey& key,
+                          unsigned int optimizations)
+{
+    if((fileSize < sizeof(MeshCacheHeader)) ||
+       (memcmp(header->magic, meshCacheMagic, sizeof(meshCacheMagic)) != 0) ||
+       (header->version != meshCacheVersion) ||
+       (header->headerSize != sizeof(MeshCacheHeader)))
+    {
+        return false;
+    }
+
+    if((strncmp(header->sourcePath, key.path.c_str(), sizeof(header->sourcePath)) != 0) ||
+       (header->sourceSize != key.size) ||
+       (header->sourceModifiedTime != key.modifiedTime) ||
+       (key.hashed && (header->sourceHash != key.hash)) ||
+       (header->optimizations != optimizations))
+    {
+        return false;
+    }
+
+    if(header->lodLevelCount > maxLODLevels)
+    {
+        return false;
+    }
+    if(!(optimizations & MESH_OPTIMIZE_LOD_CHAIN) && (header->lodLevelCount != 0))
+    {
+        return false;
+    }
+    if(optimizations & MESH_OPTIMIZE_LOD_CHAIN)
+    {
+        if((header->lodLevelCount != lodRatios.size()) ||
+           (!lodRatios.empty() && (memcmp(header->lodRatios, &lodRatios[0], lodRatios.size() * sizeof(float)) != 0)))
+        {
+            return false;
+        }
+        for(uint32_t level=0; level<header->lodLevelCount; level++)
+        {
+            const MeshLOD& lod = header->lods[level];
+            if(((uint64_t)lod.firstIndex + lod.indexCount) * sizeof(unsigned int) > header->sections[MESH_CACHE_LOD_INDICES].size)
+            {
+                return false;
+            }
+        }
+    }
+
+    // Guard against truncated files, every section has to lie entirely inside the file
+    for(int section=0; section<MESH_CACHE_SECTION_COUNT; section++)
+    {
+        const MeshCacheSectionEntry& entry = header->sections[section];
+        if((entry.offset % sectionAlignment != 0) || (entry.offset > fileSize) ||
+           (entry.size > fileSize - entry.offset))
+        {
+            return false;
+        }
+    }
+
+    // NOTE: Every array gets read vertexCount (or indexCount) elements at a time, so each one that is
+    //       there has to hold exactly that many. The optional attributes may be missing altogether,
+    //       except that tangents and bitangents always come together
+    const uint64_t vertexCount = header->vertexCount;
+    const uint64_t attributeComponents[VERTEX_ATTRIBUTE_COUNT] = {3, 2, 3, 3, 3};
+    const MeshCacheSection attributeSections[VERTEX_ATTRIBUTE_COUNT] =
+    {
+        MESH_CACHE_POSITIONS, MESH_CACHE_TEXTURE_COORDS, MESH_CACHE_NORMALS, MESH_CACHE_TANGENTS,
+        MESH_CACHE_BITANGENTS
+    };
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        uint64_t size = header->sections[attributeSections[attribute]].size;
+        bool optional = (attribute != VERTEX_POSITION);
+        if((size != vertexCount * attributeComponents[attribute] * sizeof(float)) && !(optional && (size == 0)))
+        {
+            return false;
+        }
+    }
+    if(header->sections[MESH_CACHE_TANGENTS].size != header->sections[MESH_CACHE_BITANGENTS].size)
+    {
+        return false;
+    }
+    if((header->sections[MESH_CACHE_INDICES].size != (uint64_t)header->indexCount * sizeof(unsigned int)) ||
+       (header->sections[MESH_CACHE_MESHLETS].size !=
+        (header->meshletCount ? meshletTableWords(header->meshletCount) * sizeof(uint32_t) : 0)))
+    {
+        return false;
+    }
+
+    // and every meshlet's range has to lie inside the index section
+    const char* meshletData = (const char*)header + header->sections[MESH_CACHE_MESHLETS].offset;
+    MeshletTable meshlets = meshletTable((const uint32_t*)meshletData, header->meshletCount);
+    for(size_t meshlet=0; meshlet<meshlets.count; meshlet++)
+    {
+        if((uint64_t)meshlets.firstIndex[meshlet] + meshlets.indexCount[meshlet] > header->indexCount)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint64_t alignSectionOffset(uint64_t offset)
+{
+    return (offset + sectionAlignment - 1) & ~(sectionAlignment - 1);
+}
+
+MeshCache::MeshCache()
+    : header(0)
+{
+}
+
+void MeshCache::setCacheDirectory(const string& directory)
+{
+    cacheDirectory = directory;
+}
+
+void MeshCache::setVerifyContents(bool verify)
+{
+    verifyContents = verify;
+}
+
+void MeshCache::setLODRatios(const vector<float>& ratios)
+{
+    lodRatios.assign(ratios.begin(), ratios.begin() + min<size_t>(ratios.size(), maxLODLevels));
+}
+
+bool MeshCache::load(const string& objFilename, unsigned int optimizations)
+{
+    header = 0;
+    mappedFile.close();
+    builtData.clear();
+
+    chrono::steady_clock::time_point loadStart = chrono::steady_clock::now();
+
+    SourceFileKey key;
+    if(!readSourceKey(objFilename, key))
+    {
+        cout << "Unable to open obj file: " << objFilename << endl;
+        return false;
+    }
+
+    // NOTE: A path too long for the header can't key an entry, so that OBJ skips the cache and is
+    //       parsed every time
+    bool cacheable = key.path.size() < sizeof(header->sourcePath);
+    if(!cacheable)
+    {
+        cout << "Path too long for the mesh cache, parsing " << objFilename << " without it" << endl;
+    }
+
+    if(cacheable && shouldVerifyContents() && !hashSource(key))
+    {
+        cout << "Unable to open obj file: " << objFilename << endl;
+        return false;
+    }
+
+    string cachePath = cacheFilename(key);
+    if(cacheable && mappedFile.open(cachePath))
+    {
+        const MeshCacheHeader* mappedHeader = (const MeshCacheHeader*)mappedFile.data();
+        if(headerMatches(mappedHeader, mappedFile.size(), key, optimizations))
+        {
+            header = mappedHeader;
+            double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - loadStart).count();
+            cout << "Loaded " << objFilename << " from the mesh cache (" << vertexCount() << " vertices, "
+                 << indexCount()/3 << " triangles) in " << loadSeconds*1000.0 << " ms" << endl;
+            return true;
+        }
+        mappedFile.close();
+    }
+
+    // Cache miss, so do the full parse and build the entry in memory, hashing the OBJ for the key
+    if(!key.hashed && !hashSource(key))
+    {
+        cout << "Unable to open obj file: " << objFilename << endl;
+        return false;
+    }
+    GeometryData geometry;
+    if(!geometry.loadFromOBJFile(key.path))
+    {
+        return false;
+    }
+    geometry.optimize(optimizations, lodRatios.empty() ? 0 : &lodRatios[0], lodRatios.size());
+
+    const void* sectionSources[MESH_CACHE_SECTION_COUNT] = {};
+    uint64_t sectionSizes[MESH_CACHE_SECTION_COUNT] = {};
+    if(geometry.vertexCount() > 0)
+    {
+        sectionSources[MESH_CACHE_POSITIONS] = geometry.vertexData();
+        sectionSizes[MESH_CACHE_POSITIONS] = geometry.vertexCount() * 3 * sizeof(float);
+    }
+    if(geometry.hasTextureCoords())
+    {
+        sectionSources[MESH_CACHE_TEXTURE_COORDS] = geometry.textureCoordData();
+        sectionSizes[MESH_CACHE_TEXTURE_COORDS] = geometry.vertexCount() * 2 * sizeof(float);
+    }
+    if(geometry.hasNormals())
+    {
+        sectionSources[MESH_CACHE_NORMALS] = geometry.normalData();
+        sectionSizes[MESH_CACHE_NORMALS] = geometry.vertexCount() * 3 * sizeof(float);
+    }
+    if(geometry.hasTangents())
+    {
+        sectionSources[MESH_CACHE_TANGENTS] = geometry.tangentData();
+        sectionSizes[MESH_CACHE_TANGENTS] = geometry.vertexCount() * 3 * sizeof(float);
+        sectionSources[MESH_CACHE_BITANGENTS] = geometry.bitangentData();
+        sectionSizes[MESH_CACHE_BITANGENTS] = geometry.vertexCount() * 3 * sizeof(float);
+    }
+    if(geometry.indexCount() > 0)
+    {
+        sectionSources[MESH_CACHE_INDICES] = geometry.indexData();
+        sectionSizes[MESH_CACHE_INDICES] = geometry.indexCount() * sizeof(unsigned int);
+    }
+    MeshletTable meshlets = geometry.meshlets();
+    if(meshlets.count > 0)
+    {
+        // the table is one block, starting with its first field
+        sectionSources[MESH_CACHE_MESHLETS] = meshlets.centreX;
+        sectionSizes[MESH_CACHE_MESHLETS] = meshletTableWords(meshlets.count) * sizeof(uint32_t);
+    }
+    if(geometry.lodIndexCount() > 0)
+    {
+        sectionSources[MESH_CACHE_LOD_INDICES] = geometry.lodIndexData();
+        sectionSizes[MESH_CACHE_LOD_INDICES] = geometry.lodIndexCount() * sizeof(unsigned int);
+    }
+
+    MeshCacheHeader newHeader;
+    memset(&newHeader, 0, sizeof(newHeader));
+    memcpy(newHeader.magic, meshCacheMagic, sizeof(meshCacheMagic));
+    newHeader.version = meshCacheVersion;
+    newHeader.headerSize = sizeof(MeshCacheHeader);
+    strncpy(newHeader.sourcePath, key.path.c_str(), sizeof(newHeader.sourcePath) - 1);
+    newHeader.sourceSize = key.size;
+    newHeader.sourceModifiedTime = key.modifiedTime;
+    newHeader.sourceHash = key.hash;
+    newHeader.vertexCount = geometry.vertexCount();
+    newHeader.indexCount = geometry.indexCount();
+    newHeader.bounds = geometry.bounds();
+    newHeader.optimizations = optimizations;
+    newHeader.meshletCount = meshlets.count;
+    if(optimizations & MESH_OPTIMIZE_LOD_CHAIN)
+    {
+        newHeader.lodLevelCount = lodRatios.size();
+        for(size_t level=0; level<lodRatios.size(); level++)
+        {
+            newHeader.lodRatios[level] = lodRatios[level];
+        }
+        for(int level=0; level<geometry.lodLevelCount(); level++)
+        {
+            newHeader.lods[level] = geometry.lodLevels()[level];
+        }
+    }
+
+    uint64_t fileSize = alignSectionOffset(sizeof(MeshCacheHeader));
+    for(int section=0; section<MESH_CACHE_SECTION_COUNT; section++)
+    {
+        newHeader.sections[section].offset = fileSize;
+        newHeader.sections[section].size = sectionSizes[section];
+        fileSize = alignSectionOffset(fileSize + sectionSizes[section]);
+    }
+
+    // NOTE: Building into 64-bit words keeps the in-memory copy at least as aligned as the arrays in it
+    builtData.assign(fileSize / sizeof(uint64_t), 0);
+    char* fileData = (char*)&builtData[0];
+    memcpy(fileData, &newHeader, sizeof(newHeader));
+    for(int section=0; section<MESH_CACHE_SECTION_COUNT; section++)
+    {
+        if(sectionSizes[section] > 0)
+        {
+            memcpy(fileData + newHeader.sections[section].offset, sectionSources[section], sectionSizes[section]);
+        }
+    }
+    header = (const MeshCacheHeader*)fileData;
+    if(!cacheable)
+    {
+        return true;
+    }
+
+    // NOTE: Written to a temporary file first, so that a half-written entry can never be picked up,
+    //       named after this process and this write so that concurrent writers of one entry never share
+    //       one. rename() then replaces any old entry in one step, except on Windows, where it won't
+    //       replace an existing file, so the old one has to go first
+    char temporarySuffix[32];
+    snprintf(temporarySuffix, sizeof(temporarySuffix), ".%d.%u.tmp", (int)getpid(), temporaryCount++);
+    string temporaryPath = cachePath + temporarySuffix;
+    ofstream outStream(temporaryPath.c_str(), ofstream::out | ofstream::binary | ofstream::trunc);
+    outStream.write(fileData, fileSize);
+    outStream.close();
+#ifdef _WIN32
+    remove(cachePath.c_str());
+#endif
+    if(outStream.fail() || (rename(temporaryPath.c_str(), cachePath.c_str()) != 0))
+    {
+        remove(temporaryPath.c_str());
+        cout << "Unable to write mesh cache: " << cachePath << endl;
+    }
+    else
+    {
+        cout << "Wrote mesh cache: " << cachePath << endl;
+    }
+
+    return true;
+}
+
+const void* MeshCache::sectionData(MeshCacheSection section)
+{
+    if(!header || (header->sections[section].size == 0))
+    {
+        return 0;
+    }
+    return (const char*)header + header->sections[section].offset;
+}
+
+int MeshCache::vertexCount()
+{
+    return header ? header->vertexCount : 0;
+}
+
+int MeshCache::indexCount()
+{
+    return header ? header->indexCount : 0;
+}
+
+const MeshBounds& MeshCache::bounds()
+{
+    static const MeshBounds emptyBounds = MeshBounds();
+    return header ? header->bounds : emptyBounds;
+}
+
+MeshletTable MeshCache::meshlets()
+{
+    return meshletTable((const uint32_t*)sectionData(MESH_CACHE_MESHLETS), header ? header->meshletCount : 0);
+}
+
+int MeshCache::lodLevelCount()
+{
+    return header ? header->lodLevelCount : 0;
+}
+
+const MeshLOD* MeshCache::lodLevels()
+{
+    return header ? header->lods : 0;
+}
+
+int MeshCache::lodIndexCount()
+{
+    return header ? header->sections[MESH_CACHE_LOD_INDICES].size / sizeof(unsigned int) : 0;
+}
+
+const void* MeshCache::lodIndexData()
+{
+    return sectionData(MESH_CACHE_LOD_INDICES);
+}
+
+uint64_t MeshCache::sourceSize()
+{
+    return header ? header->sourceSize : 0;
+}
+
+int64_t MeshCache::sourceModifiedTime()
+{
+    return header ? header->sourceModifiedTime : 0;
+}
+
+uint64_t MeshCache::sourceHash()
+{
+    return header ? header->sourceHash : 0;
+}
+
+bool MeshCache::hasTextureCoords()
+{
+    return sectionData(MESH_CACHE_TEXTURE_COORDS) != 0;
+}
+
+bool MeshCache::hasNormals()
+{
+    return sectionData(MESH_CACHE_NORMALS) != 0;
+}
+
+bool MeshCache::hasTangents()
+{
+    return sectionData(MESH_CACHE_TANGENTS) != 0;
+}
+
+const void* MeshCache::vertexData()
+{
+    return sectionData(MESH_CACHE_POSITIONS);
+}
+
+const void* MeshCache::textureCoordData()
+{
+    return sectionData(MESH_CACHE_TEXTURE_COORDS);
+}
+
+const void* MeshCache::normalData()
+{
+    return sectionData(MESH_CACHE_NORMALS);
+}
+
+const void* MeshCache::tangentData()
+{
+    return sectionData(MESH_CACHE_TANGENTS);
+}
+
+const void* MeshCache::bitangentData()
+{
+    return sectionData(MESH_CACHE_BITANGENTS);
+}
+
+const void* MeshCache::indexData()
+{
+    return sectionData(MESH_CACHE_INDICES);
+}
+
+unsigned int MeshCache::vertexAttributes()
+{
+    unsigned int attributes = vertexAttributeBit(VERTEX_POSITION);
+    if(hasTextureCoords())
+    {
+        attributes |= vertexAttributeBit(VERTEX_TEXTURE_COORD);
+    }
+    if(hasNormals())
+    {
+        attributes |= vertexAttributeBit(VERTEX_NORMAL);
+    }
+    if(hasTangents())
+    {
+        attributes |= vertexAttributeBit(VERTEX_TANGENT) | vertexAttributeBit(VERTEX_BITANGENT);
+    }
+    return attributes;
+}
+
+const void* MeshCache::attributeData(VertexAttribute attribute)
+{
+    static const MeshCacheSection attributeSections[VERTEX_ATTRIBUTE_COUNT] =
+    {
+        MESH_CACHE_POSITIONS, MESH_CACHE_TEXTURE_COORDS, MESH_CACHE_NORMALS, MESH_CACHE_TANGENTS,
+        MESH_CACHE_BITANGENTS
+    };
+    return sectionData(attributeSections[attribute]);
+}
+
+void MeshCache::writeInterleavedVertices(const VertexFormat& format, void* destination)
+{
+    const void* sources[VERTEX_ATTRIBUTE_COUNT];
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        sources[attribute] = attributeData((VertexAttribute)attribute);
+    }
+    interleaveVertices(format, sources, vertexCount(), destination);
+}
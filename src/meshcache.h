@@ -0,0 +1,145 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "geometry.h"
+#include "mappedfile.h"
+
+// NOTE: The binary mesh cache stores the final arrays that GeometryData produces for an OBJ so that
+//       later runs can skip parsing altogether. A cache file is a MeshCacheHeader followed by one
+//       section per array, each starting on a 64 byte boundary, so once the file is mapped every
+//       array can be handed to glBufferData straight from the mapping.
+//
+//       An entry is only used if the OBJ's canonical path, size and modification time all match what
+//       was recorded when it was written, and its content hash too when contents verification is on
+//       (which means reading the whole OBJ on every load). Bump meshCacheVersion whenever the layout
+//       or the meaning of any section changes and old entries will simply be rebuilt
+
+const uint32_t meshCacheVersion = 7;
+
+enum MeshCacheSection
+{
+    MESH_CACHE_POSITIONS,
+    MESH_CACHE_TEXTURE_COORDS,
+    MESH_CACHE_NORMALS,
+    MESH_CACHE_TANGENTS,
+    MESH_CACHE_BITANGENTS,
+    MESH_CACHE_INDICES,
+    MESH_CACHE_LOD_INDICES,
+    MESH_CACHE_MESHLETS,
+    MESH_CACHE_SECTION_COUNT
+};
+
+struct MeshCacheSectionEntry
+{
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct MeshCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+
+    // The key: everything here has to match the OBJ on disk for the entry to be valid
+    char sourcePath[512];
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+    uint64_t sourceHash;
+
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    MeshBounds bounds;
+
+    // Mask of the MeshOptimization passes the arrays went through
+    uint32_t optimizations;
+
+    // The LOD chain, if there is one: the ratios it was asked for, and each level's range of the
+    // LOD index section
+    uint32_t lodLevelCount;
+    float lodRatios[maxLODLevels];
+    MeshLOD lods[maxLODLevels];
+
+    // Meshlets in the meshlet section, if there are any
+    uint32_t meshletCount;
+
+    MeshCacheSectionEntry sections[MESH_CACHE_SECTION_COUNT];
+};
+
+// Fast non-cryptographic 64-bit hash, used to spot OBJ files whose contents have changed
+uint64_t hashContents(const void* data, size_t size);
+
+class MeshCache
+{
+public:
+    MeshCache();
+
+    // Maps the cache entry for an OBJ file, parsing the OBJ (and writing a new entry) only when
+    // there is no up to date one, or the one there went through a different set of optimizations
+    // (a mask of MeshOptimization). Returns false if the OBJ itself couldn't be loaded
+    bool load(const std::string& objFilename, unsigned int optimizations=0);
+
+    // Entries go next to their OBJ files by default, or into this directory (also settable with the
+    // MESH_CACHE_DIR environment variable) named after a hash of the OBJ's canonical path
+    static void setCacheDirectory(const std::string& directory);
+
+    // Also compare the OBJ's content hash before using an entry, off by default. Setting the
+    // MESH_CACHE_VERIFY environment variable to anything but 0 turns it on too
+    static void setVerifyContents(bool verify);
+
+    // The ratios MESH_OPTIMIZE_LOD_CHAIN builds its levels at, defaultLODRatios unless set. Entries
+    // built with other ratios are rebuilt
+    static void setLODRatios(const std::vector<float>& ratios);
+
+    int vertexCount();
+    int indexCount();
+
+    bool hasTextureCoords();
+    bool hasNormals();
+    bool hasTangents();
+
+    const void* vertexData();
+    const void* textureCoordData();
+    const void* normalData();
+    const void* tangentData();
+    const void* bitangentData();
+    const void* indexData();
+
+    const MeshBounds& bounds();
+
+    // Same as the GeometryData versions, empty unless the entry was built with a LOD chain
+    int lodLevelCount();
+    const MeshLOD* lodLevels();
+    int lodIndexCount();
+    const void* lodIndexData();
+    MeshletTable meshlets();
+
+    // The OBJ file the entry was built from, as it was when it was read
+    uint64_t sourceSize();
+    int64_t sourceModifiedTime();
+    uint64_t sourceHash();
+
+    // Same as the GeometryData versions, reading from the cached arrays
+    unsigned int vertexAttributes();
+    const void* attributeData(VertexAttribute attribute);
+    void writeInterleavedVertices(const VertexFormat& format, void* destination);
+
+private:
+    MeshCache(const MeshCache&);
+    MeshCache& operator=(const MeshCache&);
+
+    const void* sectionData(MeshCacheSection section);
+
+    // NOTE: The header (and so every section) lives either in the mapped cache file, or in
+    //       builtData when the entry was just built and couldn't be mapped back from disk
+    MappedFile mappedFile;
+    std::vector<uint64_t> builtData;
+    const MeshCacheHeader* header;
+};
+
+#endif
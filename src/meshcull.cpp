@@ -0,0 +1,209 @@
+#include <math.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MESH_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define MESH_CULL_SSE2
+#endif
+
+using namespace std;
+
+#include "meshcull.h"
+
+FrustumPlanes extractFrustumPlanes(const float* mvp)
+{
+    // NOTE: Gribb and Hartmann: each plane is the last row of the matrix plus or minus one of the others
+    FrustumPlanes frustum;
+    for(int plane=0; plane<6; plane++)
+    {
+        int row = plane / 2;
+        float sign = (plane % 2 == 0) ? 1.0f : -1.0f;
+        for(int column=0; column<4; column++)
+        {
+            frustum.planes[plane][column] = mvp[column*4 + 3] + sign * mvp[column*4 + row];
+        }
+        float length = sqrtf(frustum.planes[plane][0]*frustum.planes[plane][0] +
+                             frustum.planes[plane][1]*frustum.planes[plane][1] +
+                             frustum.planes[plane][2]*frustum.planes[plane][2]);
+        float scale = (length > 0.0f) ? 1.0f / length : 0.0f;
+        for(int column=0; column<4; column++)
+        {
+            frustum.planes[plane][column] *= scale;
+        }
+    }
+    return frustum;
+}
+
+// Visible lanes of an 8 meshlet group, as a bitmask, from the meshlet at first onwards
+static inline unsigned int cullGroup(const MeshletTable& table, const FrustumPlanes& frustum,
+                                     const float* cameraPosition, size_t first)
+{
+#if defined(MESH_CULL_AVX)
+    __m256 centreX = _mm256_loadu_ps(table.centreX + first);
+    __m256 centreY = _mm256_loadu_ps(table.centreY + first);
+    __m256 centreZ = _mm256_loadu_ps(table.centreZ + first);
+    __m256 radius = _mm256_loadu_ps(table.radius + first);
+    __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), radius);
+
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for(int plane=0; plane<6; plane++)
+    {
+        const float* p = frustum.planes[plane];
+        __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                              _mm256_mul_ps(centreX, _mm256_set1_ps(p[0])),
+                              _mm256_mul_ps(centreY, _mm256_set1_ps(p[1]))),
+                              _mm256_mul_ps(centreZ, _mm256_set1_ps(p[2]))),
+                              _mm256_set1_ps(p[3]));
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GT_OQ));
+    }
+
+    if(cameraPosition)
+    {
+        __m256 toX = _mm256_sub_ps(centreX, _mm256_set1_ps(cameraPosition[0]));
+        __m256 toY = _mm256_sub_ps(centreY, _mm256_set1_ps(cameraPosition[1]));
+        __m256 toZ = _mm256_sub_ps(centreZ, _mm256_set1_ps(cameraPosition[2]));
+        __m256 along = _mm256_add_ps(_mm256_add_ps(
+                           _mm256_mul_ps(toX, _mm256_loadu_ps(table.coneAxisX + first)),
+                           _mm256_mul_ps(toY, _mm256_loadu_ps(table.coneAxisY + first))),
+                           _mm256_mul_ps(toZ, _mm256_loadu_ps(table.coneAxisZ + first)));
+        __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(
+                              _mm256_mul_ps(toX, toX), _mm256_mul_ps(toY, toY)), _mm256_mul_ps(toZ, toZ)));
+        __m256 limit = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(table.coneCutoff + first), distance), radius);
+        inside = _mm256_andnot_ps(_mm256_cmp_ps(along, limit, _CMP_GE_OQ), inside);
+    }
+    return _mm256_movemask_ps(inside);
+#elif defined(MESH_CULL_SSE2)
+    unsigned int mask = 0;
+    for(int half=0; half<2; half++)
+    {
+        size_t base = first + half*4;
+        __m128 centreX = _mm_loadu_ps(table.centreX + base);
+        __m128 centreY = _mm_loadu_ps(table.centreY + base);
+        __m128 centreZ = _mm_loadu_ps(table.centreZ + base);
+        __m128 radius = _mm_loadu_ps(table.radius + base);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(int plane=0; plane<6; plane++)
+        {
+            const float* p = frustum.planes[plane];
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                                  _mm_mul_ps(centreX, _mm_set1_ps(p[0])),
+                                  _mm_mul_ps(centreY, _mm_set1_ps(p[1]))),
+                                  _mm_mul_ps(centreZ, _mm_set1_ps(p[2]))),
+                                  _mm_set1_ps(p[3]));
+            inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negativeRadius));
+        }
+
+        if(cameraPosition)
+        {
+            __m128 toX = _mm_sub_ps(centreX, _mm_set1_ps(cameraPosition[0]));
+            __m128 toY = _mm_sub_ps(centreY, _mm_set1_ps(cameraPosition[1]));
+            __m128 toZ = _mm_sub_ps(centreZ, _mm_set1_ps(cameraPosition[2]));
+            __m128 along = _mm_add_ps(_mm_add_ps(
+                               _mm_mul_ps(toX, _mm_loadu_ps(table.coneAxisX + base)),
+                               _mm_mul_ps(toY, _mm_loadu_ps(table.coneAxisY + base))),
+                               _mm_mul_ps(toZ, _mm_loadu_ps(table.coneAxisZ + base)));
+            __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(
+                                  _mm_mul_ps(toX, toX), _mm_mul_ps(toY, toY)), _mm_mul_ps(toZ, toZ)));
+            __m128 limit = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(table.coneCutoff + base), distance), radius);
+            inside = _mm_andnot_ps(_mm_cmpge_ps(along, limit), inside);
+        }
+        mask |= _mm_movemask_ps(inside) << (half*4);
+    }
+    return mask;
+#else
+    unsigned int mask = 0;
+    for(int lane=0; lane<8; lane++)
+    {
+        size_t meshlet = first + lane;
+        float centreX = table.centreX[meshlet];
+        float centreY = table.centreY[meshlet];
+        float centreZ = table.centreZ[meshlet];
+        float radius = table.radius[meshlet];
+
+        bool inside = true;
+        for(int plane=0; plane<6; plane++)
+        {
+            const float* p = frustum.planes[plane];
+            float distance = ((centreX*p[0] + centreY*p[1]) + centreZ*p[2]) + p[3];
+            inside = inside && (distance > -radius);
+        }
+
+        if(inside && cameraPosition)
+        {
+            float toX = centreX - cameraPosition[0];
+            float toY = centreY - cameraPosition[1];
+            float toZ = centreZ - cameraPosition[2];
+            float along = (toX*table.coneAxisX[meshlet] + toY*table.coneAxisY[meshlet]) + toZ*table.coneAxisZ[meshlet];
+            float distance = sqrtf((toX*toX + toY*toY) + toZ*toZ);
+            inside = !(along >= table.coneCutoff[meshlet]*distance + radius);
+        }
+        mask |= (unsigned int)inside << lane;
+    }
+    return mask;
+#endif
+}
+
+size_t cullMeshlets(const MeshletTable& table, const FrustumPlanes& frustum, const float* cameraPosition,
+                    uint32_t* visible)
+{
+    // NOTE: The table is padded to whole groups, and the padding lanes are dropped here rather than
+    //       relying on how their zero spheres happen to test
+    size_t visibleCount = 0;
+    for(size_t first=0; first<table.count; first+=meshletTableAlignment)
+    {
+        unsigned int mask = cullGroup(table, frustum, cameraPosition, first);
+        for(unsigned int lane=0; (lane < meshletTableAlignment) && (first + lane < table.count); lane++)
+        {
+            if(mask & (1u << lane))
+            {
+                visible[visibleCount++] = first + lane;
+            }
+        }
+    }
+    return visibleCount;
+}
+
+size_t cullMeshletsReference(const MeshletTable& table, const FrustumPlanes& frustum, const float* cameraPosition,
+                             uint32_t* visible)
+{
+    size_t visibleCount = 0;
+    for(size_t meshlet=0; meshlet<table.count; meshlet++)
+    {
+        bool inside = true;
+        for(int plane=0; plane<6; plane++)
+        {
+            const float* p = frustum.planes[plane];
+            float distance = ((table.centreX[meshlet]*p[0] + table.centreY[meshlet]*p[1]) + table.centreZ[meshlet]*p[2]) + p[3];
+            inside = inside && (distance > -table.radius[meshlet]);
+        }
+        if(inside && cameraPosition)
+        {
+            float toX = table.centreX[meshlet] - cameraPosition[0];
+            float toY = table.centreY[meshlet] - cameraPosition[1];
+            float toZ = table.centreZ[meshlet] - cameraPosition[2];
+            float along = (toX*table.coneAxisX[meshlet] + toY*table.coneAxisY[meshlet]) + toZ*table.coneAxisZ[meshlet];
+            float distance = sqrtf((toX*toX + toY*toY) + toZ*toZ);
+            inside = !(along >= table.coneCutoff[meshlet]*distance + table.radius[meshlet]);
+        }
+        if(inside)
+        {
+            visible[visibleCount++] = meshlet;
+        }
+    }
+    return visibleCount;
+}
+
+const char* meshletCullPath()
+{
+#if defined(MESH_CULL_AVX)
+    return "AVX";
+#elif defined(MESH_CULL_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,41 @@
+#ifndef MESH_CULL_H
+#define MESH_CULL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "meshlets.h"
+
+// NOTE: The six clipping planes of a column major model-view-projection matrix (as glm lays it out),
+//       in model space and normalised, so that a point's signed distance from a plane is
+//       dot(plane.xyz, point) + plane.w in model units, positive on the inside. They go left, right,
+//       bottom, top, near, far
+struct FrustumPlanes
+{
+    float planes[6][4];
+};
+
+FrustumPlanes extractFrustumPlanes(const float* mvp);
+
+// NOTE: Writes the meshlets of table that could be visible into visible (which needs room for
+//       table.count), in table order, and returns how many there are. A meshlet is dropped when its
+//       bounding sphere is wholly outside any of the frustum planes, or, given cameraPosition (in model
+//       space), when its normal cone says every triangle in it faces away from the camera. The cone
+//       test only holds while the model matrix doesn't scale one axis more than another, so leave
+//       cameraPosition out when it might.
+//
+//       Eight meshlets are tested at a time: with AVX as one register per field, with SSE2 as two
+//       halves, and one after another otherwise, all with the same arithmetic, so every path gives
+//       the same answer
+size_t cullMeshlets(const MeshletTable& table, const FrustumPlanes& frustum, const float* cameraPosition,
+                    uint32_t* visible);
+
+// Slow but obviously correct version that tests one meshlet at a time, used by the benchmark and
+// the tests to check the one above
+size_t cullMeshletsReference(const MeshletTable& table, const FrustumPlanes& frustum, const float* cameraPosition,
+                             uint32_t* visible);
+
+// Which of the above cullMeshlets was built with: "AVX", "SSE2" or "scalar"
+const char* meshletCullPath();
+
+#endif
@@ -0,0 +1,349 @@
+#include <vector>
+#include <algorithm>
+
+#include <math.h>
+#include <string.h>
+
+using namespace std;
+
+#include "meshlets.h"
+
+static size_t paddedMeshletCount(size_t meshletCount)
+{
+    return (meshletCount + meshletTableAlignment - 1) / meshletTableAlignment * meshletTableAlignment;
+}
+
+size_t meshletTableWords(size_t meshletCount)
+{
+    return paddedMeshletCount(meshletCount) * MESHLET_FIELD_COUNT;
+}
+
+MeshletTable meshletTable(const uint32_t* tableData, size_t meshletCount)
+{
+    MeshletTable table;
+    table.count = meshletCount;
+    table.paddedCount = paddedMeshletCount(meshletCount);
+    const float* fields = (const float*)tableData;
+    size_t stride = table.paddedCount;
+    table.centreX = fields + MESHLET_CENTRE_X * stride;
+    table.centreY = fields + MESHLET_CENTRE_Y * stride;
+    table.centreZ = fields + MESHLET_CENTRE_Z * stride;
+    table.radius = fields + MESHLET_RADIUS * stride;
+    table.coneAxisX = fields + MESHLET_CONE_AXIS_X * stride;
+    table.coneAxisY = fields + MESHLET_CONE_AXIS_Y * stride;
+    table.coneAxisZ = fields + MESHLET_CONE_AXIS_Z * stride;
+    table.coneCutoff = fields + MESHLET_CONE_CUTOFF * stride;
+    table.firstIndex = tableData + MESHLET_FIRST_INDEX * stride;
+    table.indexCount = tableData + MESHLET_INDEX_COUNT * stride;
+    table.vertexCount = tableData + MESHLET_VERTEX_COUNT * stride;
+    return table;
+}
+
+static const unsigned int unusedTriangle = ~0u;
+static const unsigned int noMeshlet = ~0u;
+
+struct MeshletBuilder
+{
+    vector<unsigned int> vertices;
+    vector<unsigned int> triangles;
+    float centroid[3];
+};
+
+static void triangleCentroid(const unsigned int* corners, const float* positions, float* centroid)
+{
+    for(int i=0; i<3; i++)
+    {
+        centroid[i] = (positions[3*corners[0] + i] + positions[3*corners[1] + i] + positions[3*corners[2] + i]) / 3.0f;
+    }
+}
+
+// NOTE: Works out a finished meshlet's bounds. The sphere is centred on the middle of its vertices'
+//       box, which is never far off the smallest sphere for a patch this size. The cone axis is the
+//       mean of the triangle normals (each normalised, so big triangles don't outvote small ones)
+static void writeMeshletBounds(const MeshletBuilder& meshlet, const unsigned int* indices, const float* positions,
+                               uint32_t firstIndex, float* fields, size_t stride, size_t slot)
+{
+    float lower[3] = {positions[3*meshlet.vertices[0]], positions[3*meshlet.vertices[0] + 1], positions[3*meshlet.vertices[0] + 2]};
+    float upper[3] = {lower[0], lower[1], lower[2]};
+    for(size_t vertex=1; vertex<meshlet.vertices.size(); vertex++)
+    {
+        const float* position = &positions[3*meshlet.vertices[vertex]];
+        for(int i=0; i<3; i++)
+        {
+            lower[i] = min(lower[i], position[i]);
+            upper[i] = max(upper[i], position[i]);
+        }
+    }
+    float centre[3] = {(lower[0] + upper[0]) * 0.5f, (lower[1] + upper[1]) * 0.5f, (lower[2] + upper[2]) * 0.5f};
+    float radiusSquared = 0.0f;
+    for(size_t vertex=0; vertex<meshlet.vertices.size(); vertex++)
+    {
+        const float* position = &positions[3*meshlet.vertices[vertex]];
+        float dx = position[0] - centre[0], dy = position[1] - centre[1], dz = position[2] - centre[2];
+        radiusSquared = max(radiusSquared, dx*dx + dy*dy + dz*dz);
+    }
+
+    vector<float> normals(meshlet.triangles.size() * 3);
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    size_t normalCount = 0;
+    for(size_t triangle=0; triangle<meshlet.triangles.size(); triangle++)
+    {
+        const unsigned int* corners = &indices[3*meshlet.triangles[triangle]];
+        const float* p0 = &positions[3*corners[0]];
+        const float* p1 = &positions[3*corners[1]];
+        const float* p2 = &positions[3*corners[2]];
+        float edge1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float edge2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        float normal[3] = {edge1[1]*edge2[2] - edge1[2]*edge2[1],
+                           edge1[2]*edge2[0] - edge1[0]*edge2[2],
+                           edge1[0]*edge2[1] - edge1[1]*edge2[0]};
+        float length = sqrtf(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+        if(length <= 0.0f)
+        {
+            continue;
+        }
+        for(int i=0; i<3; i++)
+        {
+            normals[3*normalCount + i] = normal[i] / length;
+            axis[i] += normal[i] / length;
+        }
+        normalCount++;
+    }
+
+    // the cone has to hold every normal, so its angle is that of the one furthest from the axis
+    float axisLength = sqrtf(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+    float cutoff = 1.0f;
+    if(axisLength > 0.0f)
+    {
+        for(int i=0; i<3; i++)
+        {
+            axis[i] /= axisLength;
+        }
+        float minimumDot = 1.0f;
+        for(size_t normal=0; normal<normalCount; normal++)
+        {
+            const float* n = &normals[3*normal];
+            minimumDot = min(minimumDot, n[0]*axis[0] + n[1]*axis[1] + n[2]*axis[2]);
+        }
+        cutoff = (minimumDot <= 0.0f) ? 1.0f : sqrtf(1.0f - minimumDot * minimumDot);
+    }
+
+    uint32_t* words = (uint32_t*)fields;
+    fields[MESHLET_CENTRE_X * stride + slot] = centre[0];
+    fields[MESHLET_CENTRE_Y * stride + slot] = centre[1];
+    fields[MESHLET_CENTRE_Z * stride + slot] = centre[2];
+    fields[MESHLET_RADIUS * stride + slot] = sqrtf(radiusSquared);
+    fields[MESHLET_CONE_AXIS_X * stride + slot] = axis[0];
+    fields[MESHLET_CONE_AXIS_Y * stride + slot] = axis[1];
+    fields[MESHLET_CONE_AXIS_Z * stride + slot] = axis[2];
+    fields[MESHLET_CONE_CUTOFF * stride + slot] = cutoff;
+    words[MESHLET_FIRST_INDEX * stride + slot] = firstIndex;
+    words[MESHLET_INDEX_COUNT * stride + slot] = meshlet.triangles.size() * 3;
+    words[MESHLET_VERTEX_COUNT * stride + slot] = meshlet.vertices.size();
+}
+
+static float centroidDistanceSquared(const MeshletBuilder& meshlet, const float* point)
+{
+    float dx = point[0] - meshlet.centroid[0];
+    float dy = point[1] - meshlet.centroid[1];
+    float dz = point[2] - meshlet.centroid[2];
+    return dx*dx + dy*dy + dz*dz;
+}
+
+// Squared distance from the meshlet's centroid to its furthest vertex
+static float reachSquared(const MeshletBuilder& meshlet, const float* positions)
+{
+    float reach = 0.0f;
+    for(size_t vertex=0; vertex<meshlet.vertices.size(); vertex++)
+    {
+        reach = max(reach, centroidDistanceSquared(meshlet, &positions[3*meshlet.vertices[vertex]]));
+    }
+    return reach;
+}
+
+size_t buildMeshlets(unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount,
+                     vector<uint32_t>& tableData)
+{
+    size_t faceCount = indexCount / 3;
+    if(faceCount == 0)
+    {
+        tableData.clear();
+        return 0;
+    }
+
+    // Each vertex's triangles, to find the ones next to a meshlet
+    vector<unsigned int> faceStart(vertexCount + 1, 0);
+    for(size_t index=0; index<faceCount*3; index++)
+    {
+        faceStart[indices[index] + 1]++;
+    }
+    for(size_t vertex=0; vertex<vertexCount; vertex++)
+    {
+        faceStart[vertex + 1] += faceStart[vertex];
+    }
+    vector<unsigned int> vertexFaces(faceCount * 3);
+    {
+        vector<unsigned int> filled(faceStart.begin(), faceStart.end() - 1);
+        for(size_t index=0; index<faceCount*3; index++)
+        {
+            vertexFaces[filled[indices[index]]++] = index / 3;
+        }
+    }
+
+    vector<float> centroids(faceCount * 3);
+    for(size_t face=0; face<faceCount; face++)
+    {
+        triangleCentroid(&indices[3*face], positions, &centroids[3*face]);
+    }
+
+    // NOTE: meshletOfVertex says which meshlet last took each vertex, so checking whether a vertex is
+    //       already in the current one needs no clearing between meshlets. candidates holds every
+    //       triangle touching the meshlet, some of them already taken, as each vertex's triangles are
+    //       added when the vertex joins
+    vector<unsigned int> meshletOfVertex(vertexCount, noMeshlet);
+    vector<char> faceUsed(faceCount, 0);
+    vector<unsigned int> candidates;
+    vector<MeshletBuilder> meshlets;
+    size_t seedCursor = 0;
+    while(true)
+    {
+        while((seedCursor < faceCount) && faceUsed[seedCursor])
+        {
+            seedCursor++;
+        }
+        if(seedCursor == faceCount)
+        {
+            break;
+        }
+
+        unsigned int meshletIndex = meshlets.size();
+        meshlets.push_back(MeshletBuilder());
+        MeshletBuilder& meshlet = meshlets.back();
+        float centroidSum[3] = {0.0f, 0.0f, 0.0f};
+        candidates.clear();
+        unsigned int next = seedCursor;
+        while(next != unusedTriangle)
+        {
+            const unsigned int* corners = &indices[3*next];
+            for(int corner=0; corner<3; corner++)
+            {
+                unsigned int vertex = corners[corner];
+                if(meshletOfVertex[vertex] != meshletIndex)
+                {
+                    meshletOfVertex[vertex] = meshletIndex;
+                    meshlet.vertices.push_back(vertex);
+                    candidates.insert(candidates.end(), vertexFaces.begin() + faceStart[vertex],
+                                      vertexFaces.begin() + faceStart[vertex + 1]);
+                }
+            }
+            meshlet.triangles.push_back(next);
+            faceUsed[next] = 1;
+            for(int i=0; i<3; i++)
+            {
+                centroidSum[i] += centroids[3*next + i];
+                meshlet.centroid[i] = centroidSum[i] / meshlet.triangles.size();
+            }
+            if(meshlet.triangles.size() == maxMeshletTriangles)
+            {
+                break;
+            }
+
+            // the neighbour adding the fewest new vertices that still fit, then the closest one
+            next = unusedTriangle;
+            int bestNewVertices = 4;
+            float bestDistance = 0.0f;
+            size_t kept = 0;
+            for(size_t candidate=0; candidate<candidates.size(); candidate++)
+            {
+                unsigned int face = candidates[candidate];
+                if(faceUsed[face])
+                {
+                    continue;
+                }
+                candidates[kept++] = face;
+
+                const unsigned int* triangle = &indices[3*face];
+                int newVertices = (meshletOfVertex[triangle[0]] != meshletIndex) +
+                                  (meshletOfVertex[triangle[1]] != meshletIndex) +
+                                  (meshletOfVertex[triangle[2]] != meshletIndex);
+                if((meshlet.vertices.size() + newVertices > maxMeshletVertices) || (newVertices > bestNewVertices))
+                {
+                    continue;
+                }
+                float distance = centroidDistanceSquared(meshlet, &centroids[3*face]);
+                if((newVertices < bestNewVertices) || (distance < bestDistance))
+                {
+                    next = face;
+                    bestNewVertices = newVertices;
+                    bestDistance = distance;
+                }
+            }
+            candidates.resize(kept);
+
+            // NOTE: Once nothing next to the meshlet is left (it has used up a small disconnected piece
+            //       of the mesh, like one face of a cube whose faces don't share vertices), the next
+            //       triangle in index order can still go in, if there's room and it lies within the
+            //       meshlet's reach, so that the bounds don't grow to take in some far off part
+            if((next == unusedTriangle) && candidates.empty() && (meshlet.vertices.size() + 3 <= maxMeshletVertices))
+            {
+                while((seedCursor < faceCount) && faceUsed[seedCursor])
+                {
+                    seedCursor++;
+                }
+                if((seedCursor < faceCount) &&
+                   (centroidDistanceSquared(meshlet, &centroids[3*seedCursor]) <= reachSquared(meshlet, positions)))
+                {
+                    next = seedCursor;
+                }
+            }
+        }
+    }
+
+    // Lay the triangles out meshlet by meshlet, and fill in the table
+    size_t meshletCount = meshlets.size();
+    size_t stride = paddedMeshletCount(meshletCount);
+    tableData.assign(meshletTableWords(meshletCount), 0);
+    float* fields = (float*)&tableData[0];
+    for(size_t slot=meshletCount; slot<stride; slot++)
+    {
+        fields[MESHLET_CONE_CUTOFF * stride + slot] = 1.0f;
+    }
+
+    vector<unsigned int> original(indices, indices + faceCount * 3);
+    uint32_t firstIndex = 0;
+    for(size_t meshlet=0; meshlet<meshletCount; meshlet++)
+    {
+        writeMeshletBounds(meshlets[meshlet], &original[0], positions, firstIndex, fields, stride, meshlet);
+        const vector<unsigned int>& triangles = meshlets[meshlet].triangles;
+        for(size_t triangle=0; triangle<triangles.size(); triangle++)
+        {
+            for(int corner=0; corner<3; corner++)
+            {
+                indices[firstIndex + corner] = original[3*triangles[triangle] + corner];
+            }
+            firstIndex += 3;
+        }
+    }
+    return meshletCount;
+}
+
+MeshletStats analyzeMeshlets(const MeshletTable& table)
+{
+    MeshletStats stats = {table.count, 0.0f, 0.0f, 0.0f};
+    if(table.count == 0)
+    {
+        return stats;
+    }
+    double vertices = 0.0, triangles = 0.0;
+    size_t cullable = 0;
+    for(size_t meshlet=0; meshlet<table.count; meshlet++)
+    {
+        vertices += table.vertexCount[meshlet];
+        triangles += table.indexCount[meshlet] / 3;
+        cullable += (table.coneCutoff[meshlet] < 1.0f);
+    }
+    stats.vertexFill = vertices / (table.count * maxMeshletVertices);
+    stats.triangleFill = triangles / (table.count * maxMeshletTriangles);
+    stats.coneCullable = (float)cullable / table.count;
+    return stats;
+}
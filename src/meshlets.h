@@ -0,0 +1,88 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+// NOTE: Meshlets are small clusters of a mesh's triangles, drawn (or culled) as a unit: at most
+//       maxMeshletVertices distinct vertices and maxMeshletTriangles triangles each, which is what
+//       mesh shader hardware likes, and fine grained enough for culling to throw away the parts of a
+//       model facing away or off screen
+const size_t maxMeshletVertices = 64;
+const size_t maxMeshletTriangles = 124;
+
+// NOTE: Meshlet bounds and ranges in struct of arrays form, one array per field, each padded to a
+//       multiple of meshletTableAlignment entries so culling can always test that many at once. The
+//       padding entries have no triangles and a zero radius. All fields are 32 bits, so the whole
+//       table is one block of meshletTableWords(count) words, field after field, which is also how
+//       the mesh cache stores it.
+//
+//       A meshlet's triangles are indexCount indices starting at firstIndex, in the mesh's own index
+//       buffer, which building them reorders. Its normal cone holds every triangle's normal within
+//       the angle whose sine is coneCutoff around coneAxis, and it faces away from a camera wherever
+//       dot(centre - camera, coneAxis) >= coneCutoff * length(centre - camera) + radius. A cutoff of
+//       1 means the triangles face too many ways for that to ever be true
+const size_t meshletTableAlignment = 8;
+
+enum MeshletField
+{
+    MESHLET_CENTRE_X,
+    MESHLET_CENTRE_Y,
+    MESHLET_CENTRE_Z,
+    MESHLET_RADIUS,
+    MESHLET_CONE_AXIS_X,
+    MESHLET_CONE_AXIS_Y,
+    MESHLET_CONE_AXIS_Z,
+    MESHLET_CONE_CUTOFF,
+    MESHLET_FIRST_INDEX,
+    MESHLET_INDEX_COUNT,
+    MESHLET_VERTEX_COUNT,
+    MESHLET_FIELD_COUNT
+};
+
+struct MeshletTable
+{
+    size_t count;
+    size_t paddedCount;
+
+    const float* centreX;
+    const float* centreY;
+    const float* centreZ;
+    const float* radius;
+    const float* coneAxisX;
+    const float* coneAxisY;
+    const float* coneAxisZ;
+    const float* coneCutoff;
+    const uint32_t* firstIndex;
+    const uint32_t* indexCount;
+    const uint32_t* vertexCount;
+};
+
+size_t meshletTableWords(size_t meshletCount);
+
+// Points a MeshletTable at a block of meshletTableWords(meshletCount) words
+MeshletTable meshletTable(const uint32_t* tableData, size_t meshletCount);
+
+// NOTE: Splits the mesh into meshlets, greedily: each one grows from a seed triangle by taking
+//       whichever neighbouring triangle adds the fewest new vertices, and after that lies closest to
+//       the meshlet's centre, until the next would overflow it. Seeds are taken in index order, so a
+//       mesh already in vertex cache order gives meshlets in much the same order. The triangles are
+//       reordered in place, meshlet by meshlet, keeping their winding, and tableData gets the table.
+//       Returns the number of meshlets, which is 0 (with an empty table) for fewer than 3 indices
+size_t buildMeshlets(unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount,
+                     std::vector<uint32_t>& tableData);
+
+// How full the meshlets are on average, as fractions of the vertex and triangle limits, and the
+// fraction of them whose normal cone is narrow enough to ever be culled
+struct MeshletStats
+{
+    size_t meshletCount;
+    float vertexFill;
+    float triangleFill;
+    float coneCullable;
+};
+
+MeshletStats analyzeMeshlets(const MeshletTable& table);
+
+#endif
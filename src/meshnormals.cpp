@@ -0,0 +1,436 @@
+#include <vector>
+#include <algorithm>
+
+#include <math.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MESH_TANGENTS_AVX2
+#endif
+
+using namespace std;
+
+#include "meshnormals.h"
+#include "workerpool.h"
+
+// Below this many faces per thread the extra buffers cost more than the threads save
+static const size_t minimumFacesPerBuffer = 32 * 1024;
+
+// Cap on the memory that goes on extra accumulation buffers, which are a whole copy of the sums
+// each, so very large meshes get fewer of them than there are threads
+static const size_t maximumBufferBytes = 256 * 1024 * 1024;
+
+// NOTE: A face's texture coords are treated as degenerate when the determinant of its UV edges is
+//       this small next to the products it is made of, since the tangent direction that comes out
+//       of it is then mostly rounding error
+static const float uvDeterminantEpsilon = 1e-6f;
+
+// NOTE: Shared by both generators. The faces are split into one range per accumulation buffer
+//       (vertexCount*floatsPerVertex floats each) and accumulate(firstFace, endFace, sums) runs on the
+//       ranges in parallel. Then finish(firstVertex, endVertex, buffers) runs in parallel on ranges
+//       of vertices to combine the buffers. first is used as the first buffer, so with a single
+//       thread there is nothing extra to allocate or combine
+template <typename Accumulate, typename Finish>
+static void accumulateInParallel(size_t faceCount, size_t vertexCount, size_t floatsPerVertex, float* first,
+                                 const Accumulate& accumulate, const Finish& finish)
+{
+    WorkerPool& pool = WorkerPool::shared();
+
+    size_t bufferCount = min<size_t>(pool.threadCount(), max<size_t>(faceCount / minimumFacesPerBuffer, 1));
+    size_t bufferBytes = vertexCount * floatsPerVertex * sizeof(float);
+    if((bufferCount > 1) && (bufferBytes > 0))
+    {
+        bufferCount = min(bufferCount, 1 + maximumBufferBytes / bufferBytes);
+    }
+
+    vector<vector<float> > extraBuffers(bufferCount - 1);
+    vector<float*> buffers(bufferCount);
+    pool.run(bufferCount, [&](int bufferIndex)
+    {
+        float* sums = first;
+        if(bufferIndex > 0)
+        {
+            extraBuffers[bufferIndex - 1].resize(vertexCount * floatsPerVertex);
+            sums = &extraBuffers[bufferIndex - 1][0];
+        }
+        fill(sums, sums + vertexCount * floatsPerVertex, 0.0f);
+        buffers[bufferIndex] = sums;
+        accumulate((faceCount * bufferIndex) / bufferCount, (faceCount * (bufferIndex + 1)) / bufferCount, sums);
+    });
+
+    size_t rangeCount = pool.threadCount() * 4;
+    pool.run(rangeCount, [&](int rangeIndex)
+    {
+        finish((vertexCount * rangeIndex) / rangeCount, (vertexCount * (rangeIndex + 1)) / rangeCount, buffers);
+    });
+}
+
+// Adds every buffer after the first into the first, for floatsPerVertex floats of each vertex in range
+static inline void sumBuffers(const vector<float*>& buffers, size_t floatsPerVertex, size_t firstVertex,
+                              size_t endVertex)
+{
+    float* sums = buffers[0];
+    for(size_t buffer=1; buffer<buffers.size(); buffer++)
+    {
+        const float* extra = buffers[buffer];
+        for(size_t value=firstVertex*floatsPerVertex; value<endVertex*floatsPerVertex; value++)
+        {
+            sums[value] += extra[value];
+        }
+    }
+}
+
+static inline float dot3(const float* a, const float* b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+static inline void cross3(const float* a, const float* b, float* result)
+{
+    result[0] = a[1]*b[2] - a[2]*b[1];
+    result[1] = a[2]*b[0] - a[0]*b[2];
+    result[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+// Scales v to unit length, returns false (leaving it alone) if it has none
+static inline bool normalize3(float* v)
+{
+    float length = sqrtf(dot3(v, v));
+    if(!(length > 0.0f) || !(length < INFINITY))
+    {
+        return false;
+    }
+    float scale = 1.0f / length;
+    v[0] *= scale;
+    v[1] *= scale;
+    v[2] *= scale;
+    return true;
+}
+
+static inline float cornerAngle(const float* corner, const float* next, const float* previous)
+{
+    float toNext[3], toPrevious[3];
+    for(int i=0; i<3; i++)
+    {
+        toNext[i] = next[i] - corner[i];
+        toPrevious[i] = previous[i] - corner[i];
+    }
+    float lengths = sqrtf(dot3(toNext, toNext) * dot3(toPrevious, toPrevious));
+    if(lengths <= 0.0f)
+    {
+        return 0.0f;
+    }
+    return acosf(max(-1.0f, min(1.0f, dot3(toNext, toPrevious) / lengths)));
+}
+
+// The weighting is a template parameter so that area weighting compiles down to the plain scatter
+template <NormalWeighting weighting>
+static void accumulateFaceNormals(const float* positions, const unsigned int* indices, size_t firstFace,
+                                  size_t endFace, float* sums)
+{
+    for(size_t face=firstFace; face<endFace; face++)
+    {
+        const unsigned int* corners = &indices[3*face];
+        const float* position0 = &positions[3*corners[0]];
+        const float* position1 = &positions[3*corners[1]];
+        const float* position2 = &positions[3*corners[2]];
+
+        float edge1[3], edge2[3], normal[3];
+        for(int i=0; i<3; i++)
+        {
+            edge1[i] = position1[i] - position0[i];
+            edge2[i] = position2[i] - position0[i];
+        }
+        cross3(edge1, edge2, normal);
+
+        if(weighting == NORMAL_WEIGHT_ANGLE)
+        {
+            float length = sqrtf(dot3(normal, normal));
+            float scale = (length > 0.0f) ? 1.0f / length : 0.0f;
+            float weights[3] = {scale * cornerAngle(position0, position1, position2),
+                                scale * cornerAngle(position1, position2, position0),
+                                scale * cornerAngle(position2, position0, position1)};
+            for(int corner=0; corner<3; corner++)
+            {
+                float* sum = &sums[3*corners[corner]];
+                sum[0] += weights[corner] * normal[0];
+                sum[1] += weights[corner] * normal[1];
+                sum[2] += weights[corner] * normal[2];
+            }
+        }
+        else
+        {
+            for(int corner=0; corner<3; corner++)
+            {
+                float* sum = &sums[3*corners[corner]];
+                sum[0] += normal[0];
+                sum[1] += normal[1];
+                sum[2] += normal[2];
+            }
+        }
+    }
+}
+
+void computeSmoothNormals(const float* positions, size_t vertexCount, const unsigned int* indices,
+                          size_t indexCount, NormalWeighting weighting, float* normals)
+{
+    accumulateInParallel(indexCount / 3, vertexCount, 3, normals,
+        [&](size_t firstFace, size_t endFace, float* sums)
+        {
+            if(weighting == NORMAL_WEIGHT_ANGLE)
+            {
+                accumulateFaceNormals<NORMAL_WEIGHT_ANGLE>(positions, indices, firstFace, endFace, sums);
+            }
+            else
+            {
+                accumulateFaceNormals<NORMAL_WEIGHT_AREA>(positions, indices, firstFace, endFace, sums);
+            }
+        },
+        [&](size_t firstVertex, size_t endVertex, const vector<float*>& buffers)
+        {
+            sumBuffers(buffers, 3, firstVertex, endVertex);
+            for(size_t vertex=firstVertex; vertex<endVertex; vertex++)
+            {
+                float* normal = &normals[3*vertex];
+                if(!normalize3(normal))
+                {
+                    normal[0] = normal[1] = normal[2] = 0.0f;
+                }
+            }
+        });
+}
+
+// NOTE: The tangent sums hold 6 floats per vertex, the tangent and then the bitangent
+static inline void addFaceTangent(float* sums, const unsigned int* corners, const float* tangent,
+                                  const float* bitangent)
+{
+    for(int corner=0; corner<3; corner++)
+    {
+        float* sum = &sums[6*corners[corner]];
+        sum[0] += tangent[0];
+        sum[1] += tangent[1];
+        sum[2] += tangent[2];
+        sum[3] += bitangent[0];
+        sum[4] += bitangent[1];
+        sum[5] += bitangent[2];
+    }
+}
+
+// Unit tangent and bitangent of one face, false if its texture coords or positions are degenerate
+static inline bool faceTangent(const float* positions, const float* textureCoords, const unsigned int* corners,
+                               float* tangent, float* bitangent)
+{
+    const float* position0 = &positions[3*corners[0]];
+    const float* position1 = &positions[3*corners[1]];
+    const float* position2 = &positions[3*corners[2]];
+    const float* uv0 = &textureCoords[2*corners[0]];
+    const float* uv1 = &textureCoords[2*corners[1]];
+    const float* uv2 = &textureCoords[2*corners[2]];
+
+    float deltaU1 = uv1[0] - uv0[0];
+    float deltaV1 = uv1[1] - uv0[1];
+    float deltaU2 = uv2[0] - uv0[0];
+    float deltaV2 = uv2[1] - uv0[1];
+
+    // Only the sign of the determinant matters once the results are normalized, so nothing here ever
+    // divides by it
+    float determinant = deltaU1*deltaV2 - deltaU2*deltaV1;
+    if(!(fabsf(determinant) > uvDeterminantEpsilon * (fabsf(deltaU1*deltaV2) + fabsf(deltaU2*deltaV1))))
+    {
+        return false;
+    }
+    float sign = (determinant < 0.0f) ? -1.0f : 1.0f;
+
+    for(int i=0; i<3; i++)
+    {
+        float edge1 = position1[i] - position0[i];
+        float edge2 = position2[i] - position0[i];
+        tangent[i] = sign * (deltaV2*edge1 - deltaV1*edge2);
+        bitangent[i] = sign * (deltaU1*edge2 - deltaU2*edge1);
+    }
+    return normalize3(tangent) && normalize3(bitangent);
+}
+
+static void accumulateFaceTangents(const float* positions, const float* textureCoords, const unsigned int* indices,
+                                   size_t firstFace, size_t endFace, float* sums)
+{
+    size_t face = firstFace;
+
+#ifdef MESH_TANGENTS_AVX2
+    // NOTE: Eight faces at a time: their corners, positions and texture coords are gathered into one
+    //       lane each, and the tangents worked out for all eight at once. Degenerate faces are
+    //       masked to zero rather than branched around. Scattering into the sums stays scalar, since
+    //       the eight faces can share vertices
+    const __m256i cornerOffsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 epsilon = _mm256_set1_ps(uvDeterminantEpsilon);
+
+    for(; face + 8 <= endFace; face += 8)
+    {
+        const int* faceCorners = (const int*)&indices[3*face];
+        __m256i corner0 = _mm256_i32gather_epi32(faceCorners, cornerOffsets, 4);
+        __m256i corner1 = _mm256_i32gather_epi32(faceCorners + 1, cornerOffsets, 4);
+        __m256i corner2 = _mm256_i32gather_epi32(faceCorners + 2, cornerOffsets, 4);
+
+        __m256i uvIndex0 = _mm256_add_epi32(corner0, corner0);
+        __m256i uvIndex1 = _mm256_add_epi32(corner1, corner1);
+        __m256i uvIndex2 = _mm256_add_epi32(corner2, corner2);
+        __m256 u0 = _mm256_i32gather_ps(textureCoords, uvIndex0, 4);
+        __m256 v0 = _mm256_i32gather_ps(textureCoords + 1, uvIndex0, 4);
+        __m256 deltaU1 = _mm256_sub_ps(_mm256_i32gather_ps(textureCoords, uvIndex1, 4), u0);
+        __m256 deltaV1 = _mm256_sub_ps(_mm256_i32gather_ps(textureCoords + 1, uvIndex1, 4), v0);
+        __m256 deltaU2 = _mm256_sub_ps(_mm256_i32gather_ps(textureCoords, uvIndex2, 4), u0);
+        __m256 deltaV2 = _mm256_sub_ps(_mm256_i32gather_ps(textureCoords + 1, uvIndex2, 4), v0);
+
+        __m256 product1 = _mm256_mul_ps(deltaU1, deltaV2);
+        __m256 product2 = _mm256_mul_ps(deltaU2, deltaV1);
+        __m256 determinant = _mm256_sub_ps(product1, product2);
+        __m256 magnitude = _mm256_add_ps(_mm256_andnot_ps(signBit, product1), _mm256_andnot_ps(signBit, product2));
+        __m256 valid = _mm256_cmp_ps(_mm256_andnot_ps(signBit, determinant), _mm256_mul_ps(epsilon, magnitude),
+                                     _CMP_GT_OQ);
+        __m256 sign = _mm256_or_ps(one, _mm256_and_ps(signBit, determinant));
+
+        __m256i positionIndex0 = _mm256_mullo_epi32(corner0, three);
+        __m256i positionIndex1 = _mm256_mullo_epi32(corner1, three);
+        __m256i positionIndex2 = _mm256_mullo_epi32(corner2, three);
+        __m256 tangent[3], bitangent[3];
+        for(int i=0; i<3; i++)
+        {
+            __m256 position0 = _mm256_i32gather_ps(positions + i, positionIndex0, 4);
+            __m256 edge1 = _mm256_sub_ps(_mm256_i32gather_ps(positions + i, positionIndex1, 4), position0);
+            __m256 edge2 = _mm256_sub_ps(_mm256_i32gather_ps(positions + i, positionIndex2, 4), position0);
+            tangent[i] = _mm256_sub_ps(_mm256_mul_ps(deltaV2, edge1), _mm256_mul_ps(deltaV1, edge2));
+            bitangent[i] = _mm256_sub_ps(_mm256_mul_ps(deltaU1, edge2), _mm256_mul_ps(deltaU2, edge1));
+        }
+
+        __m256 tangentLength = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(tangent[0], tangent[0]),
+                               _mm256_add_ps(_mm256_mul_ps(tangent[1], tangent[1]), _mm256_mul_ps(tangent[2], tangent[2]))));
+        __m256 bitangentLength = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(bitangent[0], bitangent[0]),
+                                 _mm256_add_ps(_mm256_mul_ps(bitangent[1], bitangent[1]), _mm256_mul_ps(bitangent[2], bitangent[2]))));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(tangentLength, zero, _CMP_GT_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(bitangentLength, zero, _CMP_GT_OQ));
+        int validLanes = _mm256_movemask_ps(valid);
+        if(validLanes == 0)
+        {
+            continue;
+        }
+
+        // The mask is applied after the divide, so the zero or NaN lengths of invalid faces never leak
+        __m256 tangentScale = _mm256_div_ps(sign, tangentLength);
+        __m256 bitangentScale = _mm256_div_ps(sign, bitangentLength);
+        float laneTangents[3][8], laneBitangents[3][8];
+        for(int i=0; i<3; i++)
+        {
+            _mm256_storeu_ps(laneTangents[i], _mm256_and_ps(valid, _mm256_mul_ps(tangent[i], tangentScale)));
+            _mm256_storeu_ps(laneBitangents[i], _mm256_and_ps(valid, _mm256_mul_ps(bitangent[i], bitangentScale)));
+        }
+
+        for(int lane=0; lane<8; lane++)
+        {
+            if(validLanes & (1 << lane))
+            {
+                float faceTangent[3] = {laneTangents[0][lane], laneTangents[1][lane], laneTangents[2][lane]};
+                float faceBitangent[3] = {laneBitangents[0][lane], laneBitangents[1][lane], laneBitangents[2][lane]};
+                addFaceTangent(sums, &indices[3*(face + lane)], faceTangent, faceBitangent);
+            }
+        }
+    }
+#endif
+
+    for(; face<endFace; face++)
+    {
+        float tangent[3], bitangent[3];
+        if(faceTangent(positions, textureCoords, &indices[3*face], tangent, bitangent))
+        {
+            addFaceTangent(sums, &indices[3*face], tangent, bitangent);
+        }
+    }
+}
+
+// Turns the summed tangent and bitangent of a vertex into an orthonormal frame around its normal
+static inline void orthonormalizeFrame(const float* normal, const float* sums, float* tangent, float* bitangent)
+{
+    const float* tangentSum = sums;
+    const float* bitangentSum = sums + 3;
+
+    // A vertex without a usable normal gets the one its tangents imply, or failing that, +z
+    float axis[3] = {normal[0], normal[1], normal[2]};
+    if(!normalize3(axis))
+    {
+        cross3(tangentSum, bitangentSum, axis);
+        if(!normalize3(axis))
+        {
+            axis[0] = 0.0f;
+            axis[1] = 0.0f;
+            axis[2] = 1.0f;
+        }
+    }
+
+    // NOTE: When the summed tangent is nearly parallel to the normal, most of it cancels and what's
+    //       left is mostly rounding error, so the projection is done a second time on the normalized
+    //       result to make it properly perpendicular again
+    float along = dot3(axis, tangentSum);
+    for(int i=0; i<3; i++)
+    {
+        tangent[i] = tangentSum[i] - along*axis[i];
+    }
+    bool usable = normalize3(tangent);
+    if(usable)
+    {
+        along = dot3(axis, tangent);
+        for(int i=0; i<3; i++)
+        {
+            tangent[i] -= along*axis[i];
+        }
+        usable = normalize3(tangent);
+    }
+    if(!usable)
+    {
+        // No usable faces: any direction perpendicular to the normal will do
+        float other[3] = {0.0f, 0.0f, 0.0f};
+        other[(fabsf(axis[0]) < 0.9f) ? 0 : 1] = 1.0f;
+        cross3(axis, other, tangent);
+        normalize3(tangent);
+    }
+
+    cross3(axis, tangent, bitangent);
+    if(dot3(bitangent, bitangentSum) < 0.0f)
+    {
+        bitangent[0] = -bitangent[0];
+        bitangent[1] = -bitangent[1];
+        bitangent[2] = -bitangent[2];
+    }
+}
+
+void computeTangentFrames(const float* positions, const float* textureCoords, const float* normals,
+                          size_t vertexCount, const unsigned int* indices, size_t indexCount,
+                          float* tangents, float* bitangents)
+{
+    vector<float> sums(vertexCount * 6);
+    accumulateInParallel(indexCount / 3, vertexCount, 6, vertexCount ? &sums[0] : 0,
+        [&](size_t firstFace, size_t endFace, float* faceSums)
+        {
+            accumulateFaceTangents(positions, textureCoords, indices, firstFace, endFace, faceSums);
+        },
+        [&](size_t firstVertex, size_t endVertex, const vector<float*>& buffers)
+        {
+            sumBuffers(buffers, 6, firstVertex, endVertex);
+            for(size_t vertex=firstVertex; vertex<endVertex; vertex++)
+            {
+                orthonormalizeFrame(&normals[3*vertex], &buffers[0][6*vertex], &tangents[3*vertex],
+                                    &bitangents[3*vertex]);
+            }
+        });
+}
+
+const char* meshTangentPath()
+{
+#ifdef MESH_TANGENTS_AVX2
+    return "AVX2";
+#else
+    return "scalar";
+#endif
+}
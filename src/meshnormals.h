@@ -0,0 +1,41 @@
+#ifndef MESH_NORMALS_H
+#define MESH_NORMALS_H
+
+#include <stddef.h>
+
+// NOTE: Per-vertex normal and tangent frame generation for indexed triangle meshes. Both generators
+//       split the faces between the worker pool's threads, each of which adds its faces into an
+//       accumulation buffer of its own, so no two threads ever write to the same memory and there is
+//       nothing to lock. The buffers are then combined (and normalized) in parallel by vertex range
+
+// How much each face counts towards the normal of the vertices it uses. Area weighting is just the sum
+// of the faces' cross products, angle weighting scales each face's unit normal by the angle it makes
+// at the vertex, which keeps long thin triangles from dominating but costs an acos per corner
+enum NormalWeighting
+{
+    NORMAL_WEIGHT_AREA,
+    NORMAL_WEIGHT_ANGLE
+};
+
+// Writes a smooth unit normal for each of the vertexCount vertices (3 floats each) into normals.
+// Vertices that no face uses, or whose faces are all degenerate, get a zero normal
+void computeSmoothNormals(const float* positions, size_t vertexCount, const unsigned int* indices,
+                          size_t indexCount, NormalWeighting weighting, float* normals);
+
+// NOTE: Writes an orthonormal tangent frame for each vertex (3 floats each for tangents and
+//       bitangents) that lines up with its texture coords (2 floats each) and its unit normal. Every
+//       face adds its unit tangent and bitangent to its vertices, then each vertex's tangent is made
+//       perpendicular to its normal (Gram-Schmidt) and the bitangent is the cross product of the two,
+//       flipped if the texture is mirrored there. Faces whose texture coords or positions are
+//       degenerate are left out, and a vertex that has no usable faces at all gets an arbitrary
+//       frame around its normal, so the output never holds infinities or NaNs.
+//
+//       The per face work goes eight faces at a time with AVX2 when compiled with -mavx2
+void computeTangentFrames(const float* positions, const float* textureCoords, const float* normals,
+                          size_t vertexCount, const unsigned int* indices, size_t indexCount,
+                          float* tangents, float* bitangents);
+
+// Which per face tangent path was compiled in: "AVX2" or "scalar"
+const char* meshTangentPath();
+
+#endif
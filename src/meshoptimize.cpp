@@ -0,0 +1,600 @@
+#include <vector>
+#include <algorithm>
+
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+
+using namespace std;
+
+#include "meshoptimize.h"
+#include "meshbounds.h"
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount,
+                                    unsigned int cacheSize)
+{
+    VertexCacheStats stats = VertexCacheStats();
+
+    // NOTE: A FIFO only needs to know when each vertex went in: it is still there if fewer than
+    //       cacheSize others have gone in since
+    vector<size_t> insertedAt(vertexCount, 0);
+    size_t clock = cacheSize + 1;
+    for(size_t index=0; index<indexCount; index++)
+    {
+        unsigned int vertex = indices[index];
+        if(clock - insertedAt[vertex] > cacheSize)
+        {
+            insertedAt[vertex] = clock++;
+            stats.transformedVertices++;
+        }
+    }
+
+    size_t faceCount = indexCount / 3;
+    stats.acmr = (faceCount > 0) ? (float)stats.transformedVertices / faceCount : 0.0f;
+    stats.atvr = (vertexCount > 0) ? (float)stats.transformedVertices / vertexCount : 0.0f;
+    return stats;
+}
+
+// NOTE: The scoring follows Forsyth's article. The cache modelled here is bigger than the one
+//       analyzeVertexCache measures against, which is what the scores were tuned for, and works for
+//       the smaller real caches too since it still favours the most recent vertices
+static const int modelledCacheSize = 32;
+static const float cacheDecayPower = 1.5f;
+static const float lastTriangleScore = 0.75f;
+static const float valenceBoostScale = 2.0f;
+static const float valenceBoostPower = 0.5f;
+static const int maxScoredValence = 32;
+
+struct VertexScoreTable
+{
+    float cache[modelledCacheSize];
+    float valence[maxScoredValence + 1];
+
+    VertexScoreTable()
+    {
+        for(int position=0; position<modelledCacheSize; position++)
+        {
+            // the last triangle's vertices get a fixed score, so that its neighbours aren't favoured
+            // just for the order its corners went in
+            if(position < 3)
+            {
+                cache[position] = lastTriangleScore;
+            }
+            else
+            {
+                float scaled = 1.0f - (float)(position - 3) / (modelledCacheSize - 3);
+                cache[position] = powf(scaled, cacheDecayPower);
+            }
+        }
+
+        // fewer triangles left is a bigger boost, to finish off vertices rather than leave them stranded
+        valence[0] = 0.0f;
+        for(int liveCount=1; liveCount<=maxScoredValence; liveCount++)
+        {
+            valence[liveCount] = valenceBoostScale * powf((float)liveCount, -valenceBoostPower);
+        }
+    }
+
+    float score(int cachePosition, unsigned int liveCount) const
+    {
+        if(liveCount == 0)
+        {
+            return -1.0f;
+        }
+        float cacheScore = (cachePosition >= 0) ? cache[cachePosition] : 0.0f;
+        return cacheScore + valence[min<unsigned int>(liveCount, maxScoredValence)];
+    }
+};
+
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount)
+{
+    static const VertexScoreTable scores;
+    size_t faceCount = indexCount / 3;
+    if(faceCount == 0)
+    {
+        return;
+    }
+
+    // NOTE: Each vertex's triangles, as one array of face lists. A vertex's live triangles are kept at
+    //       the front of its list, so taking an emitted one out is a swap with the last live one
+    vector<unsigned int> listStart(vertexCount + 1, 0);
+    for(size_t index=0; index<faceCount*3; index++)
+    {
+        listStart[indices[index] + 1]++;
+    }
+    for(size_t vertex=0; vertex<vertexCount; vertex++)
+    {
+        listStart[vertex + 1] += listStart[vertex];
+    }
+    vector<unsigned int> faceLists(faceCount * 3);
+    vector<unsigned int> liveCounts(vertexCount, 0);
+    for(size_t index=0; index<faceCount*3; index++)
+    {
+        unsigned int vertex = indices[index];
+        faceLists[listStart[vertex] + liveCounts[vertex]++] = index / 3;
+    }
+
+    vector<int> cachePositions(vertexCount, -1);
+    vector<float> vertexScores(vertexCount);
+    for(size_t vertex=0; vertex<vertexCount; vertex++)
+    {
+        vertexScores[vertex] = scores.score(-1, liveCounts[vertex]);
+    }
+    vector<char> emitted(faceCount, 0);
+
+    vector<unsigned int> output(faceCount * 3);
+    unsigned int cache[modelledCacheSize + 3];
+    unsigned int nextCache[modelledCacheSize + 3];
+    int cacheCount = 0;
+
+    // NOTE: Only triangles touching the cache are candidates. When none of them have anything left
+    //       (and for the very first triangle) the search starts over from the first triangle not drawn
+    //       yet, which a cursor tracks so that finding it stays linear over the whole run
+    size_t bestFace = 0;
+    size_t nextUnemitted = 0;
+    for(size_t outputFace=0; outputFace<faceCount; outputFace++)
+    {
+        const unsigned int* corners = &indices[3*bestFace];
+        output[3*outputFace] = corners[0];
+        output[3*outputFace + 1] = corners[1];
+        output[3*outputFace + 2] = corners[2];
+        emitted[bestFace] = 1;
+
+        for(int corner=0; corner<3; corner++)
+        {
+            unsigned int vertex = corners[corner];
+            unsigned int* faces = &faceLists[listStart[vertex]];
+            unsigned int last = --liveCounts[vertex];
+            for(unsigned int position=0; position<=last; position++)
+            {
+                if(faces[position] == bestFace)
+                {
+                    swap(faces[position], faces[last]);
+                    break;
+                }
+            }
+        }
+
+        // The triangle's corners go to the front, then whatever else was in the cache
+        int nextCount = 0;
+        for(int corner=0; corner<3; corner++)
+        {
+            unsigned int vertex = corners[corner];
+            if(find(nextCache, nextCache + nextCount, vertex) == nextCache + nextCount)
+            {
+                nextCache[nextCount++] = vertex;
+            }
+        }
+        int cornerCount = nextCount;
+        for(int position=0; position<cacheCount; position++)
+        {
+            unsigned int vertex = cache[position];
+            if(find(nextCache, nextCache + cornerCount, vertex) == nextCache + cornerCount)
+            {
+                nextCache[nextCount++] = vertex;
+            }
+        }
+
+        // Rescore everything that moved, including the up to three vertices that just fell out
+        for(int position=0; position<nextCount; position++)
+        {
+            unsigned int vertex = nextCache[position];
+            cachePositions[vertex] = (position < modelledCacheSize) ? position : -1;
+            vertexScores[vertex] = scores.score(cachePositions[vertex], liveCounts[vertex]);
+        }
+
+        float bestScore = -1.0f;
+        for(int position=0; position<nextCount; position++)
+        {
+            unsigned int vertex = nextCache[position];
+            const unsigned int* faces = &faceLists[listStart[vertex]];
+            for(unsigned int live=0; live<liveCounts[vertex]; live++)
+            {
+                unsigned int face = faces[live];
+                float score = vertexScores[indices[3*face]] + vertexScores[indices[3*face + 1]] +
+                              vertexScores[indices[3*face + 2]];
+                if(score > bestScore)
+                {
+                    bestScore = score;
+                    bestFace = face;
+                }
+            }
+        }
+
+        cacheCount = min(nextCount, modelledCacheSize);
+        for(int position=0; position<cacheCount; position++)
+        {
+            cache[position] = nextCache[position];
+        }
+
+        if(bestScore < 0.0f)
+        {
+            while((nextUnemitted < faceCount) && emitted[nextUnemitted])
+            {
+                nextUnemitted++;
+            }
+            bestFace = nextUnemitted;
+        }
+    }
+
+    copy(output.begin(), output.end(), indices);
+}
+
+VertexFetchStats analyzeVertexFetch(const unsigned int* indices, size_t indexCount, size_t vertexCount,
+                                    size_t vertexSize)
+{
+    static const size_t cacheLineSize = 64;
+    static const size_t cacheLineCount = 16 * 1024 / cacheLineSize;
+
+    VertexFetchStats stats = VertexFetchStats();
+    vector<size_t> cachedLines(cacheLineCount, ~(size_t)0);
+    vector<char> used(vertexCount, 0);
+    size_t usedCount = 0;
+    for(size_t index=0; index<indexCount; index++)
+    {
+        unsigned int vertex = indices[index];
+        if(!used[vertex])
+        {
+            used[vertex] = 1;
+            usedCount++;
+        }
+
+        // a vertex can straddle lines, every one of them has to be there
+        size_t firstLine = (vertex * vertexSize) / cacheLineSize;
+        size_t lastLine = (vertex * vertexSize + vertexSize - 1) / cacheLineSize;
+        for(size_t line=firstLine; line<=lastLine; line++)
+        {
+            size_t& slot = cachedLines[line % cacheLineCount];
+            if(slot != line)
+            {
+                slot = line;
+                stats.bytesFetched += cacheLineSize;
+            }
+        }
+    }
+
+    size_t usedBytes = usedCount * vertexSize;
+    stats.overfetch = (usedBytes > 0) ? (float)stats.bytesFetched / usedBytes : 0.0f;
+    return stats;
+}
+
+size_t buildVertexFetchRemap(const unsigned int* indices, size_t indexCount, size_t vertexCount,
+                             unsigned int* remap)
+{
+    fill(remap, remap + vertexCount, unusedVertex);
+    unsigned int nextVertex = 0;
+    for(size_t index=0; index<indexCount; index++)
+    {
+        unsigned int vertex = indices[index];
+        if(remap[vertex] == unusedVertex)
+        {
+            remap[vertex] = nextVertex++;
+        }
+    }
+    return nextVertex;
+}
+
+void remapIndices(unsigned int* indices, size_t indexCount, const unsigned int* remap)
+{
+    for(size_t index=0; index<indexCount; index++)
+    {
+        indices[index] = remap[indices[index]];
+    }
+}
+
+void remapVertexStream(float* destination, const float* source, size_t vertexCount, int components,
+                       const unsigned int* remap)
+{
+    for(size_t vertex=0; vertex<vertexCount; vertex++)
+    {
+        if(remap[vertex] != unusedVertex)
+        {
+            memcpy(&destination[remap[vertex] * components], &source[vertex * components], components * sizeof(float));
+        }
+    }
+}
+
+// NOTE: Pixel coordinates are snapped to 1/16 of a pixel so that the edge functions are exact, which
+//       with the top-left rule means a pixel on an edge shared by two triangles is drawn by exactly one
+static const int overdrawViewportSize = 256;
+static const int subpixelBits = 4;
+
+struct RasterVertex
+{
+    int64_t x;
+    int64_t y;
+    float depth;
+};
+
+static inline int64_t edgeFunction(const RasterVertex& a, const RasterVertex& b, int64_t x, int64_t y)
+{
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+static inline bool isTopLeftEdge(const RasterVertex& a, const RasterVertex& b)
+{
+    return ((a.y == b.y) && (b.x < a.x)) || (b.y > a.y);
+}
+
+// Rasterizes one counter-clockwise triangle, counting the fragments that pass the depth test
+static void rasterizeTriangle(RasterVertex v0, RasterVertex v1, RasterVertex v2, float* depthBuffer,
+                              size_t& pixelsShaded)
+{
+    int64_t area = edgeFunction(v0, v1, v2.x, v2.y);
+    if(area <= 0)
+    {
+        return;
+    }
+
+    const int64_t subpixels = 1 << subpixelBits;
+    int64_t maximum = (int64_t)overdrawViewportSize * subpixels - 1;
+    int64_t minX = max<int64_t>(min(min(v0.x, v1.x), v2.x), 0);
+    int64_t minY = max<int64_t>(min(min(v0.y, v1.y), v2.y), 0);
+    int64_t maxX = min<int64_t>(max(max(v0.x, v1.x), v2.x), maximum);
+    int64_t maxY = min<int64_t>(max(max(v0.y, v1.y), v2.y), maximum);
+
+    // biases make the edges that aren't top or left exclusive
+    int64_t bias0 = isTopLeftEdge(v1, v2) ? 0 : -1;
+    int64_t bias1 = isTopLeftEdge(v2, v0) ? 0 : -1;
+    int64_t bias2 = isTopLeftEdge(v0, v1) ? 0 : -1;
+
+    float inverseArea = 1.0f / area;
+    for(int64_t pixelY=(minY >> subpixelBits); pixelY<=(maxY >> subpixelBits); pixelY++)
+    {
+        int64_t sampleY = (pixelY << subpixelBits) + subpixels / 2;
+        for(int64_t pixelX=(minX >> subpixelBits); pixelX<=(maxX >> subpixelBits); pixelX++)
+        {
+            int64_t sampleX = (pixelX << subpixelBits) + subpixels / 2;
+            int64_t weight0 = edgeFunction(v1, v2, sampleX, sampleY);
+            int64_t weight1 = edgeFunction(v2, v0, sampleX, sampleY);
+            int64_t weight2 = edgeFunction(v0, v1, sampleX, sampleY);
+            if((weight0 + bias0 < 0) || (weight1 + bias1 < 0) || (weight2 + bias2 < 0))
+            {
+                continue;
+            }
+
+            float depth = (weight0 * v0.depth + weight1 * v1.depth + weight2 * v2.depth) * inverseArea;
+            float& stored = depthBuffer[pixelY * overdrawViewportSize + pixelX];
+            if(depth < stored)
+            {
+                stored = depth;
+                pixelsShaded++;
+            }
+        }
+    }
+}
+
+OverdrawStats analyzeOverdraw(const unsigned int* indices, size_t indexCount, const float* positions,
+                              size_t vertexCount)
+{
+    OverdrawStats stats = OverdrawStats();
+    if((indexCount == 0) || (vertexCount == 0))
+    {
+        return stats;
+    }
+
+    // Fit the mesh into the viewport the same way on every axis, keeping its proportions
+    MeshBounds bounds = computeMeshBounds(positions, vertexCount);
+    float extent = max(max(bounds.upper[0] - bounds.lower[0], bounds.upper[1] - bounds.lower[1]),
+                       bounds.upper[2] - bounds.lower[2]);
+    float scale = (extent > 0.0f) ? (overdrawViewportSize << subpixelBits) / extent * 0.999f : 0.0f;
+
+    vector<float> depthBuffer(overdrawViewportSize * overdrawViewportSize);
+    vector<RasterVertex> projected(vertexCount);
+    for(int axis=0; axis<3; axis++)
+    {
+        // NOTE: The screen axes are the next two after the view axis, cyclically, which keeps the view
+        //       right handed. Looking down the axis from its positive end the front faces are the counter
+        //       clockwise ones and nearer is larger, from the negative end both are the other way round
+        int screenX = (axis + 1) % 3;
+        int screenY = (axis + 2) % 3;
+        for(int side=0; side<2; side++)
+        {
+            float depthSign = (side == 0) ? -1.0f : 1.0f;
+            for(size_t vertex=0; vertex<vertexCount; vertex++)
+            {
+                const float* position = &positions[3*vertex];
+                projected[vertex].x = (int64_t)((position[screenX] - bounds.lower[screenX]) * scale);
+                projected[vertex].y = (int64_t)((position[screenY] - bounds.lower[screenY]) * scale);
+                projected[vertex].depth = depthSign * position[axis];
+            }
+
+            fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+            for(size_t face=0; face<indexCount/3; face++)
+            {
+                const RasterVertex& v0 = projected[indices[3*face]];
+                const RasterVertex& v1 = projected[indices[3*face + 1]];
+                const RasterVertex& v2 = projected[indices[3*face + 2]];
+                if(side == 0)
+                {
+                    rasterizeTriangle(v0, v1, v2, &depthBuffer[0], stats.pixelsShaded);
+                }
+                else
+                {
+                    rasterizeTriangle(v0, v2, v1, &depthBuffer[0], stats.pixelsShaded);
+                }
+            }
+
+            for(size_t pixel=0; pixel<depthBuffer.size(); pixel++)
+            {
+                if(depthBuffer[pixel] != FLT_MAX)
+                {
+                    stats.pixelsCovered++;
+                }
+            }
+        }
+    }
+
+    stats.overdraw = (stats.pixelsCovered > 0) ? (float)stats.pixelsShaded / stats.pixelsCovered : 0.0f;
+    return stats;
+}
+
+// The FIFO that cluster boundaries are worked out against, same as analyzeVertexCache's default
+static const unsigned int overdrawCacheSize = 16;
+
+struct ClusterCache
+{
+    vector<size_t> insertedAt;
+    size_t clock;
+
+    explicit ClusterCache(size_t vertexCount) : insertedAt(vertexCount, 0), clock(overdrawCacheSize + 1) {}
+
+    void reset()
+    {
+        // everything is at least overdrawCacheSize insertions old
+        clock += overdrawCacheSize + 1;
+    }
+
+    unsigned int transformFace(const unsigned int* corners)
+    {
+        unsigned int misses = 0;
+        for(int corner=0; corner<3; corner++)
+        {
+            if(clock - insertedAt[corners[corner]] > overdrawCacheSize)
+            {
+                insertedAt[corners[corner]] = clock++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+};
+
+struct OverdrawCluster
+{
+    size_t firstFace;
+    size_t endFace;
+    float sortKey;
+};
+
+size_t optimizeOverdraw(unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount,
+                        float threshold)
+{
+    size_t faceCount = indexCount / 3;
+    if(faceCount == 0)
+    {
+        return 0;
+    }
+
+    // NOTE: Hard boundaries: the cache starts over wherever a triangle shares nothing with it, so
+    //       the order can change there without losing anything
+    vector<size_t> hardStarts;
+    ClusterCache cache(vertexCount);
+    for(size_t face=0; face<faceCount; face++)
+    {
+        if((cache.transformFace(&indices[3*face]) == 3) || (face == 0))
+        {
+            hardStarts.push_back(face);
+        }
+    }
+    hardStarts.push_back(faceCount);
+
+    // NOTE: Soft boundaries: every hard cluster's own ACMR, drawn from an empty cache, sets how much
+    //       worse a piece of it can be, and the cluster is cut wherever the piece so far is within that
+    vector<OverdrawCluster> clusters;
+    for(size_t hard=0; hard+1<hardStarts.size(); hard++)
+    {
+        size_t firstFace = hardStarts[hard];
+        size_t endFace = hardStarts[hard + 1];
+        cache.reset();
+        size_t clusterMisses = 0;
+        for(size_t face=firstFace; face<endFace; face++)
+        {
+            clusterMisses += cache.transformFace(&indices[3*face]);
+        }
+        float limit = threshold * clusterMisses / (endFace - firstFace);
+
+        cache.reset();
+        size_t pieceStart = firstFace;
+        size_t pieceMisses = 0;
+        for(size_t face=firstFace; face<endFace; face++)
+        {
+            pieceMisses += cache.transformFace(&indices[3*face]);
+            if(((float)pieceMisses / (face + 1 - pieceStart) <= limit) && (face + 1 < endFace))
+            {
+                OverdrawCluster cluster = {pieceStart, face + 1, 0.0f};
+                clusters.push_back(cluster);
+                pieceStart = face + 1;
+                pieceMisses = 0;
+                cache.reset();
+            }
+        }
+        OverdrawCluster cluster = {pieceStart, endFace, 0.0f};
+        clusters.push_back(cluster);
+    }
+
+    // NOTE: A cluster's occlusion potential is how far its area weighted centroid lies from the
+    //       mesh's, along its average normal: the further out and facing out, the more it can hide
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    double meshArea = 0.0;
+    vector<float> clusterData(clusters.size() * 7, 0.0f);
+    for(size_t clusterIndex=0; clusterIndex<clusters.size(); clusterIndex++)
+    {
+        float* centroid = &clusterData[7*clusterIndex];
+        float* normal = centroid + 3;
+        float& area = centroid[6];
+        for(size_t face=clusters[clusterIndex].firstFace; face<clusters[clusterIndex].endFace; face++)
+        {
+            const float* position0 = &positions[3*indices[3*face]];
+            const float* position1 = &positions[3*indices[3*face + 1]];
+            const float* position2 = &positions[3*indices[3*face + 2]];
+            float edge1[3], edge2[3];
+            for(int i=0; i<3; i++)
+            {
+                edge1[i] = position1[i] - position0[i];
+                edge2[i] = position2[i] - position0[i];
+            }
+            float cross[3] = {edge1[1]*edge2[2] - edge1[2]*edge2[1],
+                              edge1[2]*edge2[0] - edge1[0]*edge2[2],
+                              edge1[0]*edge2[1] - edge1[1]*edge2[0]};
+            float faceArea = sqrtf(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]);
+            for(int i=0; i<3; i++)
+            {
+                centroid[i] += (position0[i] + position1[i] + position2[i]) * (faceArea / 3.0f);
+                normal[i] += cross[i];
+            }
+            area += faceArea;
+        }
+        for(int i=0; i<3; i++)
+        {
+            meshCentroid[i] += centroid[i];
+        }
+        meshArea += area;
+    }
+    for(int i=0; i<3; i++)
+    {
+        meshCentroid[i] = (meshArea > 0.0) ? (float)(meshCentroid[i] / meshArea) : 0.0f;
+    }
+
+    for(size_t clusterIndex=0; clusterIndex<clusters.size(); clusterIndex++)
+    {
+        const float* centroid = &clusterData[7*clusterIndex];
+        const float* normal = centroid + 3;
+        float area = centroid[6];
+        float normalLength = sqrtf(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+        float key = 0.0f;
+        if((area > 0.0f) && (normalLength > 0.0f))
+        {
+            for(int i=0; i<3; i++)
+            {
+                key += (centroid[i] / area - meshCentroid[i]) * (normal[i] / normalLength);
+            }
+        }
+        clusters[clusterIndex].sortKey = key;
+    }
+
+    stable_sort(clusters.begin(), clusters.end(), [](const OverdrawCluster& a, const OverdrawCluster& b)
+    {
+        return a.sortKey > b.sortKey;
+    });
+
+    vector<unsigned int> output;
+    output.reserve(faceCount * 3);
+    for(size_t clusterIndex=0; clusterIndex<clusters.size(); clusterIndex++)
+    {
+        output.insert(output.end(), &indices[3*clusters[clusterIndex].firstFace], &indices[3*clusters[clusterIndex].endFace]);
+    }
+    copy(output.begin(), output.end(), indices);
+    return clusters.size();
+}
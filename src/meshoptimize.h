@@ -0,0 +1,83 @@
+#ifndef MESH_OPTIMIZE_H
+#define MESH_OPTIMIZE_H
+
+#include <stddef.h>
+
+// NOTE: Optional passes run on a mesh once it has been loaded, before it goes into the mesh cache.
+//       Which ones were run is recorded in the cache entry, so asking for a different set rebuilds it
+enum MeshOptimization
+{
+    MESH_OPTIMIZE_VERTEX_CACHE = 1 << 0,
+    MESH_OPTIMIZE_VERTEX_FETCH = 1 << 1,
+    MESH_OPTIMIZE_OVERDRAW = 1 << 2,
+    MESH_OPTIMIZE_LOD_CHAIN = 1 << 3,
+    MESH_OPTIMIZE_MESHLETS = 1 << 4
+};
+
+// How well an index order uses a FIFO post-transform cache of cacheSize vertices: ACMR is the number
+// of vertices transformed per triangle (0.5 is about the best a regular mesh can do, 3 the worst) and
+// ATVR per vertex in the mesh (1 is ideal)
+struct VertexCacheStats
+{
+    size_t transformedVertices;
+    float acmr;
+    float atvr;
+};
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount,
+                                    unsigned int cacheSize=16);
+
+// NOTE: Reorders the triangles in place for the post-transform vertex cache, with Tom Forsyth's
+//       linear-speed greedy algorithm: every vertex is scored by how recently it was used and how many
+//       of its triangles are still to be drawn, and the next triangle is always the best scoring one
+//       among those touching the cache. The triangles themselves, and their winding, are unchanged
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+// NOTE: Estimates overdraw by rasterizing the mesh on the CPU, into a small depth buffer from each of
+//       the six axis directions in turn, with back faces culled and the triangles drawn in index order.
+//       Overdraw is the fragments that pass the depth test (and so would be shaded, with early depth
+//       testing) against the pixels covered at the end, 1 being every pixel shaded once
+struct OverdrawStats
+{
+    size_t pixelsCovered;
+    size_t pixelsShaded;
+    float overdraw;
+};
+
+OverdrawStats analyzeOverdraw(const unsigned int* indices, size_t indexCount, const float* positions,
+                              size_t vertexCount);
+
+// NOTE: Reorders the triangles so the outermost parts of the mesh tend to be drawn first and hide what
+//       is behind them. The index buffer, which should already be in vertex cache order, is split into
+//       clusters wherever the cache starts over, and then wherever a cluster's ACMR on its own comes
+//       within threshold of the whole cluster's, so that drawing the clusters in any order costs at most
+//       that much in cache efficiency. Clusters are then sorted by how far out their centroids are
+//       along their average normal, outermost first. Returns the number of clusters
+size_t optimizeOverdraw(unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount,
+                        float threshold=1.05f);
+
+// NOTE: How well an index order reads a vertex buffer of vertexSize byte vertices, through a 16 KB
+//       direct mapped cache of 64 byte lines standing in for the GPU's vertex fetch. Overfetch is the
+//       bytes read against the size of the vertices actually used, 1 being every byte read once
+struct VertexFetchStats
+{
+    size_t bytesFetched;
+    float overfetch;
+};
+
+VertexFetchStats analyzeVertexFetch(const unsigned int* indices, size_t indexCount, size_t vertexCount,
+                                    size_t vertexSize);
+
+// NOTE: Builds the remap table that puts vertices in the order the indices first use them, so that
+//       fetching them walks the vertex buffer front to back. Vertices no index refers to get
+//       unusedVertex and are dropped. Returns how many vertices are left. Apply it to the indices
+//       with remapIndices and to every vertex array with remapVertexStream, so they all stay in step
+static const unsigned int unusedVertex = ~0u;
+
+size_t buildVertexFetchRemap(const unsigned int* indices, size_t indexCount, size_t vertexCount,
+                             unsigned int* remap);
+void remapIndices(unsigned int* indices, size_t indexCount, const unsigned int* remap);
+void remapVertexStream(float* destination, const float* source, size_t vertexCount, int components,
+                       const unsigned int* remap);
+
+#endif
@@ -0,0 +1,155 @@
+#include <iostream>
+
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "meshregistry.h"
+
+using namespace std;
+
+RegisteredMesh::RegisteredMesh(MeshRegistry* registry)
+    : registry(registry), contentHash(0), vertexArray(0), vertexBuffer(0), indexBuffer(0),
+      format(VertexFormat()), uploaded(false)
+{
+}
+
+RegisteredMesh::~RegisteredMesh()
+{
+    registry->release(this);
+}
+
+MeshRegistry::MeshRegistry(unsigned int optimizations)
+    : optimizations(optimizations)
+{
+}
+
+// What the fast path compares against a resident mesh, without reading the file
+static bool readFileIdentity(const string& filename, string& path, uint64_t& size, int64_t& modifiedTime)
+{
+#ifdef _WIN32
+    char* resolvedPath = _fullpath(NULL, filename.c_str(), 0);
+#else
+    char* resolvedPath = realpath(filename.c_str(), NULL);
+#endif
+    if(!resolvedPath)
+    {
+        return false;
+    }
+    path = resolvedPath;
+    free(resolvedPath);
+
+    struct stat fileInfo;
+    if(stat(path.c_str(), &fileInfo) != 0)
+    {
+        return false;
+    }
+    size = (uint64_t)fileInfo.st_size;
+    modifiedTime = (int64_t)fileInfo.st_mtime;
+    return true;
+}
+
+MeshHandle MeshRegistry::acquire(const string& filename)
+{
+    string path;
+    uint64_t size;
+    int64_t modifiedTime;
+    if(!readFileIdentity(filename, path, size, modifiedTime))
+    {
+        cout << "Unable to open obj file: " << filename << endl;
+        return MeshHandle();
+    }
+
+    {
+        lock_guard<mutex> lock(registryMutex);
+        map<MeshKey, weak_ptr<RegisteredMesh> >::iterator entry = meshes.lower_bound(MeshKey(path, 0));
+        for(; (entry != meshes.end()) && (entry->first.first == path); ++entry)
+        {
+            MeshHandle mesh = entry->second.lock();
+            if(mesh && (mesh->geometry.sourceSize() == size) && (mesh->geometry.sourceModifiedTime() == modifiedTime))
+            {
+                cout << filename << " is already resident" << endl;
+                return mesh;
+            }
+        }
+    }
+
+    // NOTE: Loaded without holding the lock, so the render thread never waits on a parse. If two
+    //       loads of the same file race, the second to finish takes the first's mesh and drops its own
+    MeshHandle mesh(new RegisteredMesh(this));
+    if(!mesh->geometry.load(path, optimizations))
+    {
+        return MeshHandle();
+    }
+    mesh->path = path;
+    mesh->contentHash = mesh->geometry.sourceHash();
+
+    lock_guard<mutex> lock(registryMutex);
+    weak_ptr<RegisteredMesh>& slot = meshes[MeshKey(mesh->path, mesh->contentHash)];
+    MeshHandle resident = slot.lock();
+    if(resident)
+    {
+        return resident;
+    }
+    slot = mesh;
+    return mesh;
+}
+
+size_t MeshRegistry::residentCount()
+{
+    lock_guard<mutex> lock(registryMutex);
+    size_t count = 0;
+    for(map<MeshKey, weak_ptr<RegisteredMesh> >::iterator entry = meshes.begin(); entry != meshes.end(); ++entry)
+    {
+        if(!entry->second.expired())
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+void MeshRegistry::release(RegisteredMesh* mesh)
+{
+    lock_guard<mutex> lock(registryMutex);
+
+    // A mesh that lost a load race was never the registered one, so only an expired entry goes
+    map<MeshKey, weak_ptr<RegisteredMesh> >::iterator entry = meshes.find(MeshKey(mesh->path, mesh->contentHash));
+    if((entry != meshes.end()) && entry->second.expired())
+    {
+        meshes.erase(entry);
+    }
+
+    // NOTE: The last handle can go on the loader thread, which has no GL context, so the objects
+    //       are only queued here and deleted by the render thread in deleteReleasedObjects()
+    if(mesh->vertexArray)
+    {
+        releasedVertexArrays.push_back(mesh->vertexArray);
+    }
+    if(mesh->vertexBuffer)
+    {
+        releasedBuffers.push_back(mesh->vertexBuffer);
+    }
+    if(mesh->indexBuffer)
+    {
+        releasedBuffers.push_back(mesh->indexBuffer);
+    }
+}
+
+void MeshRegistry::deleteReleasedObjects()
+{
+    vector<GLuint> vertexArrays, buffers;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        vertexArrays.swap(releasedVertexArrays);
+        buffers.swap(releasedBuffers);
+    }
+    if(!vertexArrays.empty())
+    {
+        glDeleteVertexArrays(vertexArrays.size(), &vertexArrays[0]);
+    }
+    if(!buffers.empty())
+    {
+        glDeleteBuffers(buffers.size(), &buffers[0]);
+    }
+}
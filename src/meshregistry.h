@@ -0,0 +1,90 @@
+#ifndef MESH_REGISTRY_H
+#define MESH_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <stdint.h>
+
+#include "glheaders.h"
+#include "meshcache.h"
+#include "vertexformat.h"
+
+class MeshRegistry;
+
+// NOTE: One mesh file as the app holds it: the cached arrays, which stay mapped for as long as
+//       anything refers to the mesh, and the GL objects it is drawn from once the render thread has
+//       uploaded it. Everything that draws the mesh shares it through a MeshHandle, and its GL objects
+//       go back to the registry when the last handle goes, on whichever thread that happens
+struct RegisteredMesh
+{
+    explicit RegisteredMesh(MeshRegistry* registry);
+    ~RegisteredMesh();
+
+    MeshRegistry* registry;
+    std::string path;
+    uint64_t contentHash;
+    MeshCache geometry;
+
+    // Render thread only. The vertex array has both buffers and the format applied, so drawing the
+    // mesh is a bind and a glDrawElements
+    GLuint vertexArray;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    VertexFormat format;
+
+    // Set by the render thread once the GL objects are complete, readable from any thread
+    std::atomic<bool> uploaded;
+
+private:
+    RegisteredMesh(const RegisteredMesh&);
+    RegisteredMesh& operator=(const RegisteredMesh&);
+};
+
+typedef std::shared_ptr<RegisteredMesh> MeshHandle;
+
+// NOTE: Every mesh the app has loaded, keyed by the file's canonical path and content hash, so that a
+//       model used twice is only ever loaded and uploaded once. The registry only holds weak
+//       references, meshes stay resident exactly as long as something has a handle on them
+class MeshRegistry
+{
+public:
+    // Every mesh is loaded through the mesh cache with the same optimizations (a MeshOptimization mask)
+    explicit MeshRegistry(unsigned int optimizations=0);
+
+    // NOTE: Thread safe, loads go through here on the loader thread. A file whose canonical path,
+    //       size and modification time match a resident mesh gets that mesh back without being read
+    //       at all. Anything else is loaded through the mesh cache, which hashes the contents, and
+    //       still shares a resident mesh if the contents turn out to be the same. Returns an empty
+    //       handle if the file can't be loaded
+    MeshHandle acquire(const std::string& filename);
+
+    // Number of meshes that still have a handle on them
+    size_t residentCount();
+
+    // Render thread: deletes the GL objects of every mesh whose last handle has gone since the
+    // last call
+    void deleteReleasedObjects();
+
+private:
+    MeshRegistry(const MeshRegistry&);
+    MeshRegistry& operator=(const MeshRegistry&);
+
+    friend struct RegisteredMesh;
+    void release(RegisteredMesh* mesh);
+
+    typedef std::pair<std::string, uint64_t> MeshKey;
+
+    unsigned int optimizations;
+
+    std::mutex registryMutex;
+    std::map<MeshKey, std::weak_ptr<RegisteredMesh> > meshes;
+    std::vector<GLuint> releasedBuffers;
+    std::vector<GLuint> releasedVertexArrays;
+};
+
+#endif
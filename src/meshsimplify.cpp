@@ -0,0 +1,515 @@
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+#include <math.h>
+#include <string.h>
+
+using namespace std;
+
+#include "meshsimplify.h"
+
+// NOTE: Border and seam edges get a plane through them, at right angles to their triangle, weighted
+//       this much more than the surface itself, which is what keeps them from being pulled inwards
+static const double borderWeight = 10.0;
+
+enum VertexKind
+{
+    VERTEX_MANIFOLD,
+    VERTEX_BORDER,
+    VERTEX_SEAM,
+    VERTEX_LOCKED
+};
+
+static const unsigned int noVertex = ~0u;
+static const unsigned int manyVertices = ~0u - 1;
+
+// Sum of squared distances to a set of weighted planes, as the symmetric matrix A, vector b and
+// constant c of p'Ap + 2b'p + c
+struct Quadric
+{
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double weight;
+
+    void addPlane(const double* normal, double distance, double planeWeight)
+    {
+        a00 += planeWeight * normal[0] * normal[0];
+        a01 += planeWeight * normal[0] * normal[1];
+        a02 += planeWeight * normal[0] * normal[2];
+        a11 += planeWeight * normal[1] * normal[1];
+        a12 += planeWeight * normal[1] * normal[2];
+        a22 += planeWeight * normal[2] * normal[2];
+        b0 += planeWeight * normal[0] * distance;
+        b1 += planeWeight * normal[1] * distance;
+        b2 += planeWeight * normal[2] * distance;
+        c += planeWeight * distance * distance;
+        weight += planeWeight;
+    }
+
+    void add(const Quadric& other)
+    {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02;
+        a11 += other.a11; a12 += other.a12; a22 += other.a22;
+        b0 += other.b0; b1 += other.b1; b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+    }
+
+    // Weighted mean squared distance of p from the planes
+    double error(const float* p) const
+    {
+        double x = p[0], y = p[1], z = p[2];
+        double result = a00*x*x + a11*y*y + a22*z*z + 2.0*(a01*x*y + a02*x*z + a12*y*z) +
+                        2.0*(b0*x + b1*y + b2*z) + c;
+        return (weight > 0.0) ? fabs(result) / weight : 0.0;
+    }
+};
+
+// Vertices with identical positions, found by hashing the position bits: the first one becomes the
+// position's representative, and all of them are linked in a ring through wedges
+static void findWedges(const float* positions, size_t vertexCount, vector<unsigned int>& remap,
+                       vector<unsigned int>& wedges)
+{
+    struct PositionHash
+    {
+        const float* positions;
+        size_t operator()(unsigned int vertex) const
+        {
+            uint32_t bits[3];
+            memcpy(bits, &positions[3*vertex], sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+    };
+    struct PositionEqual
+    {
+        const float* positions;
+        bool operator()(unsigned int a, unsigned int b) const
+        {
+            return memcmp(&positions[3*a], &positions[3*b], 3 * sizeof(float)) == 0;
+        }
+    };
+
+    PositionHash hash = {positions};
+    PositionEqual equal = {positions};
+    unordered_map<unsigned int, unsigned int, PositionHash, PositionEqual> firstAtPosition(vertexCount, hash, equal);
+    remap.resize(vertexCount);
+    wedges.resize(vertexCount);
+    for(size_t vertex=0; vertex<vertexCount; vertex++)
+    {
+        unsigned int first = firstAtPosition.insert(make_pair((unsigned int)vertex, (unsigned int)vertex)).first->second;
+        remap[vertex] = first;
+        if(first == vertex)
+        {
+            wedges[vertex] = vertex;
+        }
+        else
+        {
+            wedges[vertex] = wedges[first];
+            wedges[first] = vertex;
+        }
+    }
+}
+
+// NOTE: The per pass view of the current triangles: each vertex's triangles, and each vertex's open
+//       edges, the ones with no triangle running the other way along them between the same two vertices
+struct MeshAdjacency
+{
+    vector<unsigned int> faceStart;
+    vector<unsigned int> faces;
+    vector<unsigned int> openNext;
+    vector<unsigned int> openPrevious;
+
+    void build(const vector<unsigned int>& indices, size_t vertexCount)
+    {
+        size_t faceCount = indices.size() / 3;
+        faceStart.assign(vertexCount + 1, 0);
+        for(size_t index=0; index<indices.size(); index++)
+        {
+            faceStart[indices[index] + 1]++;
+        }
+        for(size_t vertex=0; vertex<vertexCount; vertex++)
+        {
+            faceStart[vertex + 1] += faceStart[vertex];
+        }
+        faces.resize(indices.size());
+        vector<unsigned int> filled(faceStart.begin(), faceStart.end() - 1);
+        for(size_t index=0; index<indices.size(); index++)
+        {
+            faces[filled[indices[index]]++] = index / 3;
+        }
+
+        openNext.assign(vertexCount, noVertex);
+        openPrevious.assign(vertexCount, noVertex);
+        for(size_t face=0; face<faceCount; face++)
+        {
+            for(int corner=0; corner<3; corner++)
+            {
+                unsigned int from = indices[3*face + corner];
+                unsigned int to = indices[3*face + (corner + 1) % 3];
+                if(!hasEdge(indices, to, from))
+                {
+                    openNext[from] = (openNext[from] == noVertex) ? to : manyVertices;
+                    openPrevious[to] = (openPrevious[to] == noVertex) ? from : manyVertices;
+                }
+            }
+        }
+    }
+
+    bool hasEdge(const vector<unsigned int>& indices, unsigned int from, unsigned int to) const
+    {
+        for(unsigned int entry=faceStart[from]; entry<faceStart[from + 1]; entry++)
+        {
+            const unsigned int* corners = &indices[3*faces[entry]];
+            for(int corner=0; corner<3; corner++)
+            {
+                if((corners[corner] == from) && (corners[(corner + 1) % 3] == to))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+static bool singleVertex(unsigned int vertex)
+{
+    return (vertex != noVertex) && (vertex != manyVertices);
+}
+
+static void classifyVertices(const MeshAdjacency& adjacency, const vector<unsigned int>& remap,
+                             const vector<unsigned int>& wedges, vector<unsigned char>& kinds)
+{
+    size_t vertexCount = remap.size();
+    kinds.resize(vertexCount);
+    for(size_t vertex=0; vertex<vertexCount; vertex++)
+    {
+        unsigned int next = adjacency.openNext[vertex];
+        unsigned int previous = adjacency.openPrevious[vertex];
+        unsigned int twin = wedges[vertex];
+        bool alone = (twin == vertex);
+        bool pair = !alone && (wedges[twin] == vertex);
+
+        if((next == noVertex) && (previous == noVertex))
+        {
+            kinds[vertex] = alone ? VERTEX_MANIFOLD : VERTEX_LOCKED;
+        }
+        else if(singleVertex(next) && singleVertex(previous) && alone)
+        {
+            kinds[vertex] = VERTEX_BORDER;
+        }
+        else if(singleVertex(next) && singleVertex(previous) && pair &&
+                singleVertex(adjacency.openNext[twin]) && singleVertex(adjacency.openPrevious[twin]) &&
+                (remap[next] == remap[adjacency.openPrevious[twin]]) &&
+                (remap[previous] == remap[adjacency.openNext[twin]]))
+        {
+            // the two sides of the seam run along the same positions in opposite directions
+            kinds[vertex] = VERTEX_SEAM;
+        }
+        else
+        {
+            kinds[vertex] = VERTEX_LOCKED;
+        }
+    }
+}
+
+static void faceNormal(const float* p0, const float* p1, const float* p2, double* normal)
+{
+    double edge1[3] = {(double)p1[0] - p0[0], (double)p1[1] - p0[1], (double)p1[2] - p0[2]};
+    double edge2[3] = {(double)p2[0] - p0[0], (double)p2[1] - p0[1], (double)p2[2] - p0[2]};
+    normal[0] = edge1[1]*edge2[2] - edge1[2]*edge2[1];
+    normal[1] = edge1[2]*edge2[0] - edge1[0]*edge2[2];
+    normal[2] = edge1[0]*edge2[1] - edge1[1]*edge2[0];
+}
+
+// True if moving vertex onto target's position turns any of its other triangles over
+static bool collapseFlipsTriangles(const vector<unsigned int>& indices, const MeshAdjacency& adjacency,
+                                   const float* positions, unsigned int vertex, unsigned int target)
+{
+    const float* targetPosition = &positions[3*target];
+    for(unsigned int entry=adjacency.faceStart[vertex]; entry<adjacency.faceStart[vertex + 1]; entry++)
+    {
+        const unsigned int* corners = &indices[3*adjacency.faces[entry]];
+        if((corners[0] == target) || (corners[1] == target) || (corners[2] == target))
+        {
+            continue;
+        }
+
+        const float* before[3];
+        const float* after[3];
+        for(int corner=0; corner<3; corner++)
+        {
+            before[corner] = &positions[3*corners[corner]];
+            after[corner] = (corners[corner] == vertex) ? targetPosition : before[corner];
+        }
+        double normalBefore[3], normalAfter[3];
+        faceNormal(before[0], before[1], before[2], normalBefore);
+        faceNormal(after[0], after[1], after[2], normalAfter);
+        if(normalBefore[0]*normalAfter[0] + normalBefore[1]*normalAfter[1] + normalBefore[2]*normalAfter[2] <= 0.0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct EdgeCollapse
+{
+    unsigned int vertex;
+    unsigned int target;
+    double error;
+};
+
+static bool cheaperCollapse(const EdgeCollapse& a, const EdgeCollapse& b)
+{
+    return a.error < b.error;
+}
+
+void simplifyMeshLODs(const unsigned int* sourceIndices, size_t indexCount, const float* positions, size_t vertexCount,
+                      const float* targetRatios, int levelCount, vector<unsigned int>& lodIndices,
+                      MeshLOD* levels, double* levelSeconds)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    lodIndices.clear();
+    vector<unsigned int> indices(sourceIndices, sourceIndices + indexCount - indexCount % 3);
+    size_t fullFaceCount = indices.size() / 3;
+
+    vector<unsigned int> remap, wedges;
+    findWedges(positions, vertexCount, remap, wedges);
+
+    // NOTE: Quadrics belong to positions rather than vertices, so both sides of a seam share one. Each
+    //       triangle adds its plane weighted by its area, to all three corners
+    vector<Quadric> quadrics(vertexCount, Quadric());
+    MeshAdjacency adjacency;
+    adjacency.build(indices, vertexCount);
+    for(size_t face=0; face<fullFaceCount; face++)
+    {
+        const unsigned int* corners = &indices[3*face];
+        double normal[3];
+        faceNormal(&positions[3*corners[0]], &positions[3*corners[1]], &positions[3*corners[2]], normal);
+        double length = sqrt(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+        if(length <= 0.0)
+        {
+            continue;
+        }
+        for(int i=0; i<3; i++)
+        {
+            normal[i] /= length;
+        }
+        const float* p0 = &positions[3*corners[0]];
+        double distance = -(normal[0]*p0[0] + normal[1]*p0[1] + normal[2]*p0[2]);
+        for(int corner=0; corner<3; corner++)
+        {
+            quadrics[remap[corners[corner]]].addPlane(normal, distance, length * 0.5);
+        }
+
+        for(int corner=0; corner<3; corner++)
+        {
+            unsigned int from = corners[corner];
+            unsigned int to = corners[(corner + 1) % 3];
+            if(adjacency.openNext[from] == noVertex || adjacency.hasEdge(indices, to, from))
+            {
+                continue;
+            }
+            const float* a = &positions[3*from];
+            const float* b = &positions[3*to];
+            double edge[3] = {(double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2]};
+            double edgeLengthSquared = edge[0]*edge[0] + edge[1]*edge[1] + edge[2]*edge[2];
+            double side[3] = {edge[1]*normal[2] - edge[2]*normal[1],
+                              edge[2]*normal[0] - edge[0]*normal[2],
+                              edge[0]*normal[1] - edge[1]*normal[0]};
+            double sideLength = sqrt(side[0]*side[0] + side[1]*side[1] + side[2]*side[2]);
+            if(sideLength <= 0.0)
+            {
+                continue;
+            }
+            for(int i=0; i<3; i++)
+            {
+                side[i] /= sideLength;
+            }
+            double sideDistance = -(side[0]*a[0] + side[1]*a[1] + side[2]*a[2]);
+            quadrics[remap[from]].addPlane(side, sideDistance, edgeLengthSquared * borderWeight);
+            quadrics[remap[to]].addPlane(side, sideDistance, edgeLengthSquared * borderWeight);
+        }
+    }
+
+    vector<unsigned char> kinds;
+    vector<unsigned int> collapseTo(vertexCount);
+    vector<char> positionLocked(vertexCount);
+    vector<EdgeCollapse> collapses;
+    vector<unsigned int> collapsedIndices;
+    double worstError = 0.0;
+    for(int level=0; level<levelCount; level++)
+    {
+        size_t targetFaceCount = (size_t)(fullFaceCount * targetRatios[level]);
+        while(indices.size() / 3 > targetFaceCount)
+        {
+            adjacency.build(indices, vertexCount);
+            classifyVertices(adjacency, remap, wedges, kinds);
+
+            // NOTE: Every edge both ways round, wherever the vertex being moved is allowed to go that way.
+            //       An edge between two triangles is taken from just one of them
+            collapses.clear();
+            for(size_t face=0; face<indices.size()/3; face++)
+            {
+                for(int corner=0; corner<3; corner++)
+                {
+                    unsigned int endpoints[2] = {indices[3*face + corner], indices[3*face + (corner + 1) % 3]};
+                    if((endpoints[0] > endpoints[1]) && adjacency.hasEdge(indices, endpoints[1], endpoints[0]))
+                    {
+                        continue;
+                    }
+                    for(int direction=0; direction<2; direction++)
+                    {
+                        unsigned int vertex = endpoints[direction];
+                        unsigned int target = endpoints[1 - direction];
+                        unsigned char kind = kinds[vertex];
+                        if((kind == VERTEX_LOCKED) ||
+                           ((kind != VERTEX_MANIFOLD) && (target != adjacency.openNext[vertex]) &&
+                            (target != adjacency.openPrevious[vertex])))
+                        {
+                            continue;
+                        }
+                        EdgeCollapse collapse = {vertex, target, quadrics[remap[vertex]].error(&positions[3*target])};
+                        collapses.push_back(collapse);
+                    }
+                }
+            }
+
+            // NOTE: Collapses in one pass mustn't touch each other's triangles, since their costs and
+            //       the flip checks assume everything else stays put, so a collapse locks every position
+            //       around the vertex it moves. Each collapse takes out about two triangles. So many get
+            //       locked out that going down the list until the goal is met would reach far costlier
+            //       collapses than the goal-th cheapest, so a pass stops at one and a half times its cost,
+            //       and only the collapses under that limit need sorting
+            size_t faceCount = indices.size() / 3;
+            size_t collapseGoal = max<size_t>((faceCount - targetFaceCount) / 2, 1);
+            vector<EdgeCollapse>::iterator sortedEnd = collapses.end();
+            if(collapseGoal < collapses.size())
+            {
+                nth_element(collapses.begin(), collapses.begin() + collapseGoal, collapses.end(), cheaperCollapse);
+                double errorLimit = 1.5 * collapses[collapseGoal].error;
+                sortedEnd = partition(collapses.begin(), collapses.end(), [errorLimit](const EdgeCollapse& collapse)
+                {
+                    return collapse.error <= errorLimit;
+                });
+            }
+            sort(collapses.begin(), sortedEnd, cheaperCollapse);
+            collapses.erase(sortedEnd, collapses.end());
+
+            size_t collapsed = 0;
+            double passError = worstError;
+            fill(positionLocked.begin(), positionLocked.end(), 0);
+            for(size_t vertex=0; vertex<vertexCount; vertex++)
+            {
+                collapseTo[vertex] = vertex;
+            }
+            for(size_t candidate=0; (candidate<collapses.size()) && (collapsed<collapseGoal); candidate++)
+            {
+                const EdgeCollapse& collapse = collapses[candidate];
+                unsigned int vertex = collapse.vertex;
+                unsigned int target = collapse.target;
+                if(positionLocked[remap[vertex]] || positionLocked[remap[target]])
+                {
+                    continue;
+                }
+
+                // the other side of a seam goes the matching way along it
+                unsigned int twin = noVertex;
+                unsigned int twinTarget = noVertex;
+                if(kinds[vertex] == VERTEX_SEAM)
+                {
+                    twin = wedges[vertex];
+                    twinTarget = (target == adjacency.openNext[vertex]) ? adjacency.openPrevious[twin] : adjacency.openNext[twin];
+                }
+
+                if(collapseFlipsTriangles(indices, adjacency, positions, vertex, target) ||
+                   ((twin != noVertex) && collapseFlipsTriangles(indices, adjacency, positions, twin, twinTarget)))
+                {
+                    continue;
+                }
+
+                unsigned int moved[2] = {vertex, twin};
+                for(int side=0; side<2; side++)
+                {
+                    if(moved[side] == noVertex)
+                    {
+                        continue;
+                    }
+                    for(unsigned int entry=adjacency.faceStart[moved[side]]; entry<adjacency.faceStart[moved[side] + 1]; entry++)
+                    {
+                        const unsigned int* corners = &indices[3*adjacency.faces[entry]];
+                        for(int corner=0; corner<3; corner++)
+                        {
+                            positionLocked[remap[corners[corner]]] = 1;
+                        }
+                    }
+                }
+                positionLocked[remap[target]] = 1;
+
+                collapseTo[vertex] = target;
+                if(twin != noVertex)
+                {
+                    collapseTo[twin] = twinTarget;
+                }
+                quadrics[remap[target]].add(quadrics[remap[vertex]]);
+                passError = max(passError, collapse.error);
+                collapsed++;
+            }
+
+            if(collapsed == 0)
+            {
+                break;
+            }
+
+            // NOTE: Move the collapsed vertices and drop the triangles that have lost their area. A pass
+            //       that would leave nothing at all (a closed sheet of two triangles, say) is thrown away
+            collapsedIndices.clear();
+            for(size_t face=0; face<faceCount; face++)
+            {
+                unsigned int a = collapseTo[indices[3*face]];
+                unsigned int b = collapseTo[indices[3*face + 1]];
+                unsigned int c = collapseTo[indices[3*face + 2]];
+                if((remap[a] != remap[b]) && (remap[b] != remap[c]) && (remap[a] != remap[c]))
+                {
+                    collapsedIndices.push_back(a);
+                    collapsedIndices.push_back(b);
+                    collapsedIndices.push_back(c);
+                }
+            }
+            if(collapsedIndices.empty())
+            {
+                break;
+            }
+            indices.swap(collapsedIndices);
+            worstError = passError;
+        }
+
+        levels[level].firstIndex = lodIndices.size();
+        levels[level].indexCount = indices.size();
+        levels[level].error = (float)sqrt(worstError);
+        lodIndices.insert(lodIndices.end(), indices.begin(), indices.end());
+        if(levelSeconds)
+        {
+            levelSeconds[level] = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+    }
+}
+
+int selectLODLevel(const MeshLOD* levels, int levelCount, float pixelsPerUnit, float pixelThreshold,
+                   float hysteresis, int currentLevel)
+{
+    int level = min(max(currentLevel, 0), levelCount);
+    while((level > 0) && (levels[level - 1].error * pixelsPerUnit > pixelThreshold * hysteresis))
+    {
+        level--;
+    }
+    while((level < levelCount) && (levels[level].error * pixelsPerUnit <= pixelThreshold / hysteresis))
+    {
+        level++;
+    }
+    return level;
+}
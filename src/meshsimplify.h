@@ -0,0 +1,48 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+// Most levels a LOD chain can have, not counting the full mesh
+const int maxLODLevels = 8;
+
+// The chain MESH_OPTIMIZE_LOD_CHAIN builds unless asked for another: each level half the last
+const int defaultLODLevelCount = 4;
+const float defaultLODRatios[defaultLODLevelCount] = {0.5f, 0.25f, 0.125f, 0.0625f};
+
+// NOTE: One level of a LOD chain: a range of the chain's index buffer, which indexes the same vertex
+//       arrays as the full mesh, and the geometric error of the level, roughly how far (in model units)
+//       its surface strays from the full mesh's
+struct MeshLOD
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+};
+
+// NOTE: Simplifies a mesh with quadric error metrics, by collapsing vertices onto their neighbours one
+//       edge at a time, cheapest first, so every level only uses vertices the full mesh already has.
+//       Vertices on open borders only move along the border, and vertices that sit on a UV or normal
+//       seam (two vertices at the same position with different attributes) only move along the seam,
+//       together with their twin on the other side, so neither ever opens up. Anything more tangled
+//       than that stays where it is.
+//
+//       One run produces the whole chain: targetRatios (decreasing) are fractions of the triangle
+//       count, and each level is recorded as the run goes past its target, into lodIndices. A level
+//       can end up bigger than asked for, if there is nothing left that can be collapsed
+void simplifyMeshLODs(const unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount,
+                      const float* targetRatios, int levelCount, std::vector<unsigned int>& lodIndices,
+                      MeshLOD* levels, double* levelSeconds=0);
+
+// NOTE: Picks the level to draw, 0 being the full mesh and n being levels[n-1], from how many pixels
+//       one model unit covers on screen where the mesh comes closest to the camera: the coarsest level
+//       whose error comes out under pixelThreshold. Starting from currentLevel, it only goes coarser
+//       once that level's error is under pixelThreshold / hysteresis, and only goes finer once the
+//       current level's is over pixelThreshold * hysteresis, so a model sitting right at a switching
+//       distance doesn't flicker between two levels
+int selectLODLevel(const MeshLOD* levels, int levelCount, float pixelsPerUnit, float pixelThreshold,
+                   float hysteresis, int currentLevel);
+
+#endif
@@ -0,0 +1,81 @@
+#include "modelloader.h"
+
+#include <utility>
+
+using namespace std;
+
+ModelLoader::ModelLoader()
+    : running(false), stopping(false)
+{
+    loaderThread = thread(&ModelLoader::loaderLoop, this);
+}
+
+ModelLoader::~ModelLoader()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+        pendingTasks.clear();
+    }
+    wakeCondition.notify_all();
+
+    // NOTE: A load that is already running can't be interrupted, so this waits for it to finish
+    loaderThread.join();
+}
+
+void ModelLoader::queue(const LoadTask& task)
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        pendingTasks.push_back(task);
+    }
+    wakeCondition.notify_all();
+}
+
+bool ModelLoader::takeFinished(LoadedModel& model)
+{
+    lock_guard<mutex> lock(queueMutex);
+    if(finishedModels.empty())
+    {
+        return false;
+    }
+
+    // moved rather than copied, the vertex data can be hundreds of megabytes
+    model = std::move(finishedModels.front());
+    finishedModels.pop_front();
+    return true;
+}
+
+bool ModelLoader::busy()
+{
+    lock_guard<mutex> lock(queueMutex);
+    return running || !pendingTasks.empty() || !finishedModels.empty();
+}
+
+void ModelLoader::loaderLoop()
+{
+    for(;;)
+    {
+        LoadTask task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            wakeCondition.wait(lock, [this]{ return stopping || !pendingTasks.empty(); });
+            if(stopping)
+            {
+                return;
+            }
+            task = pendingTasks.front();
+            pendingTasks.pop_front();
+            running = true;
+        }
+
+        LoadedModel model;
+        model.loaded = false;
+        model.vertexCount = 0;
+        task(model);
+
+        lock_guard<mutex> lock(queueMutex);
+        finishedModels.push_back(std::move(model));
+        running = false;
+    }
+}
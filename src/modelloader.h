@@ -0,0 +1,68 @@
+#ifndef MODEL_LOADER_H
+#define MODEL_LOADER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+
+#include "vertexformat.h"
+
+struct RegisteredMesh;
+
+// NOTE: A model that has been loaded on the loader thread. If its mesh isn't on the GPU yet, the
+//       vertices have been packed too, ready to be copied into a GL buffer as they are (the indices
+//       are uploaded straight from the mesh's cached arrays)
+struct LoadedModel
+{
+    std::string name;
+    bool loaded;
+    std::shared_ptr<RegisteredMesh> mesh;
+
+    VertexFormat format;
+    size_t vertexCount;
+    std::vector<char> vertices;
+};
+
+// NOTE: Runs model loads on a thread of its own so that the render loop never waits on a parse.
+//       Each load task fills in a LoadedModel, which goes on a finished queue for the render thread
+//       to pick up with takeFinished() whenever it is ready to upload it. Tasks run one at a time in
+//       the order they were queued, and can use the shared WorkerPool as usual, since the render
+//       thread doesn't. Nothing here touches GL, which stays on the render thread
+class ModelLoader
+{
+public:
+    typedef std::function<void(LoadedModel&)> LoadTask;
+
+    ModelLoader();
+    ~ModelLoader();
+
+    void queue(const LoadTask& task);
+
+    // Moves the oldest finished model into model, false if none are waiting
+    bool takeFinished(LoadedModel& model);
+
+    // True while a task is queued, running or waiting to be taken
+    bool busy();
+
+private:
+    ModelLoader(const ModelLoader&);
+    ModelLoader& operator=(const ModelLoader&);
+
+    void loaderLoop();
+
+    std::thread loaderThread;
+    std::mutex queueMutex;
+    std::condition_variable wakeCondition;
+
+    std::deque<LoadTask> pendingTasks;
+    std::deque<LoadedModel> finishedModels;
+    bool running;
+    bool stopping;
+};
+
+#endif
@@ -0,0 +1,454 @@
+#include <string>
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OBJ_NUMBER_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define OBJ_NUMBER_SSE2
+#endif
+#if defined(OBJ_NUMBER_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+#include "objnumber.h"
+
+// NOTE: Powers of ten up to 1e22 are exactly representable as doubles, so a mantissa that fits in
+//       53 bits scaled by one of these (a single multiply or divide) is the correctly rounded double
+static const double powersOfTen[] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t integerPowersOfTen[] =
+{
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+    1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+    100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+    1000000000000000000ull, 10000000000000000000ull
+};
+
+// Largest number of decimal digits that always fits in a uint64_t
+static const int maxExactDigits = 19;
+
+static inline bool isDigit(char c)
+{
+    return (unsigned char)(c - '0') < 10;
+}
+
+static inline bool isTokenEnd(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '\0');
+}
+
+// NOTE: strtol/strtof need a null-terminated string, so the token gets copied out first. Any
+//       realistic number fits in the caller's stack buffer, and only a longer token is copied to the
+//       heap (into overflow). Returns the null-terminated copy
+static const char* copyToken(const char* cursor, const char* end, char* buffer, size_t bufferSize,
+                             string* overflow)
+{
+    const char* tokenEnd = cursor;
+    while((tokenEnd < end) && !isTokenEnd(*tokenEnd))
+    {
+        tokenEnd++;
+    }
+    size_t tokenSize = tokenEnd - cursor;
+    if(tokenSize >= bufferSize)
+    {
+        overflow->assign(cursor, tokenEnd);
+        return overflow->c_str();
+    }
+    memcpy(buffer, cursor, tokenSize);
+    buffer[tokenSize] = '\0';
+    return buffer;
+}
+
+static const size_t tokenBufferSize = 64;
+
+const char* parseOBJIntReference(const char* cursor, const char* end, int* result)
+{
+    // strtol would happily skip leading whitespace, the scanners don't
+    if((cursor >= end) || isTokenEnd(*cursor))
+    {
+        return cursor;
+    }
+
+    char buffer[tokenBufferSize];
+    string overflow;
+    const char* token = copyToken(cursor, end, buffer, sizeof(buffer), &overflow);
+    char* tokenEnd = 0;
+    long value = strtol(token, &tokenEnd, 10);
+    if(tokenEnd == token)
+    {
+        return cursor;
+    }
+
+    *result = (value > INT_MAX) ? INT_MAX : ((value < INT_MIN) ? INT_MIN : (int)value);
+    return cursor + (tokenEnd - token);
+}
+
+const char* parseOBJFloatReference(const char* cursor, const char* end, float* result)
+{
+    if((cursor >= end) || isTokenEnd(*cursor))
+    {
+        return cursor;
+    }
+
+    char buffer[tokenBufferSize];
+    string overflow;
+    const char* token = copyToken(cursor, end, buffer, sizeof(buffer), &overflow);
+    char* tokenEnd = 0;
+    float value = strtof(token, &tokenEnd);
+    if(tokenEnd == token)
+    {
+        return cursor;
+    }
+
+    *result = value;
+    return cursor + (tokenEnd - token);
+}
+
+// NOTE: Turns mantissa * 10^exponent into a float, returning false when that can't be done exactly
+//       with one double operation. Up to 2^53 the mantissa converts exactly, so the double we get is
+//       correctly rounded, and rounding it again to float gives the same answer as rounding the
+//       decimal directly unless the double lands exactly halfway between two floats (the low 29 bits
+//       of its mantissa are 1 followed by zeros). A longer mantissa is rounded once more on the way
+//       in, which can leave the double up to 2 units in its last place off, so then anything that
+//       close to halfway is refused. So is a result outside the range of normal floats, where float
+//       precision drops off
+static inline bool decimalToFloat(uint64_t mantissa, int exponent, bool negative, float* result)
+{
+    if(mantissa == 0)
+    {
+        *result = negative ? -0.0f : 0.0f;
+        return true;
+    }
+    if((exponent < -22) || (exponent > 22))
+    {
+        return false;
+    }
+
+    double value = (double)mantissa;
+    value = (exponent < 0) ? (value / powersOfTen[-exponent]) : (value * powersOfTen[exponent]);
+    if((value < 1.1754943508222875e-38) || (value > 3.4028234663852886e+38))
+    {
+        return false;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int64_t halfwayDistance = (int64_t)(bits & 0x1FFFFFFFull) - 0x10000000ll;
+    int64_t roundingError = (mantissa > (1ull << 53)) ? 2 : 0;
+    if((halfwayDistance >= -roundingError) && (halfwayDistance <= roundingError))
+    {
+        return false;
+    }
+
+    *result = negative ? -(float)value : (float)value;
+    return true;
+}
+
+#ifdef OBJ_NUMBER_SSE2
+
+// The vector paths look at a fixed window past the cursor (a 32 byte digit mask plus up to 8 bytes
+// of overread when the last digit run is assembled), so they only run with this much buffer left
+static const ptrdiff_t vectorWindowSize = 40;
+
+static inline int countTrailingZeros(uint32_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+// Bit i of the result is set when cursor[i] is a digit, for the 32 bytes starting at cursor
+static inline uint32_t digitMask(const char* cursor)
+{
+#ifdef OBJ_NUMBER_AVX2
+    __m256i bytes = _mm256_loadu_si256((const __m256i*)cursor);
+    __m256i aboveZero = _mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('0' - 1));
+    __m256i belowNine = _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), bytes);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(aboveZero, belowNine));
+#else
+    __m128i lowBytes = _mm_loadu_si128((const __m128i*)cursor);
+    __m128i highBytes = _mm_loadu_si128((const __m128i*)(cursor + 16));
+    __m128i zero = _mm_set1_epi8('0' - 1);
+    __m128i nine = _mm_set1_epi8('9' + 1);
+    uint32_t lowMask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(lowBytes, zero),
+                                                                  _mm_cmpgt_epi8(nine, lowBytes)));
+    uint32_t highMask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(highBytes, zero),
+                                                                   _mm_cmpgt_epi8(nine, highBytes)));
+    return lowMask | (highMask << 16);
+#endif
+}
+
+// NOTE: Combines 8 digits (already shifted down from ASCII) packed little-endian into one word:
+//       neighbouring digits are paired up with one multiply, then pairs of pairs, then the halves.
+//       A shorter run is shifted up to the top of the word first, which pads it with leading zeros
+static inline uint32_t combineEightDigits(uint64_t digits)
+{
+    digits = (digits * 10) + (digits >> 8);
+    digits = (((digits & 0x000000FF000000FFull) * 0x000F424000000064ull) +
+              (((digits >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32;
+    return (uint32_t)digits;
+}
+
+// Value of the count (1 to 19) digits at cursor, which needs 8 readable bytes after every chunk
+static inline uint64_t combineDigitRun(const char* cursor, int count)
+{
+    uint64_t value = 0;
+    for(; count >= 8; count -= 8, cursor += 8)
+    {
+        uint64_t digits;
+        memcpy(&digits, cursor, sizeof(digits));
+        value = (value * 100000000ull) + combineEightDigits(digits - 0x3030303030303030ull);
+    }
+    if(count > 0)
+    {
+        uint64_t digits;
+        memcpy(&digits, cursor, sizeof(digits));
+        digits = (digits - 0x3030303030303030ull) << (8 * (8 - count));
+        value = (value * integerPowersOfTen[count]) + combineEightDigits(digits);
+    }
+    return value;
+}
+
+#endif
+
+const char* parseOBJInt(const char* cursor, const char* end, int* result)
+{
+    const char* start = cursor;
+    bool negative = false;
+    if((cursor < end) && ((*cursor == '-') || (*cursor == '+')))
+    {
+        negative = (*cursor == '-');
+        cursor++;
+    }
+
+#ifdef OBJ_NUMBER_SSE2
+    if(end - cursor >= vectorWindowSize)
+    {
+        uint32_t digits = digitMask(cursor);
+        if(!(digits & 1))
+        {
+            return start;
+        }
+        if(digits != 0xFFFFFFFFu)
+        {
+            int count = countTrailingZeros(~digits);
+            if(count <= 9)
+            {
+                int value = (int)combineDigitRun(cursor, count);
+                *result = negative ? -value : value;
+                return cursor + count;
+            }
+        }
+        // Anything longer than 9 digits might overflow, so it goes through the loop below
+    }
+#endif
+
+    if((cursor >= end) || !isDigit(*cursor))
+    {
+        return start;
+    }
+
+    // NOTE: Out of range indices saturate rather than wrapping round into valid looking ones
+    int64_t value = 0;
+    while((cursor < end) && isDigit(*cursor))
+    {
+        value = (value * 10) + (*cursor - '0');
+        if(value > INT_MAX)
+        {
+            value = (int64_t)INT_MAX + 1;
+        }
+        cursor++;
+    }
+
+    if(negative)
+    {
+        value = -value;
+    }
+    *result = (value > INT_MAX) ? INT_MAX : ((value < INT_MIN) ? INT_MIN : (int)value);
+    return cursor;
+}
+
+// NOTE: Reads the digits and decimal point of a number into mantissa * 10^exponent, keeping at most
+//       19 significant digits and folding any further ones into the exponent. exact is cleared if
+//       a non-zero digit had to be dropped. Returns the cursor unchanged if there were no digits
+static const char* scanDecimal(const char* cursor, const char* end,
+                               uint64_t* mantissa, int* exponent, bool* exact)
+{
+    const char* start = cursor;
+    uint64_t value = 0;
+    int significantDigits = 0;
+    int scale = 0;
+    bool foundDigits = false;
+    bool droppedDigits = false;
+    while((cursor < end) && isDigit(*cursor))
+    {
+        if(significantDigits < maxExactDigits)
+        {
+            value = (value * 10) + (*cursor - '0');
+            if(value != 0)
+            {
+                significantDigits++;
+            }
+        }
+        else
+        {
+            droppedDigits |= (*cursor != '0');
+            scale++;
+        }
+        foundDigits = true;
+        cursor++;
+    }
+
+    if((cursor < end) && (*cursor == '.'))
+    {
+        cursor++;
+        while((cursor < end) && isDigit(*cursor))
+        {
+            if(significantDigits < maxExactDigits)
+            {
+                value = (value * 10) + (*cursor - '0');
+                if(value != 0)
+                {
+                    significantDigits++;
+                }
+                scale--;
+            }
+            else
+            {
+                droppedDigits |= (*cursor != '0');
+            }
+            foundDigits = true;
+            cursor++;
+        }
+    }
+
+    if(!foundDigits)
+    {
+        return start;
+    }
+
+    *mantissa = value;
+    *exponent = scale;
+    *exact = !droppedDigits;
+    return cursor;
+}
+
+const char* parseOBJFloat(const char* cursor, const char* end, float* result)
+{
+    const char* start = cursor;
+    bool negative = false;
+    if((cursor < end) && ((*cursor == '-') || (*cursor == '+')))
+    {
+        negative = (*cursor == '-');
+        cursor++;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool exact = true;
+    const char* digitsEnd = cursor;
+
+#ifdef OBJ_NUMBER_SSE2
+    // NOTE: One mask gives us the length of the integer digits, and after the point the length of
+    //       the fraction digits, so a typical "-0.123456" is assembled without a per-digit loop
+    if(end - cursor >= vectorWindowSize)
+    {
+        uint32_t digits = digitMask(cursor);
+        if(digits != 0xFFFFFFFFu)
+        {
+            int integerDigits = countTrailingZeros(~digits);
+            int fractionDigits = 0;
+            bool hasPoint = (cursor[integerDigits] == '.');
+            if(hasPoint && (integerDigits < 30))
+            {
+                fractionDigits = countTrailingZeros(~(digits >> (integerDigits + 1)));
+            }
+            int totalDigits = integerDigits + fractionDigits;
+            if((totalDigits > 0) && (totalDigits <= maxExactDigits) &&
+               (!hasPoint || (integerDigits + 1 + fractionDigits < 32)))
+            {
+                if(integerDigits > 0)
+                {
+                    mantissa = combineDigitRun(cursor, integerDigits);
+                }
+                if(fractionDigits > 0)
+                {
+                    mantissa = (mantissa * integerPowersOfTen[fractionDigits]) +
+                               combineDigitRun(cursor + integerDigits + 1, fractionDigits);
+                }
+                exponent = -fractionDigits;
+                digitsEnd = cursor + integerDigits + (hasPoint ? 1 + fractionDigits : 0);
+            }
+        }
+    }
+#endif
+
+    if(digitsEnd == cursor)
+    {
+        digitsEnd = scanDecimal(cursor, end, &mantissa, &exponent, &exact);
+        if(digitsEnd == cursor)
+        {
+            // nan, inf, hex floats and so on
+            return parseOBJFloatReference(start, end, result);
+        }
+    }
+    cursor = digitsEnd;
+
+    if((cursor < end) && ((*cursor == 'e') || (*cursor == 'E')))
+    {
+        int explicitExponent = 0;
+        const char* exponentEnd = parseOBJInt(cursor+1, end, &explicitExponent);
+        if(exponentEnd != cursor+1)
+        {
+            // Saturated exponents fail the range check in decimalToFloat either way
+            exponent = (explicitExponent > 100000) ? 100000 :
+                       ((explicitExponent < -100000) ? -100000 : exponent + explicitExponent);
+            cursor = exponentEnd;
+        }
+    }
+
+    // NOTE: With digits dropped past the 19th, the number lies somewhere between mantissa and
+    //       mantissa + 1 (in units of the last digit kept), and if both of those round to the same
+    //       float then so does everything in between
+    float value;
+    bool converted = decimalToFloat(mantissa, exponent, negative, &value);
+    if(converted && !exact)
+    {
+        float upperValue;
+        converted = decimalToFloat(mantissa + 1, exponent, negative, &upperValue) && (upperValue == value);
+    }
+    if(!converted)
+    {
+        return parseOBJFloatReference(start, end, result);
+    }
+    *result = value;
+    return cursor;
+}
+
+const char* objNumberParserPath()
+{
+#if defined(OBJ_NUMBER_AVX2)
+    return "AVX2";
+#elif defined(OBJ_NUMBER_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
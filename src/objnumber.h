@@ -0,0 +1,26 @@
+#ifndef OBJ_NUMBER_H
+#define OBJ_NUMBER_H
+
+// NOTE: Number scanners for the OBJ parsers. They work on a (cursor, end) range that doesn't have
+//       to be null-terminated, return the position just after the number they read, and leave both
+//       the cursor and the result alone if there is no number at the cursor.
+//
+//       parseOBJFloat always produces the correctly rounded float for the decimal it reads (the same
+//       value strtof would give). Numbers are classified with SSE2 (or AVX2 when compiled with
+//       -mavx2) and their digits combined eight at a time, into a 64-bit mantissa of up to 19
+//       significant digits. Anything the fast path can't round exactly (huge exponents, values that
+//       land on or right next to halfway between two floats, longer numbers whose dropped digits
+//       could change the rounding, nan/inf, ...) falls back to the reference versions below
+
+const char* parseOBJInt(const char* cursor, const char* end, int* result);
+const char* parseOBJFloat(const char* cursor, const char* end, float* result);
+
+// Slow but obviously correct versions built on strtol/strtof, used as the fallback and by the
+// benchmark to check the fast ones
+const char* parseOBJIntReference(const char* cursor, const char* end, int* result);
+const char* parseOBJFloatReference(const char* cursor, const char* end, float* result);
+
+// Which fast path was compiled in: "AVX2", "SSE2" or "scalar"
+const char* objNumberParserPath();
+
+#endif
@@ -0,0 +1,87 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <stdio.h>
+#include <string.h>
+#endif
+
+#include "processstats.h"
+
+#ifdef _WIN32
+
+size_t currentResidentBytes()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+}
+
+size_t peakResidentBytes()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+}
+
+bool resetPeakResidentBytes()
+{
+    return false;
+}
+
+#else
+
+// NOTE: /proc/self/status reports these as "VmRSS:    1234 kB"
+static size_t readStatusField(const char* fieldName)
+{
+    FILE* statusFile = fopen("/proc/self/status", "r");
+    if(!statusFile)
+    {
+        return 0;
+    }
+
+    size_t fieldNameLength = strlen(fieldName);
+    size_t kilobytes = 0;
+    char line[256];
+    while(fgets(line, sizeof(line), statusFile))
+    {
+        if((strncmp(line, fieldName, fieldNameLength) == 0) && (line[fieldNameLength] == ':'))
+        {
+            sscanf(line + fieldNameLength + 1, "%zu", &kilobytes);
+            break;
+        }
+    }
+    fclose(statusFile);
+    return kilobytes * 1024;
+}
+
+size_t currentResidentBytes()
+{
+    return readStatusField("VmRSS");
+}
+
+size_t peakResidentBytes()
+{
+    return readStatusField("VmHWM");
+}
+
+bool resetPeakResidentBytes()
+{
+    // Writing 5 to clear_refs resets VmHWM to the current RSS (Linux 4.0 and up)
+    FILE* clearRefsFile = fopen("/proc/self/clear_refs", "w");
+    if(!clearRefsFile)
+    {
+        return false;
+    }
+    bool written = (fputs("5", clearRefsFile) >= 0);
+    return (fclose(clearRefsFile) == 0) && written;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef PROCESS_STATS_H
+#define PROCESS_STATS_H
+
+#include <stddef.h>
+
+// NOTE: Resident set sizes for the current process, in bytes, used by the loaders and benchmarks to
+//       report how much memory they actually touched. Both return 0 where the platform doesn't
+//       give us the number
+
+size_t currentResidentBytes();
+size_t peakResidentBytes();
+
+// Restarts peak tracking from the current resident size, so that peakResidentBytes() only covers
+// what happens after this call. Returns false if the platform can't do that, in which case the
+// peak covers the whole lifetime of the process
+bool resetPeakResidentBytes();
+
+#endif
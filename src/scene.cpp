@@ -0,0 +1,36 @@
+#include <string.h>
+
+#include "scene.h"
+
+using namespace std;
+
+size_t Scene::add(const MeshHandle& mesh, const glm::mat4& transform, const glm::vec3& color)
+{
+    meshes.push_back(mesh);
+    transforms.push_back(transform);
+    colors.push_back(color);
+    lodLevels.push_back(0);
+    return meshes.size() - 1;
+}
+
+void Scene::clear()
+{
+    meshes.clear();
+    transforms.clear();
+    colors.clear();
+    lodLevels.clear();
+}
+
+void Scene::writeObjectData(const uint32_t* objects, size_t count, float* data) const
+{
+    for(size_t record=0; record<count; record++)
+    {
+        size_t object = objects[record];
+        float* objectData = data + record * instanceRecordFloats;
+        memcpy(objectData, &transforms[object][0][0], 16 * sizeof(float));
+        objectData[16] = colors[object].r;
+        objectData[17] = colors[object].g;
+        objectData[18] = colors[object].b;
+        objectData[19] = 1.0f;
+    }
+}
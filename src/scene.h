@@ -0,0 +1,44 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#include "meshregistry.h"
+#include "glvertexformat.h"
+
+// NOTE: Everything the window draws, as one entry per object in a set of parallel arrays: the mesh
+//       it draws, its model matrix, its color and the LOD it drew last frame. Objects are numbered
+//       0 to size() - 1 in the order they were added, and the arrays always stay in step. An object
+//       with an empty mesh handle is drawn from somewhere other than the registry, which is up to
+//       the window
+class Scene
+{
+public:
+    // Adds an object and returns its number
+    size_t add(const MeshHandle& mesh, const glm::mat4& transform, const glm::vec3& color=glm::vec3(1.0f));
+    void clear();
+
+    size_t size() const { return meshes.size(); }
+    bool empty() const { return meshes.empty(); }
+
+    const MeshHandle& mesh(size_t object) const { return meshes[object]; }
+    glm::mat4& transform(size_t object) { return transforms[object]; }
+    glm::vec3& color(size_t object) { return colors[object]; }
+    int& lodLevel(size_t object) { return lodLevels[object]; }
+
+    // Writes the transform and color of each of the count objects listed, in that order, as instance
+    // records (instanceRecordFloats each), for them all to go to the GPU in one upload
+    void writeObjectData(const uint32_t* objects, size_t count, float* data) const;
+
+private:
+    std::vector<MeshHandle> meshes;
+    std::vector<glm::mat4> transforms;
+    std::vector<glm::vec3> colors;
+    std::vector<int> lodLevels;
+};
+
+#endif
@@ -0,0 +1,407 @@
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "vertexformat.h"
+
+int vertexAttributeComponents(VertexAttribute attribute)
+{
+    return (attribute == VERTEX_TEXTURE_COORD) ? 2 : 3;
+}
+
+// Falls back to floats for encodings that don't fit the attribute
+static VertexEncoding supportedEncoding(VertexAttribute attribute, VertexEncoding requested)
+{
+    switch(attribute)
+    {
+    case VERTEX_POSITION:
+        return ((requested == VERTEX_ENCODING_UNORM16_BOUNDS) || (requested == VERTEX_ENCODING_HALF_BOUNDS)) ?
+               requested : VERTEX_ENCODING_FLOAT;
+    case VERTEX_TEXTURE_COORD:
+        return (requested == VERTEX_ENCODING_HALF) ? requested : VERTEX_ENCODING_FLOAT;
+    default:
+        return ((requested == VERTEX_ENCODING_OCTAHEDRAL_SNORM16) || (requested == VERTEX_ENCODING_SNORM_10_10_10_2)) ?
+               requested : VERTEX_ENCODING_FLOAT;
+    }
+}
+
+static void describeAttribute(VertexAttributeFormat& attributeFormat, VertexAttribute attribute,
+                              VertexEncoding encoding)
+{
+    attributeFormat.present = true;
+    attributeFormat.encoding = encoding;
+    attributeFormat.componentCount = vertexAttributeComponents(attribute);
+    attributeFormat.componentType = VERTEX_COMPONENT_FLOAT;
+    attributeFormat.normalized = false;
+
+    switch(encoding)
+    {
+    case VERTEX_ENCODING_HALF:
+    case VERTEX_ENCODING_HALF_BOUNDS:
+        attributeFormat.componentType = VERTEX_COMPONENT_HALF_FLOAT;
+        break;
+    case VERTEX_ENCODING_UNORM16_BOUNDS:
+        attributeFormat.componentType = VERTEX_COMPONENT_UNSIGNED_SHORT;
+        attributeFormat.normalized = true;
+        break;
+    case VERTEX_ENCODING_OCTAHEDRAL_SNORM16:
+        attributeFormat.componentCount = 2;
+        attributeFormat.componentType = VERTEX_COMPONENT_SHORT;
+        attributeFormat.normalized = true;
+        break;
+    case VERTEX_ENCODING_SNORM_10_10_10_2:
+        // GL only accepts this type with 4 components
+        attributeFormat.componentCount = 4;
+        attributeFormat.componentType = VERTEX_COMPONENT_INT_2_10_10_10_REV;
+        attributeFormat.normalized = true;
+        break;
+    default:
+        break;
+    }
+}
+
+static size_t attributeSize(const VertexAttributeFormat& attributeFormat)
+{
+    switch(attributeFormat.componentType)
+    {
+    case VERTEX_COMPONENT_HALF_FLOAT:
+    case VERTEX_COMPONENT_SHORT:
+    case VERTEX_COMPONENT_UNSIGNED_SHORT:
+        return attributeFormat.componentCount * 2;
+    case VERTEX_COMPONENT_INT_2_10_10_10_REV:
+        return 4;
+    default:
+        return attributeFormat.componentCount * sizeof(float);
+    }
+}
+
+static VertexFormat buildFormat(unsigned int attributeMask, const VertexEncoding encodings[VERTEX_ATTRIBUTE_COUNT])
+{
+    VertexFormat format;
+    memset(&format, 0, sizeof(format));
+
+    size_t offset = 0;
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        VertexAttributeFormat& attributeFormat = format.attributes[attribute];
+        if(!(attributeMask & vertexAttributeBit((VertexAttribute)attribute)))
+        {
+            continue;
+        }
+        describeAttribute(attributeFormat, (VertexAttribute)attribute, encodings[attribute]);
+        attributeFormat.offset = offset;
+        offset += (attributeSize(attributeFormat) + 3) & ~(size_t)3;
+    }
+    format.stride = offset;
+
+    for(int axis=0; axis<3; axis++)
+    {
+        format.positionScale[axis] = 1.0f;
+        format.positionOffset[axis] = 0.0f;
+    }
+    return format;
+}
+
+VertexFormat interleavedVertexFormat(unsigned int attributeMask)
+{
+    VertexEncoding encodings[VERTEX_ATTRIBUTE_COUNT];
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        encodings[attribute] = VERTEX_ENCODING_FLOAT;
+    }
+    return buildFormat(attributeMask, encodings);
+}
+
+VertexFormat packedVertexFormat(unsigned int attributeMask, const VertexPacking& packing,
+                                const MeshBounds& bounds)
+{
+    VertexEncoding encodings[VERTEX_ATTRIBUTE_COUNT];
+    encodings[VERTEX_POSITION] = supportedEncoding(VERTEX_POSITION, packing.positions);
+    encodings[VERTEX_TEXTURE_COORD] = supportedEncoding(VERTEX_TEXTURE_COORD, packing.textureCoords);
+    encodings[VERTEX_NORMAL] = supportedEncoding(VERTEX_NORMAL, packing.directions);
+    encodings[VERTEX_TANGENT] = supportedEncoding(VERTEX_TANGENT, packing.directions);
+    encodings[VERTEX_BITANGENT] = supportedEncoding(VERTEX_BITANGENT, packing.directions);
+    VertexFormat format = buildFormat(attributeMask, encodings);
+
+    VertexEncoding positionEncoding = format.attributes[VERTEX_POSITION].encoding;
+    if(!format.attributes[VERTEX_POSITION].present || (positionEncoding == VERTEX_ENCODING_FLOAT))
+    {
+        return format;
+    }
+
+    const float* lower = bounds.lower;
+    const float* upper = bounds.upper;
+
+    // NOTE: A flat axis keeps a scale of 1, everything on it encodes to 0 either way
+    for(int axis=0; axis<3; axis++)
+    {
+        float extent = upper[axis] - lower[axis];
+        if(positionEncoding == VERTEX_ENCODING_UNORM16_BOUNDS)
+        {
+            format.positionScale[axis] = (extent > 0.0f) ? extent : 1.0f;
+            format.positionOffset[axis] = lower[axis];
+        }
+        else
+        {
+            format.positionScale[axis] = (extent > 0.0f) ? extent * 0.5f : 1.0f;
+            format.positionOffset[axis] = (lower[axis] + upper[axis]) * 0.5f;
+        }
+    }
+    return format;
+}
+
+static inline glm::vec2 signNotZero(glm::vec2 v)
+{
+    return glm::vec2((v.x >= 0.0f) ? 1.0f : -1.0f, (v.y >= 0.0f) ? 1.0f : -1.0f);
+}
+
+// NOTE: Projects the unit vector onto the octahedron |x|+|y|+|z| = 1 and unfolds the lower half
+//       over the corners of the upper one, giving a point in the [-1, 1] square
+static glm::vec2 octahedralEncode(glm::vec3 direction)
+{
+    float length = fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z);
+    if(!(length > 0.0f))
+    {
+        // Zero (or NaN) vectors, there's nothing sensible to keep
+        return glm::vec2(0.0f);
+    }
+    direction /= length;
+
+    glm::vec2 square(direction.x, direction.y);
+    if(direction.z < 0.0f)
+    {
+        square = (1.0f - glm::abs(glm::vec2(square.y, square.x))) * signNotZero(square);
+    }
+    return square;
+}
+
+static glm::vec3 octahedralDecode(glm::vec2 square)
+{
+    glm::vec3 direction(square.x, square.y, 1.0f - fabsf(square.x) - fabsf(square.y));
+    if(direction.z < 0.0f)
+    {
+        glm::vec2 folded = (1.0f - glm::abs(glm::vec2(direction.y, direction.x))) *
+                           signNotZero(glm::vec2(direction.x, direction.y));
+        direction.x = folded.x;
+        direction.y = folded.y;
+    }
+    return glm::normalize(direction);
+}
+
+static void encodeAttribute(const VertexFormat& format, const VertexAttributeFormat& attributeFormat,
+                            const float* values, char* target)
+{
+    uint16_t packed[4];
+    switch(attributeFormat.encoding)
+    {
+    case VERTEX_ENCODING_HALF:
+        for(int component=0; component<attributeFormat.componentCount; component++)
+        {
+            packed[component] = glm::packHalf1x16(values[component]);
+        }
+        memcpy(target, packed, attributeFormat.componentCount * sizeof(uint16_t));
+        break;
+    case VERTEX_ENCODING_UNORM16_BOUNDS:
+    case VERTEX_ENCODING_HALF_BOUNDS:
+        for(int axis=0; axis<3; axis++)
+        {
+            float local = (values[axis] - format.positionOffset[axis]) / format.positionScale[axis];
+            packed[axis] = (attributeFormat.encoding == VERTEX_ENCODING_UNORM16_BOUNDS) ?
+                           glm::packUnorm1x16(local) : glm::packHalf1x16(local);
+        }
+        memcpy(target, packed, 3 * sizeof(uint16_t));
+        break;
+    case VERTEX_ENCODING_OCTAHEDRAL_SNORM16:
+    {
+        glm::vec2 square = octahedralEncode(glm::vec3(values[0], values[1], values[2]));
+        packed[0] = glm::packSnorm1x16(square.x);
+        packed[1] = glm::packSnorm1x16(square.y);
+        memcpy(target, packed, 2 * sizeof(uint16_t));
+        break;
+    }
+    case VERTEX_ENCODING_SNORM_10_10_10_2:
+    {
+        glm::vec3 direction(values[0], values[1], values[2]);
+        float length = glm::length(direction);
+        if(length > 0.0f)
+        {
+            direction /= length;
+        }
+        uint32_t word = glm::packSnorm3x10_1x2(glm::vec4(direction, 0.0f));
+        memcpy(target, &word, sizeof(word));
+        break;
+    }
+    default:
+        memcpy(target, values, attributeFormat.componentCount * sizeof(float));
+        break;
+    }
+}
+
+// The inverse of encodeAttribute, giving back vertexAttributeComponents floats
+static void decodeAttribute(const VertexFormat& format, const VertexAttributeFormat& attributeFormat,
+                            const char* source, float* values)
+{
+    uint16_t packed[4];
+    switch(attributeFormat.encoding)
+    {
+    case VERTEX_ENCODING_HALF:
+        memcpy(packed, source, attributeFormat.componentCount * sizeof(uint16_t));
+        for(int component=0; component<attributeFormat.componentCount; component++)
+        {
+            values[component] = glm::unpackHalf1x16(packed[component]);
+        }
+        break;
+    case VERTEX_ENCODING_UNORM16_BOUNDS:
+    case VERTEX_ENCODING_HALF_BOUNDS:
+        memcpy(packed, source, 3 * sizeof(uint16_t));
+        for(int axis=0; axis<3; axis++)
+        {
+            float local = (attributeFormat.encoding == VERTEX_ENCODING_UNORM16_BOUNDS) ?
+                          glm::unpackUnorm1x16(packed[axis]) : glm::unpackHalf1x16(packed[axis]);
+            values[axis] = local * format.positionScale[axis] + format.positionOffset[axis];
+        }
+        break;
+    case VERTEX_ENCODING_OCTAHEDRAL_SNORM16:
+    {
+        memcpy(packed, source, 2 * sizeof(uint16_t));
+        glm::vec3 direction = octahedralDecode(glm::vec2(glm::unpackSnorm1x16(packed[0]),
+                                                         glm::unpackSnorm1x16(packed[1])));
+        values[0] = direction.x;
+        values[1] = direction.y;
+        values[2] = direction.z;
+        break;
+    }
+    case VERTEX_ENCODING_SNORM_10_10_10_2:
+    {
+        uint32_t word;
+        memcpy(&word, source, sizeof(word));
+        glm::vec4 direction = glm::unpackSnorm3x10_1x2(word);
+        values[0] = direction.x;
+        values[1] = direction.y;
+        values[2] = direction.z;
+        break;
+    }
+    default:
+        memcpy(values, source, attributeFormat.componentCount * sizeof(float));
+        break;
+    }
+}
+
+void interleaveVertices(const VertexFormat& format, const void* const sources[VERTEX_ATTRIBUTE_COUNT],
+                        size_t vertexCount, void* destination)
+{
+    // NOTE: One pass per attribute rather than one per vertex: each pass reads one source array
+    //       front to back and writes at a fixed stride, and for plain floats the inner copy has a
+    //       constant size that the compiler turns into a couple of moves
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        const VertexAttributeFormat& attributeFormat = format.attributes[attribute];
+        if(!attributeFormat.present)
+        {
+            continue;
+        }
+
+        const float* source = (const float*)sources[attribute];
+        char* target = (char*)destination + attributeFormat.offset;
+        int sourceComponents = vertexAttributeComponents((VertexAttribute)attribute);
+        if(attributeFormat.encoding != VERTEX_ENCODING_FLOAT)
+        {
+            for(size_t vertex=0; vertex<vertexCount; vertex++)
+            {
+                encodeAttribute(format, attributeFormat, source + vertex*sourceComponents,
+                                target + vertex*format.stride);
+            }
+        }
+        else if(sourceComponents == 2)
+        {
+            for(size_t vertex=0; vertex<vertexCount; vertex++)
+            {
+                memcpy(target + vertex*format.stride, source + vertex*2, 2*sizeof(float));
+            }
+        }
+        else
+        {
+            for(size_t vertex=0; vertex<vertexCount; vertex++)
+            {
+                memcpy(target + vertex*format.stride, source + vertex*3, 3*sizeof(float));
+            }
+        }
+    }
+}
+
+VertexPackingError measurePackingError(const VertexFormat& format,
+                                       const void* const sources[VERTEX_ATTRIBUTE_COUNT], size_t vertexCount)
+{
+    const float radiansToDegrees = 57.29577951f;
+
+    VertexPackingError error;
+    memset(&error, 0, sizeof(error));
+
+    double positionErrorSquares = 0.0;
+    double directionDegrees = 0.0;
+    size_t directionCount = 0;
+    for(int attribute=0; attribute<VERTEX_ATTRIBUTE_COUNT; attribute++)
+    {
+        const VertexAttributeFormat& attributeFormat = format.attributes[attribute];
+        if(!attributeFormat.present)
+        {
+            continue;
+        }
+
+        const float* source = (const float*)sources[attribute];
+        int sourceComponents = vertexAttributeComponents((VertexAttribute)attribute);
+        for(size_t vertex=0; vertex<vertexCount; vertex++)
+        {
+            const float* original = source + vertex*sourceComponents;
+            char packed[16];
+            float decoded[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            encodeAttribute(format, attributeFormat, original, packed);
+            decodeAttribute(format, attributeFormat, packed, decoded);
+
+            if(attribute == VERTEX_POSITION)
+            {
+                glm::vec3 difference(decoded[0] - original[0], decoded[1] - original[1], decoded[2] - original[2]);
+                float distance = glm::length(difference);
+                error.maxPositionError = fmaxf(error.maxPositionError, distance);
+                positionErrorSquares += (double)distance * distance;
+            }
+            else if(attribute == VERTEX_TEXTURE_COORD)
+            {
+                error.maxTexCoordError = fmaxf(error.maxTexCoordError,
+                                               fmaxf(fabsf(decoded[0] - original[0]), fabsf(decoded[1] - original[1])));
+            }
+            else
+            {
+                // A zero vector (which the encodings may also round a very short one to) has no
+                // direction to compare
+                glm::vec3 expected(original[0], original[1], original[2]);
+                glm::vec3 actual(decoded[0], decoded[1], decoded[2]);
+                float expectedLength = glm::length(expected);
+                float actualLength = glm::length(actual);
+                if(!(expectedLength > 1e-6f) || !(actualLength > 1e-6f))
+                {
+                    continue;
+                }
+                float cosine = glm::dot(expected, actual) / (expectedLength * actualLength);
+                float degrees = acosf(fminf(fmaxf(cosine, -1.0f), 1.0f)) * radiansToDegrees;
+                error.maxDirectionDegrees = fmaxf(error.maxDirectionDegrees, degrees);
+                directionDegrees += degrees;
+                directionCount++;
+            }
+        }
+    }
+
+    if(vertexCount > 0)
+    {
+        error.rmsPositionError = (float)sqrt(positionErrorSquares / vertexCount);
+    }
+    if(directionCount > 0)
+    {
+        error.meanDirectionDegrees = (float)(directionDegrees / directionCount);
+    }
+    return error;
+}
@@ -0,0 +1,124 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <stddef.h>
+
+#include "meshbounds.h"
+
+// NOTE: The attributes a mesh can carry, in the order GeometryData and MeshCache keep them. Each one
+//       is a separate tightly packed float array in the loaders (struct of arrays)
+enum VertexAttribute
+{
+    VERTEX_POSITION,
+    VERTEX_TEXTURE_COORD,
+    VERTEX_NORMAL,
+    VERTEX_TANGENT,
+    VERTEX_BITANGENT,
+    VERTEX_ATTRIBUTE_COUNT
+};
+
+enum VertexComponentType
+{
+    VERTEX_COMPONENT_FLOAT,
+    VERTEX_COMPONENT_HALF_FLOAT,
+    VERTEX_COMPONENT_SHORT,
+    VERTEX_COMPONENT_UNSIGNED_SHORT,
+    VERTEX_COMPONENT_INT_2_10_10_10_REV
+};
+
+// NOTE: How an attribute's floats are turned into the components that get stored.
+//
+//       The two _BOUNDS encodings are for positions: each coordinate is first mapped into the mesh's
+//       bounding box (to [0, 1] for unorm16, to [-1, 1] around the centre for half floats) and the
+//       shader maps it back with the VertexFormat's positionScale and positionOffset.
+//
+//       OCTAHEDRAL_SNORM16 and SNORM_10_10_10_2 are for unit vectors (normals, tangents and
+//       bitangents). The octahedral one folds the sphere onto a square and stores the two square
+//       coordinates, so the shader has to unfold it again. 10_10_10_2 is plain xyz that the shader
+//       reads directly (with w set to zero)
+enum VertexEncoding
+{
+    VERTEX_ENCODING_FLOAT,
+    VERTEX_ENCODING_HALF,
+    VERTEX_ENCODING_UNORM16_BOUNDS,
+    VERTEX_ENCODING_HALF_BOUNDS,
+    VERTEX_ENCODING_OCTAHEDRAL_SNORM16,
+    VERTEX_ENCODING_SNORM_10_10_10_2
+};
+
+struct VertexAttributeFormat
+{
+    bool present;
+    VertexEncoding encoding;
+    int componentCount;
+    VertexComponentType componentType;
+    bool normalized;
+
+    // Byte offset of the attribute from the start of each vertex
+    size_t offset;
+};
+
+// NOTE: Runtime description of one interleaved (array of structs) vertex: which attributes it holds,
+//       where each of them sits and how its components are stored. stride is the size of a whole
+//       vertex, so that attribute a of vertex i lives at i*stride + attributes[a].offset.
+//
+//       The model space position is stored*positionScale + positionOffset, which is the identity for
+//       float positions, and has to be handed to the vertex shader for the packed ones
+struct VertexFormat
+{
+    VertexAttributeFormat attributes[VERTEX_ATTRIBUTE_COUNT];
+    size_t stride;
+
+    float positionScale[3];
+    float positionOffset[3];
+};
+
+// Which encoding to use for each kind of attribute when packing. Encodings that don't make sense for
+// an attribute (octahedral positions, say) leave it as floats
+struct VertexPacking
+{
+    VertexEncoding positions;
+    VertexEncoding textureCoords;
+    VertexEncoding directions;
+};
+
+// How far the packed attributes are from the original floats, as decoded on the CPU. Position errors
+// are in model space units, direction errors are the angle between the original and packed vectors
+struct VertexPackingError
+{
+    float maxPositionError;
+    float rmsPositionError;
+    float maxTexCoordError;
+    float maxDirectionDegrees;
+    float meanDirectionDegrees;
+};
+
+// Bit for attribute a in an attribute mask
+inline unsigned int vertexAttributeBit(VertexAttribute attribute)
+{
+    return 1u << attribute;
+}
+
+const unsigned int allVertexAttributes = (1u << VERTEX_ATTRIBUTE_COUNT) - 1;
+
+// Number of floats each attribute has in the loaders' separate arrays
+int vertexAttributeComponents(VertexAttribute attribute);
+
+// Packs every attribute in attributeMask one after the other, in VertexAttribute order, as floats
+VertexFormat interleavedVertexFormat(unsigned int attributeMask);
+
+// Same layout but with each attribute encoded as packing asks (and padded to 4 bytes, which GL wants
+// for every attribute). The position encodings are fitted to the mesh's bounds
+VertexFormat packedVertexFormat(unsigned int attributeMask, const VertexPacking& packing,
+                                const MeshBounds& bounds);
+
+// Gathers vertexCount vertices from the separate per-attribute arrays in sources (which only need to
+// be set for the attributes in format) into destination, format.stride bytes per vertex
+void interleaveVertices(const VertexFormat& format, const void* const sources[VERTEX_ATTRIBUTE_COUNT],
+                        size_t vertexCount, void* destination);
+
+// Packs and unpacks every vertex in turn (without needing the packed buffer) to see what was lost
+VertexPackingError measurePackingError(const VertexFormat& format,
+                                       const void* const sources[VERTEX_ATTRIBUTE_COUNT], size_t vertexCount);
+
+#endif
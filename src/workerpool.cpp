@@ -0,0 +1,117 @@
+#include "workerpool.h"
+
+using namespace std;
+
+// NOTE: Tasks that themselves call run() would otherwise wait on a batch that can never finish,
+//       so nested batches just execute inline on whichever worker asked for them
+static thread_local bool insideWorkerPoolTask = false;
+
+WorkerPool& WorkerPool::shared()
+{
+    static WorkerPool pool(thread::hardware_concurrency());
+    return pool;
+}
+
+WorkerPool::WorkerPool(int threadCount)
+    : currentTask(0), currentTaskCount(0), nextTaskIndex(0),
+      activeWorkers(0), batchGeneration(0), stopping(false)
+{
+    for(int threadIndex=1; threadIndex<threadCount; threadIndex++)
+    {
+        workers.push_back(thread(&WorkerPool::workerLoop, this));
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        lock_guard<mutex> lock(batchMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for(size_t threadIndex=0; threadIndex<workers.size(); threadIndex++)
+    {
+        workers[threadIndex].join();
+    }
+}
+
+int WorkerPool::threadCount()
+{
+    return workers.size() + 1;
+}
+
+void WorkerPool::run(int taskCount, const function<void(int)>& task)
+{
+    if((taskCount <= 1) || workers.empty() || insideWorkerPoolTask)
+    {
+        for(int taskIndex=0; taskIndex<taskCount; taskIndex++)
+        {
+            task(taskIndex);
+        }
+        return;
+    }
+
+    // NOTE: There is only one current batch, so a second thread submitting now would overwrite the
+    //       task and restart the index under the first one's workers. It waits its turn instead
+    lock_guard<mutex> submitLock(submitMutex);
+    {
+        unique_lock<mutex> lock(batchMutex);
+        // A worker that woke up too late for the previous batch may still be on its way out
+        doneCondition.wait(lock, [this]{ return activeWorkers == 0; });
+
+        currentTask = &task;
+        currentTaskCount = taskCount;
+        nextTaskIndex = 0;
+        batchGeneration++;
+    }
+    wakeCondition.notify_all();
+
+    runTasks();
+
+    unique_lock<mutex> lock(batchMutex);
+    doneCondition.wait(lock, [this]{ return activeWorkers == 0; });
+    currentTask = 0;
+    currentTaskCount = 0;
+}
+
+void WorkerPool::runTasks()
+{
+    insideWorkerPoolTask = true;
+    for(;;)
+    {
+        int taskIndex = nextTaskIndex.fetch_add(1);
+        if(taskIndex >= currentTaskCount)
+        {
+            break;
+        }
+        (*currentTask)(taskIndex);
+    }
+    insideWorkerPoolTask = false;
+}
+
+void WorkerPool::workerLoop()
+{
+    unsigned int seenGeneration = 0;
+    for(;;)
+    {
+        {
+            unique_lock<mutex> lock(batchMutex);
+            wakeCondition.wait(lock, [&]{ return stopping || (batchGeneration != seenGeneration); });
+            if(stopping)
+            {
+                return;
+            }
+            seenGeneration = batchGeneration;
+            activeWorkers++;
+        }
+
+        runTasks();
+
+        {
+            lock_guard<mutex> lock(batchMutex);
+            activeWorkers--;
+        }
+        doneCondition.notify_all();
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+// NOTE: A fixed set of worker threads (one per hardware thread, minus the caller) that the geometry
+//       code can farm batches of independent tasks out to. run() blocks until every task in the
+//       batch has finished, with the calling thread picking up tasks as well, so from the outside
+//       it behaves just like a for loop over the task indices. Any thread may call run(), and
+//       batches from different threads take turns rather than sharing the pool
+class WorkerPool
+{
+public:
+    static WorkerPool& shared();
+
+    // Number of threads that take part in run(), including the caller
+    int threadCount();
+
+    void run(int taskCount, const std::function<void(int)>& task);
+
+private:
+    WorkerPool(int threadCount);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> workers;
+
+    // Held by whichever thread's batch currently owns the pool, for the whole of run()
+    std::mutex submitMutex;
+
+    std::mutex batchMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    const std::function<void(int)>* currentTask;
+    int currentTaskCount;
+    std::atomic<int> nextTaskIndex;
+    int activeWorkers;
+    unsigned int batchGeneration;
+    bool stopping;
+};
+
+#endif
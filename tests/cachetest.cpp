@@ -0,0 +1,144 @@
+#include <fstream>
+#include <iterator>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+using namespace std;
+
+#include "geometry.h"
+#include "meshcache.h"
+#include "benchutil.h"
+#include "testutil.h"
+
+static const unsigned int cachedOptimizations = MESH_OPTIMIZE_VERTEX_CACHE | MESH_OPTIMIZE_VERTEX_FETCH |
+                                                MESH_OPTIMIZE_LOD_CHAIN | MESH_OPTIMIZE_MESHLETS;
+
+// Whether the entry holds the same mesh as loading and optimizing the OBJ directly
+static bool matchesOBJ(MeshCache& cache, const string& objPath)
+{
+    GeometryData geometry;
+    {
+        SilenceCout silence;
+        if(!geometry.loadFromOBJFile(objPath))
+        {
+            return false;
+        }
+        geometry.optimize(cachedOptimizations);
+    }
+    return (cache.vertexCount() == geometry.vertexCount()) && (cache.indexCount() == geometry.indexCount()) &&
+           (memcmp(cache.vertexData(), geometry.vertexData(), geometry.vertexCount()*3*sizeof(float)) == 0) &&
+           (memcmp(cache.indexData(), geometry.indexData(), geometry.indexCount()*sizeof(unsigned int)) == 0) &&
+           (cache.lodLevelCount() == geometry.lodLevelCount()) && (cache.lodIndexCount() == geometry.lodIndexCount()) &&
+           (memcmp(cache.lodIndexData(), geometry.lodIndexData(), geometry.lodIndexCount()*sizeof(unsigned int)) == 0) &&
+           (cache.meshlets().count == geometry.meshlets().count) && (cache.meshlets().count > 0);
+}
+
+static bool loadCached(MeshCache& cache, const string& objPath)
+{
+    SilenceCout silence;
+    return cache.load(objPath, cachedOptimizations);
+}
+
+// NOTE: Entries are always written to a new file that is then renamed over the old one, so a new
+//       inode means the entry was rebuilt and the same one means it was used as it was
+static ino_t entryInode(const string& entryPath)
+{
+    struct stat fileInfo;
+    return (stat(entryPath.c_str(), &fileInfo) == 0) ? fileInfo.st_ino : 0;
+}
+
+static off_t entrySize(const string& entryPath)
+{
+    struct stat fileInfo;
+    return (stat(entryPath.c_str(), &fileInfo) == 0) ? fileInfo.st_size : 0;
+}
+
+void testMeshCache()
+{
+    // entries go next to the OBJ, named after its canonical path
+    MeshCache::setCacheDirectory("");
+    string objPath = scratchPath("cached.obj");
+    writeTextFile(objPath, gridOBJ(24));
+    char canonicalPath[PATH_MAX];
+    if(!CHECK(realpath(objPath.c_str(), canonicalPath) != 0))
+    {
+        return;
+    }
+    string entryPath = string(canonicalPath) + ".meshcache";
+    remove(entryPath.c_str());
+
+    {
+        MeshCache cache;
+        CHECK(loadCached(cache, objPath) && matchesOBJ(cache, objPath));
+    }
+    ino_t builtInode = entryInode(entryPath);
+    off_t builtSize = entrySize(entryPath);
+    CHECK((builtInode != 0) && (builtSize > 0));
+    {
+        MeshCache cache;
+        CHECK(loadCached(cache, objPath) && matchesOBJ(cache, objPath));
+        CHECK(entryInode(entryPath) == builtInode);
+    }
+
+    // a truncated entry, cut off inside the header or inside the sections, is rebuilt rather than
+    // read past its end
+    const off_t truncatedSizes[] = {16, builtSize / 2, builtSize - 1};
+    for(int truncated=0; truncated<3; truncated++)
+    {
+        ifstream inStream(entryPath.c_str(), ifstream::binary);
+        string entry((istreambuf_iterator<char>(inStream)), istreambuf_iterator<char>());
+        inStream.close();
+        writeTextFile(entryPath, entry.substr(0, truncatedSizes[truncated]));
+        ino_t truncatedInode = entryInode(entryPath);
+
+        MeshCache cache;
+        CHECK(loadCached(cache, objPath) && matchesOBJ(cache, objPath));
+        CHECK((entryInode(entryPath) != truncatedInode) && (entrySize(entryPath) == builtSize));
+    }
+
+    // an entry is stale once the OBJ's size or modification time changes
+    writeTextFile(objPath, gridOBJ(20));
+    {
+        MeshCache cache;
+        CHECK(loadCached(cache, objPath) && matchesOBJ(cache, objPath));
+        CHECK(cache.indexCount() == 20*20*6);
+    }
+
+    struct stat objInfo;
+    CHECK(stat(objPath.c_str(), &objInfo) == 0);
+    struct utimbuf times;
+    times.actime = objInfo.st_atime;
+    times.modtime = objInfo.st_mtime + 10;
+    string moved = gridOBJ(20);
+    moved[2] = (moved[2] == '0') ? '1' : '0';
+    writeTextFile(objPath, moved);
+    CHECK(utime(objPath.c_str(), &times) == 0);
+    ino_t staleInode = entryInode(entryPath);
+    {
+        MeshCache cache;
+        CHECK(loadCached(cache, objPath) && matchesOBJ(cache, objPath));
+        CHECK(entryInode(entryPath) != staleInode);
+    }
+
+    // with the contents verified, an edit that keeps the size and modification time is caught too
+    MeshCache::setVerifyContents(true);
+    moved[2] = (moved[2] == '0') ? '1' : '0';
+    writeTextFile(objPath, moved);
+    CHECK(utime(objPath.c_str(), &times) == 0);
+    ino_t editedInode = entryInode(entryPath);
+    {
+        MeshCache cache;
+        CHECK(loadCached(cache, objPath) && matchesOBJ(cache, objPath));
+        CHECK(entryInode(entryPath) != editedInode);
+    }
+    MeshCache::setVerifyContents(false);
+
+    // and an OBJ that isn't there fails rather than turning up an old entry
+    MeshCache missing;
+    CHECK(!loadCached(missing, scratchPath("missing.obj")));
+    remove(entryPath.c_str());
+}
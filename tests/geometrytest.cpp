@@ -0,0 +1,35 @@
+#include <iostream>
+
+using namespace std;
+
+#include "testutil.h"
+
+// NOTE: Checks the geometry library on its own, without GL: the OBJ loaders, the number parser, the
+//       mesh cache, and the mesh processing passes, mostly on small made up meshes whose right answer
+//       is known. OBJ files and cache entries are written to the directory given on the command line
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        cout << "usage: " << argv[0] << " scratchdirectory" << endl;
+        return 1;
+    }
+    setScratchDirectory(argv[1]);
+
+    testOBJLoading();
+    testNumberParsing();
+    testMeshCache();
+    testMeshOptimization();
+    testMeshSimplification();
+    testMeshlets();
+    testMeshletCulling();
+
+    if(checkFailureCount() > 0)
+    {
+        cout << checkFailureCount() << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <random>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+
+#include "geometry.h"
+#include "objnumber.h"
+#include "benchutil.h"
+#include "testutil.h"
+
+// NOTE: The unit square as two triangles, 1 2 3 and 1 3 4, written out a few different ways
+static const float squarePositions[] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+static const unsigned int squareIndices[] = {0, 1, 2, 0, 2, 3};
+static const char* squareVertices = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n";
+
+static bool loadText(const string& contents, GeometryData& geometry, OBJLoadMode mode, bool prescan=true)
+{
+    string path = scratchPath("loader.obj");
+    writeTextFile(path, contents);
+    SilenceCout silence;
+    return geometry.loadFromOBJFile(path, mode, prescan);
+}
+
+static bool isSquare(GeometryData& geometry)
+{
+    return (geometry.vertexCount() == 4) && (geometry.indexCount() == 6) &&
+           (memcmp(geometry.indexData(), squareIndices, sizeof(squareIndices)) == 0) &&
+           (memcmp(geometry.vertexData(), squarePositions, sizeof(squarePositions)) == 0);
+}
+
+// Collects everything streamFromOBJFile hands over, checking the blocks arrive in order
+class CollectingSink : public VertexBlockSink
+{
+public:
+    CollectingSink() : totalVertexCount(0), floatsPerVertex(0), inOrder(true) {}
+
+    void beginVertices(size_t totalVertexCount, int floatsPerVertex)
+    {
+        this->totalVertexCount = totalVertexCount;
+        this->floatsPerVertex = floatsPerVertex;
+        vertexData.clear();
+    }
+
+    void consumeVertices(const float* vertexData, size_t firstVertex, size_t vertexCount)
+    {
+        inOrder = inOrder && (firstVertex * floatsPerVertex == this->vertexData.size());
+        this->vertexData.insert(this->vertexData.end(), vertexData, vertexData + vertexCount * floatsPerVertex);
+    }
+
+    size_t totalVertexCount;
+    int floatsPerVertex;
+    bool inOrder;
+    vector<float> vertexData;
+};
+
+static bool streamText(const string& contents, CollectingSink& sink, size_t blockSize)
+{
+    string path = scratchPath("stream.obj");
+    writeTextFile(path, contents);
+    SilenceCout silence;
+    OBJStreamStats stats = OBJStreamStats();
+    return GeometryData::streamFromOBJFile(path, sink, blockSize, &stats);
+}
+
+void testOBJLoading()
+{
+    const OBJLoadMode modes[] = {OBJ_LOAD_STREAM, OBJ_LOAD_MAPPED, OBJ_LOAD_PARALLEL};
+    for(int mode=0; mode<3; mode++)
+    {
+        for(int prescan=0; prescan<2; prescan++)
+        {
+            GeometryData geometry;
+            CHECK(loadText(string(squareVertices) + "f 1 2 3\nf 1 3 4\n", geometry, modes[mode], prescan) &&
+                  isSquare(geometry));
+
+            // relative indices count back from the records read so far, so the fourth vertex coming
+            // after the first face changes what -1 means
+            GeometryData relative;
+            CHECK(loadText("v 0 0 0\nv 1 0 0\nv 1 1 0\nf -3 -2 -1\nv 0 1 0\nf -4 -2 -1\n", relative, modes[mode],
+                           prescan) && isSquare(relative));
+            GeometryData mixed;
+            CHECK(loadText(string(squareVertices) + "f 1 -3 3\nf -4 3 4\n", mixed, modes[mode], prescan) &&
+                  isSquare(mixed));
+
+            // corners are shared only when every index matches, so the second use of vertex 1 with
+            // another texture coord is a vertex of its own
+            GeometryData textured;
+            CHECK(loadText(string(squareVertices) + "vt 0 0\nvt 1 1\nf 1/1 2/1 3/1\nf 1/2 3/1 4/1\n", textured,
+                           modes[mode], prescan));
+            CHECK((textured.vertexCount() == 5) && (textured.indexCount() == 6) && textured.hasTextureCoords());
+            if((textured.vertexCount() == 5) && (textured.indexCount() == 6))
+            {
+                const unsigned int* indices = (const unsigned int*)textured.indexData();
+                const float* texCoords = (const float*)textured.textureCoordData();
+                CHECK((indices[2] == indices[4]) && (indices[0] != indices[3]));
+                CHECK((texCoords[indices[0]*2] == 0.0f) && (texCoords[indices[3]*2] == 1.0f));
+                CHECK(memcmp((const float*)textured.vertexData() + indices[3]*3, squarePositions, 3*sizeof(float)) == 0);
+            }
+
+            // every one of these refers to a record that doesn't exist, and has to leave the mesh that
+            // was already loaded alone
+            const char* badFaces[] = {"f 1 2 5\n", "f 0 1 2\n", "f -5 1 2\n", "f 1 2 4294967297\n",
+                                      "f 1 2 99999999999999999999\n", "f 1/1 2/1 3/1\n", "f 1//2 2//1 3//1\n"};
+            for(int bad=0; bad<7; bad++)
+            {
+                string contents = string(squareVertices) + "vn 0 0 1\nf 1 2 3\n" + badFaces[bad];
+                CHECK(!loadText(contents, geometry, modes[mode], prescan));
+                CHECK(isSquare(geometry));
+            }
+        }
+    }
+
+    // the streamed vertices are the faces' corners in order, whatever the block size
+    const size_t blockSizes[] = {1, 40, 1024*1024};
+    for(int size=0; size<3; size++)
+    {
+        CollectingSink sink;
+        CHECK(streamText(string(squareVertices) + "f 1 2 3\nf -4 -2 -1\n", sink, blockSizes[size]));
+        CHECK((sink.totalVertexCount == 6) && (sink.floatsPerVertex == 3) && sink.inOrder);
+        CHECK(sink.vertexData.size() == 18);
+        for(size_t corner=0; (corner < 6) && (sink.vertexData.size() == 18); corner++)
+        {
+            CHECK(memcmp(&sink.vertexData[corner*3], squarePositions + squareIndices[corner]*3, 3*sizeof(float)) == 0);
+        }
+
+        // the stream can't look ahead, so a face may only use records that come before it
+        CollectingSink forward;
+        CHECK(!streamText("v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 3\nf 1 3 4\nv 0 1 0\n", forward, blockSizes[size]));
+        CollectingSink outOfRange;
+        CHECK(!streamText(string(squareVertices) + "f 1 2 3\nf 1 3 5\n", outOfRange, blockSizes[size]));
+    }
+}
+
+static bool floatsAgree(const string& text)
+{
+    const char* begin = text.c_str();
+    const char* end = begin + text.size();
+    float fast = 0.0f, reference = 0.0f;
+    const char* fastEnd = parseOBJFloat(begin, end, &fast);
+    const char* referenceEnd = parseOBJFloatReference(begin, end, &reference);
+    char* strtofEnd = 0;
+    float expected = strtof(begin, &strtofEnd);
+    bool agree = (fastEnd == strtofEnd) && (referenceEnd == strtofEnd) &&
+                 (memcmp(&fast, &expected, sizeof(float)) == 0) && (memcmp(&reference, &expected, sizeof(float)) == 0);
+    if(!agree)
+    {
+        printf("parseOBJFloat(\"%s\") gave %.9g, strtof %.9g\n", begin, fast, expected);
+    }
+    return agree;
+}
+
+static bool intsAgree(const string& text)
+{
+    const char* begin = text.c_str();
+    const char* end = begin + text.size();
+    int fast = 0, reference = 0;
+    const char* fastEnd = parseOBJInt(begin, end, &fast);
+    const char* referenceEnd = parseOBJIntReference(begin, end, &reference);
+    return (fastEnd == referenceEnd) && (fast == reference) && (fast == (int)strtol(begin, 0, 10));
+}
+
+void testNumberParsing()
+{
+    // exact powers of ten, the float limits, denormals, and values that sit right on or next to a
+    // halfway point between two floats, where rounding too early goes wrong
+    const char* floats[] = {"0", "-0", "1", "-1", "0.5", "0.1", "3.14159265", "-2.5E+3", "1e10", "1.5e-7",
+                            "0.000001", "123456789", "16777216", "16777217", "16777219", "0.30000001192092896",
+                            "3.4028234e38", "3.4028235e38", "1.17549435e-38", "1.4e-45", "7.038531e-26",
+                            "1.00000005960464477539", "1.000000059604644775391", "0.999999970197677612305",
+                            "8388608.5", "8388609.5", "4.9999999e-1", "100000000000000000000000000000",
+                            "0.0000000000000000000000000000001", "1.", ".5", "-.5e1", "1e", "5e+", "00001.2500"};
+    for(size_t text=0; text<sizeof(floats)/sizeof(floats[0]); text++)
+    {
+        CHECK(floatsAgree(floats[text]));
+    }
+
+    // and a spread of the kind of numbers OBJ exporters write, some with more digits than a float holds
+    mt19937 random(2);
+    int mismatches = 0;
+    for(int test=0; test<100000; test++)
+    {
+        ostringstream text;
+        if(random() % 2)
+        {
+            text << "-";
+        }
+        text << random() % 100000;
+        if(random() % 4)
+        {
+            text << "." << random() % 1000000000;
+        }
+        if(random() % 4 == 0)
+        {
+            text << "e" << (int)(random() % 80) - 40;
+        }
+        mismatches += floatsAgree(text.str()) ? 0 : 1;
+        mismatches += intsAgree(text.str()) ? 0 : 1;
+    }
+    CHECK(mismatches == 0);
+
+    const char* ints[] = {"0", "-0", "7", "-12", "2147483647", "-2147483647", "0012"};
+    for(size_t text=0; text<sizeof(ints)/sizeof(ints[0]); text++)
+    {
+        CHECK(intsAgree(ints[text]));
+    }
+}
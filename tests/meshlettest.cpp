@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <random>
+#include <math.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace std;
+
+#include "meshoptimize.h"
+#include "meshlets.h"
+#include "meshcull.h"
+#include "testutil.h"
+
+void testMeshlets()
+{
+    vector<float> positions;
+    vector<unsigned int> original;
+    buildGrid(64, true, true, positions, original);
+    size_t indexCount = original.size(), vertexCount = positions.size() / 3;
+
+    vector<unsigned int> indices = original;
+    optimizeVertexCache(&indices[0], indexCount, vertexCount);
+    vector<uint32_t> tableData;
+    size_t meshletCount = buildMeshlets(&indices[0], indexCount, &positions[0], vertexCount, tableData);
+    MeshletTable table = meshletTable(&tableData[0], meshletCount);
+    CHECK((meshletCount >= indexCount / 3 / maxMeshletTriangles) && (table.count == meshletCount));
+    CHECK((table.paddedCount % meshletTableAlignment == 0) && (table.paddedCount >= meshletCount));
+
+    // every triangle lands in exactly one meshlet: the meshlets' ranges follow on from each other and
+    // between them hold the triangles the mesh started with
+    CHECK(sortedTriangles(&indices[0], indexCount) == sortedTriangles(&original[0], indexCount));
+    size_t nextIndex = 0;
+    bool withinLimits = true, countsMatch = true, insideSpheres = true;
+    for(size_t meshlet=0; meshlet<meshletCount; meshlet++)
+    {
+        CHECK(table.firstIndex[meshlet] == nextIndex);
+        nextIndex = table.firstIndex[meshlet] + table.indexCount[meshlet];
+        if(nextIndex > indexCount)
+        {
+            break;
+        }
+
+        vector<unsigned int> used(indices.begin() + table.firstIndex[meshlet], indices.begin() + nextIndex);
+        sort(used.begin(), used.end());
+        used.erase(unique(used.begin(), used.end()), used.end());
+        withinLimits = withinLimits && (table.indexCount[meshlet] % 3 == 0) && (table.indexCount[meshlet] > 0) &&
+                       (table.indexCount[meshlet] / 3 <= maxMeshletTriangles) &&
+                       (table.vertexCount[meshlet] <= maxMeshletVertices);
+        countsMatch = countsMatch && (used.size() == table.vertexCount[meshlet]);
+
+        for(size_t vertex=0; vertex<used.size(); vertex++)
+        {
+            const float* position = &positions[used[vertex]*3];
+            float dx = position[0] - table.centreX[meshlet];
+            float dy = position[1] - table.centreY[meshlet];
+            float dz = position[2] - table.centreZ[meshlet];
+            insideSpheres = insideSpheres && (sqrtf(dx*dx + dy*dy + dz*dz) <= table.radius[meshlet] * 1.0001f + 1e-5f);
+        }
+    }
+    CHECK(nextIndex == indexCount);
+    CHECK(withinLimits);
+    CHECK(countsMatch);
+    CHECK(insideSpheres);
+
+    // too few indices for a triangle is no meshlets at all
+    vector<uint32_t> emptyTable(1, 7u);
+    CHECK((buildMeshlets(&indices[0], 2, &positions[0], vertexCount, emptyTable) == 0) && emptyTable.empty());
+}
+
+// Whether every triangle of the meshlet faces away from the camera (the grid winds counterclockwise)
+static bool facesAway(const MeshletTable& table, size_t meshlet, const vector<unsigned int>& indices,
+                      const vector<float>& positions, const glm::vec3& camera)
+{
+    for(size_t index=table.firstIndex[meshlet]; index<table.firstIndex[meshlet] + table.indexCount[meshlet]; index+=3)
+    {
+        glm::vec3 a(positions[indices[index]*3], positions[indices[index]*3 + 1], positions[indices[index]*3 + 2]);
+        glm::vec3 b(positions[indices[index + 1]*3], positions[indices[index + 1]*3 + 1], positions[indices[index + 1]*3 + 2]);
+        glm::vec3 c(positions[indices[index + 2]*3], positions[indices[index + 2]*3 + 1], positions[indices[index + 2]*3 + 2]);
+        if(glm::dot(glm::cross(b - a, c - a), a - camera) < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testMeshletCulling()
+{
+    const int size = 64;
+    vector<float> positions;
+    vector<unsigned int> indices;
+    buildGrid(size, false, true, positions, indices);
+    size_t vertexCount = positions.size() / 3;
+    optimizeVertexCache(&indices[0], indices.size(), vertexCount);
+    vector<uint32_t> tableData;
+    size_t meshletCount = buildMeshlets(&indices[0], indices.size(), &positions[0], vertexCount, tableData);
+    MeshletTable table = meshletTable(&tableData[0], meshletCount);
+
+    // cameras all around the grid, above and below it, near and far, looking at points on it
+    glm::vec3 centre(size * 0.5f, size * 0.5f, 0.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, size * 4.0f);
+    mt19937 random(3);
+    uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    vector<uint32_t> visible(meshletCount), reference(meshletCount), frustumOnly(meshletCount);
+    int mismatches = 0, coneCulls = 0, wrongConeCulls = 0, frustumCulls = 0;
+    for(int camera=0; camera<200; camera++)
+    {
+        glm::vec3 eye = centre + glm::vec3(unit(random), unit(random), unit(random)) * (float)size;
+        glm::vec3 target = centre + glm::vec3(unit(random), unit(random), 0.0f) * (size * 0.5f);
+        glm::mat4 mvp = projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+        FrustumPlanes frustum = extractFrustumPlanes(&mvp[0][0]);
+        float cameraPosition[3] = {eye.x, eye.y, eye.z};
+
+        size_t frustumCount = cullMeshlets(table, frustum, 0, &frustumOnly[0]);
+        size_t referenceCount = cullMeshletsReference(table, frustum, 0, &reference[0]);
+        mismatches += ((frustumCount != referenceCount) ||
+                       !equal(frustumOnly.begin(), frustumOnly.begin() + frustumCount, reference.begin())) ? 1 : 0;
+
+        size_t visibleCount = cullMeshlets(table, frustum, cameraPosition, &visible[0]);
+        referenceCount = cullMeshletsReference(table, frustum, cameraPosition, &reference[0]);
+        mismatches += ((visibleCount != referenceCount) ||
+                       !equal(visible.begin(), visible.begin() + visibleCount, reference.begin())) ? 1 : 0;
+
+        // the cones only ever drop meshlets the frustum kept, and only ones that really face away
+        frustumCulls += meshletCount - frustumCount;
+        for(size_t kept=0, next=0; kept<frustumCount; kept++)
+        {
+            if((next < visibleCount) && (visible[next] == frustumOnly[kept]))
+            {
+                next++;
+                continue;
+            }
+            coneCulls++;
+            wrongConeCulls += facesAway(table, frustumOnly[kept], indices, positions, eye) ? 0 : 1;
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(wrongConeCulls == 0);
+
+    // and between them the random cameras exercise both tests
+    CHECK((frustumCulls > 0) && (coneCulls > 0));
+}
@@ -0,0 +1,165 @@
+#include <map>
+#include <math.h>
+#include <string.h>
+
+using namespace std;
+
+#include "meshoptimize.h"
+#include "meshsimplify.h"
+#include "testutil.h"
+
+void testMeshOptimization()
+{
+    vector<float> positions;
+    vector<unsigned int> original;
+    buildGrid(48, false, true, positions, original);
+    size_t indexCount = original.size(), vertexCount = positions.size() / 3;
+
+    // the same triangles, each still wound the same way, just in a better order
+    vector<unsigned int> indices = original;
+    optimizeVertexCache(&indices[0], indexCount, vertexCount);
+    CHECK(sortedTriangles(&indices[0], indexCount) == sortedTriangles(&original[0], indexCount));
+    float shuffledACMR = analyzeVertexCache(&original[0], indexCount, vertexCount).acmr;
+    float optimizedACMR = analyzeVertexCache(&indices[0], indexCount, vertexCount).acmr;
+    CHECK(optimizedACMR < shuffledACMR * 0.5f);
+    CHECK(optimizedACMR < 1.0f);
+
+    vector<unsigned int> overdrawIndices = indices;
+    CHECK(optimizeOverdraw(&overdrawIndices[0], indexCount, &positions[0], vertexCount) > 0);
+    CHECK(sortedTriangles(&overdrawIndices[0], indexCount) == sortedTriangles(&original[0], indexCount));
+    CHECK(analyzeVertexCache(&overdrawIndices[0], indexCount, vertexCount).acmr <= optimizedACMR * 1.05f);
+
+    // remapping for fetch order leaves every corner where it was, and drops a vertex nothing uses
+    vector<float> withUnused = positions;
+    withUnused.push_back(-1.0f);
+    withUnused.push_back(-1.0f);
+    withUnused.push_back(-1.0f);
+    vector<unsigned int> remap(vertexCount + 1);
+    size_t remappedCount = buildVertexFetchRemap(&indices[0], indexCount, vertexCount + 1, &remap[0]);
+    CHECK(remappedCount == vertexCount);
+    CHECK(remap[vertexCount] == unusedVertex);
+
+    vector<unsigned int> remapped = indices;
+    remapIndices(&remapped[0], indexCount, &remap[0]);
+    vector<float> remappedPositions(remappedCount * 3);
+    remapVertexStream(&remappedPositions[0], &withUnused[0], vertexCount + 1, 3, &remap[0]);
+    bool samePositions = true;
+    unsigned int nextNewVertex = 0;
+    bool firstUseOrder = true;
+    for(size_t index=0; index<indexCount; index++)
+    {
+        samePositions = samePositions && (remapped[index] < remappedCount) &&
+                        (memcmp(&remappedPositions[remapped[index]*3], &positions[indices[index]*3], 3*sizeof(float)) == 0);
+        if(remapped[index] >= nextNewVertex)
+        {
+            firstUseOrder = firstUseOrder && (remapped[index] == nextNewVertex);
+            nextNewVertex++;
+        }
+    }
+    CHECK(samePositions);
+    CHECK(firstUseOrder);
+}
+
+// NOTE: Vertices that share a position are welded together (which joins the two sides of the grid's
+//       seam) and every edge is counted. On the welded grid, only the outside edge of the square may be
+//       used by a single triangle; a seam that opened up or a border that was pulled in would show up
+//       as one of those somewhere else, and a border that was cut across at a corner as a shorter one
+static bool bordersClosed(const unsigned int* indices, size_t indexCount, const float* positions, int size)
+{
+    map<vector<float>, unsigned int> welded;
+    vector<unsigned int> weldedIndices(indexCount);
+    for(size_t index=0; index<indexCount; index++)
+    {
+        vector<float> position(positions + indices[index]*3, positions + indices[index]*3 + 3);
+        weldedIndices[index] = welded.insert(make_pair(position, (unsigned int)welded.size())).first->second;
+    }
+    vector<vector<float> > weldedPositions(welded.size());
+    for(map<vector<float>, unsigned int>::iterator vertex=welded.begin(); vertex!=welded.end(); ++vertex)
+    {
+        weldedPositions[vertex->second] = vertex->first;
+    }
+
+    map<pair<unsigned int, unsigned int>, int> edgeUses;
+    for(size_t index=0; index<indexCount; index+=3)
+    {
+        for(int corner=0; corner<3; corner++)
+        {
+            unsigned int from = weldedIndices[index + corner], to = weldedIndices[index + (corner + 1) % 3];
+            if(from == to)
+            {
+                return false;
+            }
+            edgeUses[make_pair(min(from, to), max(from, to))]++;
+        }
+    }
+
+    double borderLength = 0.0;
+    for(map<pair<unsigned int, unsigned int>, int>::iterator edge=edgeUses.begin(); edge!=edgeUses.end(); ++edge)
+    {
+        if(edge->second > 2)
+        {
+            return false;
+        }
+        if(edge->second == 1)
+        {
+            const vector<float>& from = weldedPositions[edge->first.first];
+            const vector<float>& to = weldedPositions[edge->first.second];
+            // both ends on the same side of the square
+            bool alongSide = ((from[0] == to[0]) && ((from[0] == 0.0f) || (from[0] == (float)size))) ||
+                             ((from[1] == to[1]) && ((from[1] == 0.0f) || (from[1] == (float)size)));
+            if(!alongSide)
+            {
+                return false;
+            }
+            borderLength += fabs(to[0] - from[0]) + fabs(to[1] - from[1]);
+        }
+    }
+    return fabs(borderLength - 4.0 * size) < 1e-3;
+}
+
+void testMeshSimplification()
+{
+    const int size = 40;
+    vector<float> positions;
+    vector<unsigned int> indices;
+    buildGrid(size, true, true, positions, indices);
+    size_t vertexCount = positions.size() / 3;
+    CHECK(bordersClosed(&indices[0], indices.size(), &positions[0], size));
+
+    // down far enough that the border and seam vertices have to go too
+    const int levelCount = 5;
+    const float ratios[levelCount] = {0.5f, 0.25f, 0.1f, 0.03f, 0.01f};
+    vector<unsigned int> lodIndices;
+    MeshLOD levels[levelCount];
+    simplifyMeshLODs(&indices[0], indices.size(), &positions[0], vertexCount, ratios, levelCount, lodIndices, levels);
+
+    size_t previousCount = indices.size();
+    float previousError = 0.0f;
+    for(int level=0; level<levelCount; level++)
+    {
+        CHECK(levels[level].firstIndex + levels[level].indexCount <= lodIndices.size());
+        if(levels[level].firstIndex + levels[level].indexCount > lodIndices.size())
+        {
+            return;
+        }
+        const unsigned int* levelIndices = &lodIndices[levels[level].firstIndex];
+        size_t levelIndexCount = levels[level].indexCount;
+
+        CHECK((levelIndexCount % 3 == 0) && (levelIndexCount > 0) && (levelIndexCount < previousCount));
+        CHECK(levels[level].error >= previousError);
+        previousCount = levelIndexCount;
+        previousError = levels[level].error;
+
+        bool existingVertices = true;
+        for(size_t index=0; index<levelIndexCount; index++)
+        {
+            existingVertices = existingVertices && (levelIndices[index] < vertexCount);
+        }
+        CHECK(existingVertices);
+        if(existingVertices)
+        {
+            CHECK(bordersClosed(levelIndices, levelIndexCount, &positions[0], size));
+        }
+    }
+    CHECK(previousCount <= indices.size() / 4);
+}
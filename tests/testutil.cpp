@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <math.h>
+
+using namespace std;
+
+#include "testutil.h"
+
+static int failureCount = 0;
+static string scratchDirectory = ".";
+
+bool checkCondition(bool passed, const char* expression, const char* file, int line)
+{
+    if(!passed)
+    {
+        cout << file << ":" << line << ": CHECK(" << expression << ") failed" << endl;
+        failureCount++;
+    }
+    return passed;
+}
+
+int checkFailureCount()
+{
+    return failureCount;
+}
+
+void setScratchDirectory(const string& directory)
+{
+    scratchDirectory = directory;
+}
+
+string scratchPath(const string& name)
+{
+    return scratchDirectory + "/" + name;
+}
+
+void writeTextFile(const string& path, const string& contents)
+{
+    ofstream outStream(path.c_str(), ofstream::out | ofstream::binary | ofstream::trunc);
+    outStream << contents;
+}
+
+void buildGrid(int size, bool seam, bool shuffle, vector<float>& positions, vector<unsigned int>& indices)
+{
+    int rowLength = size + 1;
+    positions.clear();
+    for(int row=0; row<=size; row++)
+    {
+        for(int column=0; column<=size; column++)
+        {
+            float x = (float)column, y = (float)row;
+            positions.push_back(x);
+            positions.push_back(y);
+            positions.push_back(0.5f * sinf(x * 0.4f) * cosf(y * 0.3f));
+        }
+    }
+
+    int seamColumn = size / 2;
+    unsigned int seamFirst = positions.size() / 3;
+    if(seam)
+    {
+        for(int row=0; row<=size; row++)
+        {
+            unsigned int original = row*rowLength + seamColumn;
+            positions.insert(positions.end(), positions.begin() + original*3, positions.begin() + original*3 + 3);
+        }
+    }
+
+    indices.clear();
+    for(int row=0; row<size; row++)
+    {
+        for(int column=0; column<size; column++)
+        {
+            unsigned int corners[4] = {(unsigned int)(row*rowLength + column), (unsigned int)(row*rowLength + column + 1),
+                                       (unsigned int)((row + 1)*rowLength + column + 1),
+                                       (unsigned int)((row + 1)*rowLength + column)};
+            if(seam && (column == seamColumn))
+            {
+                // the right half's copies of the seam column
+                corners[0] = seamFirst + row;
+                corners[3] = seamFirst + row + 1;
+            }
+            unsigned int quad[6] = {corners[0], corners[1], corners[2], corners[0], corners[2], corners[3]};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    if(shuffle)
+    {
+        mt19937 random(1);
+        size_t triangleCount = indices.size() / 3;
+        for(size_t triangle=triangleCount - 1; triangle>0; triangle--)
+        {
+            size_t other = random() % (triangle + 1);
+            swap_ranges(indices.begin() + triangle*3, indices.begin() + triangle*3 + 3, indices.begin() + other*3);
+        }
+        for(size_t triangle=0; triangle<triangleCount; triangle++)
+        {
+            rotate(indices.begin() + triangle*3, indices.begin() + triangle*3 + random() % 3,
+                   indices.begin() + triangle*3 + 3);
+        }
+    }
+}
+
+string gridOBJ(int size)
+{
+    vector<float> positions;
+    vector<unsigned int> indices;
+    buildGrid(size, false, false, positions, indices);
+
+    ostringstream text;
+    for(size_t vertex=0; vertex<positions.size()/3; vertex++)
+    {
+        text << "v " << positions[vertex*3] << " " << positions[vertex*3 + 1] << " " << positions[vertex*3 + 2] << "\n";
+    }
+    for(size_t index=0; index<indices.size(); index+=3)
+    {
+        text << "f " << indices[index] + 1 << " " << indices[index + 1] + 1 << " " << indices[index + 2] + 1 << "\n";
+    }
+    return text.str();
+}
+
+vector<array<unsigned int, 3> > sortedTriangles(const unsigned int* indices, size_t indexCount)
+{
+    vector<array<unsigned int, 3> > triangles(indexCount / 3);
+    for(size_t triangle=0; triangle<triangles.size(); triangle++)
+    {
+        const unsigned int* corners = indices + triangle*3;
+        int first = (int)(min_element(corners, corners + 3) - corners);
+        for(int corner=0; corner<3; corner++)
+        {
+            triangles[triangle][corner] = corners[(first + corner) % 3];
+        }
+    }
+    sort(triangles.begin(), triangles.end());
+    return triangles;
+}
@@ -0,0 +1,43 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+// NOTE: A failed CHECK prints the expression and where it is and carries on, so that one run reports
+//       everything that is broken. The test program exits non-zero if any of them failed
+#define CHECK(condition) checkCondition((condition), #condition, __FILE__, __LINE__)
+
+bool checkCondition(bool passed, const char* expression, const char* file, int line);
+int checkFailureCount();
+
+// Where the tests write their OBJ files and cache entries, the directory given on the command line
+void setScratchDirectory(const std::string& directory);
+std::string scratchPath(const std::string& name);
+void writeTextFile(const std::string& path, const std::string& contents);
+
+// NOTE: A gently curved size by size quad grid in the xy plane, from 0 to size on both axes, two
+//       counterclockwise triangles per quad. With a seam, the vertices of the middle column are
+//       doubled up, the left half of the grid using one copy and the right half the other, as a UV
+//       seam would leave them. With shuffle, the triangles come in a random order, each starting
+//       from a random corner
+void buildGrid(int size, bool seam, bool shuffle, std::vector<float>& positions, std::vector<unsigned int>& indices);
+
+// The grid as OBJ text, for the tests that need a file
+std::string gridOBJ(int size);
+
+// Every triangle rotated to start at its smallest index (which keeps its winding) and then sorted, so
+// that two index buffers holding the same triangles in any order compare equal
+std::vector<std::array<unsigned int, 3> > sortedTriangles(const unsigned int* indices, size_t indexCount);
+
+void testOBJLoading();
+void testNumberParsing();
+void testMeshCache();
+void testMeshOptimization();
+void testMeshSimplification();
+void testMeshlets();
+void testMeshletCulling();
+
+#endif